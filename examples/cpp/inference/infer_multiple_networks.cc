@@ -124,6 +124,7 @@ int main(int argc, char** argv) {
   int input_channels = 3;
   int iteration_count = 20;
   int num_threads = 3;
+  string backend_concurrency = "";
 
   std::vector<tf::Flag> flag_list = {
       tf::Flag("image", &image_file, "image to be processed"),
@@ -148,6 +149,10 @@ int main(int argc, char** argv) {
           "batch_size", &batch_size,
           "Input bach size. The same images is copied to create the batch"),
       tf::Flag("num_threads", &num_threads, "Number of threads to use."),
+      tf::Flag("backend_concurrency", &backend_concurrency,
+               "Concurrency of the backend executables: reentrant, "
+               "per_executable or global. Uses the backend's default if "
+               "not set"),
   };
 
   string usage = tensorflow::Flags::Usage(argv[0], flag_list);
@@ -189,6 +194,21 @@ int main(int argc, char** argv) {
     backend_name = std::getenv("NGRAPH_TF_BACKEND");
   }
 
+  // The backend is created with the sessions and reads its concurrency then
+  if (!backend_concurrency.empty()) {
+    tf::ngraph_bridge::BackendConcurrency concurrency;
+    TF_CHECK_OK(tf::ngraph_bridge::BackendManager::ParseBackendConcurrency(
+        backend_concurrency, &concurrency));
+    string backend_type =
+        tf::ngraph_bridge::BackendManager::GetBackendAttributeValues(
+            backend_name)["ngraph_backend"];
+    setenv("NGRAPH_TF_BACKEND_CONCURRENCY",
+           (backend_type + "=" + backend_concurrency).c_str(), 1);
+  }
+  cout << "Backend concurrency: "
+       << (backend_concurrency.empty() ? "default" : backend_concurrency)
+       << endl;
+
   //
   // Create the sessions
   //
@@ -378,6 +398,11 @@ int main(int argc, char** argv) {
 
   benchmark_timer.Stop();
   cout << "Total time: " << benchmark_timer.ElapsedInMS() << " ms\n";
+  // Run with increasing num_threads to see how the inferences scale
+  cout << "Threads: " << num_threads << " Throughput: "
+       << (num_threads * iteration_count * batch_size * 1000.0 /
+           benchmark_timer.ElapsedInMS())
+       << " images/sec\n";
 
   //
   // Validate the label if provided
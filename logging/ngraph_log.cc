@@ -15,6 +15,7 @@
  *******************************************************************************/
 
 #include "ngraph_log.h"
+#include <atomic>
 #include <cstdlib>
 
 using namespace std;
@@ -39,9 +40,20 @@ tensorflow::int64 LogLevelStrToInt(const char* tf_env_var_val) {
 
   return level;
 }
+
+// NGRAPH_TF_VLOG_LEVEL, parsed on first use and not at every NGRAPH_VLOG
+std::atomic<tensorflow::int64>& VLogLevel() {
+  static std::atomic<tensorflow::int64> level(
+      LogLevelStrToInt(std::getenv("NGRAPH_TF_VLOG_LEVEL")));
+  return level;
+}
 }  // namespace
 
 tensorflow::int64 NGraphLogMessage::MinNGraphVLogLevel() {
-  const char* tf_env_var_val = std::getenv("NGRAPH_TF_VLOG_LEVEL");
-  return LogLevelStrToInt(tf_env_var_val);
+  return VLogLevel().load(std::memory_order_relaxed);
+}
+
+void NGraphLogMessage::ReloadMinNGraphVLogLevel() {
+  VLogLevel().store(LogLevelStrToInt(std::getenv("NGRAPH_TF_VLOG_LEVEL")),
+                    std::memory_order_relaxed);
 }
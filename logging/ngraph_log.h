@@ -24,7 +24,10 @@
 
 class NGraphLogMessage : public tensorflow::internal::LogMessage {
  public:
+  // NGRAPH_TF_VLOG_LEVEL, read once: call ReloadMinNGraphVLogLevel after
+  // changing it
   static tensorflow::int64 MinNGraphVLogLevel();
+  static void ReloadMinNGraphVLogLevel();
 };
 
 #define NGRAPH_VLOG_IS_ON(lvl) ((lvl) <= NGraphLogMessage::MinNGraphVLogLevel())
@@ -33,6 +33,7 @@
 #include "ngraph_bridge/ngraph_enter_prefetch_in_catalog.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
 #include "ngraph_bridge/ngraph_rewrite_for_tracking.h"
+#include "ngraph_bridge/ngraph_runtime_config.h"
 #include "ngraph_bridge/ngraph_utils.h"
 
 #if defined NGRAPH_DISTRIBUTED
@@ -74,6 +75,9 @@ mutex NGraphRewritePass::s_serial_counter_mutex;
 class NGraphVariableCapturePass : public NGraphRewritePass {
  public:
   Status Run(const GraphOptimizationPassOptions& options) override {
+    // The steps of the session being created see the settings made so far
+    NGraphRuntimeConfig::Reload();
+
     // If we don't get a main graph, log that fact and bail.
     if (options.graph == nullptr) {
       NGRAPH_VLOG(0) << "NGraphVariableCapturePass: options.graph == nullptr";
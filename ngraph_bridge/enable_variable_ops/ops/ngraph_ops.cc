@@ -126,6 +126,8 @@ REGISTER_OP("NGraphVariableUpdateNGTensor")
 // // that the tensors are copied to the device if needed and possible
 // // Since the TensorFlow op doesn't hav any way to override this behavior,
 // // we have taken the "editor inheritence" approach i.e., copy->paste->modify
+// The iterator attr names the iterator node the dataset is made for, whose
+// encapsulates get the prefetched inputs
 REGISTER_OP("NGraphPrefetchDataset")
     .Input("input_dataset: variant")
     .Input("buffer_size: int64")
@@ -133,6 +135,7 @@ REGISTER_OP("NGraphPrefetchDataset")
     .Attr("output_types: list(type) >= 1")
     .Attr("output_shapes: list(shape) >= 1")
     .Attr("slack_period: int = 0")
+    .Attr("iterator: string = ''")
     .SetShapeFn([](shape_inference::InferenceContext* c) {
       shape_inference::ShapeHandle unused;
       // buffer_size should be a scalar.
@@ -15,6 +15,7 @@
  *******************************************************************************/
 
 #include <iomanip>
+#include <sstream>
 
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -28,6 +29,8 @@
 #include "ngraph_bridge/grappler/ngraph_optimizer.h"
 #include "ngraph_bridge/ngraph_backend_manager.h"
 #include "ngraph_bridge/ngraph_cluster_manager.h"
+#include "ngraph_bridge/ngraph_runtime_config.h"
+#include "ngraph_bridge/ngraph_timer.h"
 
 #if defined NGRAPH_DISTRIBUTED
 #include "ngraph/distributed.hpp"
@@ -56,7 +59,13 @@ Status NgraphOptimizer::Init(
   std::set<ShapeHintMap> shape_hints;
   // typedef std::map<std::string, std::vector<int>> ShapeHintMap;
   for (auto i : params) {
-    if (i.first != "ngraph_backend") {
+    if (i.first == "profile_file") {
+      // Placement guided by the profile of an earlier run
+      std::map<std::string, NGraphClusterTimings> profile;
+      TF_RETURN_IF_ERROR(NGraphClusterProfile::Read(i.second.s(), profile));
+      profile_cost_model.reset(new NGraphProfileCostModel(std::move(profile)));
+      NGRAPH_VLOG(3) << "Cluster profile from config: " << i.second.s();
+    } else if (i.first != "ngraph_backend") {
       // TODO: slightly hacky. The bridge reserves the right to use optional
       // attributes whose names start with shape_hint
       if (i.first.rfind("shape_hint", 0) != 0) {
@@ -95,15 +104,28 @@ Status NgraphOptimizer::Init(
 Status NgraphOptimizer::Optimize(tensorflow::grappler::Cluster* cluster,
                                  const tensorflow::grappler::GrapplerItem& item,
                                  GraphDef* output) {
+  // The steps of the session being created see the settings made so far
+  NGraphRuntimeConfig::Reload();
+
   NGRAPH_VLOG(3) << "NGTF_OPTIMIZER: Here at NgraphOptimizer ";
   NGRAPH_VLOG(5) << "NGTF_OPTIMIZER: grappler item id " << item.id;
 
+  // Wall clock time of the phases in ms, graph dumps included, in the order
+  // they ran
+  std::vector<std::pair<string, int>> phase_times;
+  Timer phase_timer;
+  auto end_phase = [&phase_times, &phase_timer](const string& phase) {
+    phase_times.emplace_back(phase, phase_timer.ElapsedInMS());
+    phase_timer = Timer();
+  };
+
   // Convert the GraphDef to Graph
   GraphConstructorOptions opts;
   opts.allow_internal_ops = true;
   opts.expect_device_spec = true;
   Graph graph(OpRegistry::Global());
   TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, item.graph, &graph));
+  end_phase("import");
 
   // For filename generation purposes, grab a fresh index. This is just an
   // arbitrary integer to avoid filename collisions resulting from subsequent
@@ -177,6 +199,7 @@ Status NgraphOptimizer::Optimize(tensorflow::grappler::Cluster* cluster,
   // has ref type as a data type then don't add IdentityN node, but the fetch
   // node will be skipped from capturing and marking for clustering.
   TF_RETURN_IF_ERROR(AddIdentityN(&graph, nodes_to_add_identity_to));
+  end_phase("add_identityn");
 
   nodes_to_preserve.insert(nodes_to_add_identity_to.begin(),
                            nodes_to_add_identity_to.end());
@@ -194,6 +217,7 @@ Status NgraphOptimizer::Optimize(tensorflow::grappler::Cluster* cluster,
   if (DumpCapturedGraphs()) {
     DumpGraphs(graph, idx, "captured", "Graph With Variables Captured");
   }
+  end_phase("capture");
 
   //
   // Encapsulation: Part that rewrites the graph for nGraph operation.
@@ -237,6 +261,7 @@ Status NgraphOptimizer::Optimize(tensorflow::grappler::Cluster* cluster,
                  << backend_creation_string;
 
   NGRAPH_VLOG(0) << "NGraph using backend: " << backend_creation_string;
+  end_phase("backend");
 
   // 1. Mark for clustering then, if requested, dump the graphs.
   TF_RETURN_IF_ERROR(
@@ -244,19 +269,23 @@ Status NgraphOptimizer::Optimize(tensorflow::grappler::Cluster* cluster,
   if (DumpMarkedGraphs()) {
     DumpGraphs(graph, idx, "marked", "Graph Marked for Clustering");
   }
+  end_phase("mark");
 
   // 2. Assign clusters then, if requested, dump the graphs.
   TF_RETURN_IF_ERROR(AssignClusters(&graph));
   if (DumpClusteredGraphs()) {
     DumpGraphs(graph, idx, "clustered", "Graph with Clusters Assigned");
   }
+  end_phase("assign");
 
-  // 3. Deassign trivial clusters then, if requested, dump the graphs.
-  TF_RETURN_IF_ERROR(DeassignClusters(&graph));
+  // 3. Deassign trivial clusters then, if requested, dump the graphs. With a
+  // profile, the clusters that ran slower than TensorFlow are deassigned too.
+  TF_RETURN_IF_ERROR(DeassignClusters(&graph, profile_cost_model.get()));
   if (DumpDeclusteredGraphs()) {
     DumpGraphs(graph, idx, "declustered",
                "Graph with Trivial Clusters De-Assigned");
   }
+  end_phase("deassign");
 
   // 4. Encapsulate clusters then, if requested, dump the graphs.
   FunctionDefLibrary* fdeflib_new = new FunctionDefLibrary();
@@ -266,6 +295,7 @@ Status NgraphOptimizer::Optimize(tensorflow::grappler::Cluster* cluster,
   if (DumpEncapsulatedGraphs()) {
     DumpGraphs(graph, idx, "encapsulated", "Graph with Clusters Encapsulated");
   }
+  end_phase("encapsulate");
 
   // Rewrite for tracking then, if requested, dump the graphs.
   TF_RETURN_IF_ERROR(RewriteForTracking(&graph, idx));
@@ -273,9 +303,25 @@ Status NgraphOptimizer::Optimize(tensorflow::grappler::Cluster* cluster,
     DumpGraphs(graph, idx, "tracked",
                "Graph with Variables Rewritten for Tracking");
   }
+  end_phase("track");
 
   // Convert the graph back to Graphdef
   graph.ToGraphDef(output);
+  end_phase("export");
+
+  std::stringstream phase_summary;
+  int total_ms = 0;
+  for (const auto& phase_time : phase_times) {
+    phase_summary << phase_time.first << " " << phase_time.second << " ms, ";
+    total_ms += phase_time.second;
+  }
+  phase_summary << "total " << total_ms << " ms";
+  NGRAPH_VLOG(1) << "NGTF_OPTIMIZER: Phase times of graph " << idx << ": "
+                 << phase_summary.str();
+  if (config::IsLoggingPlacement()) {
+    std::cout << "NGTF_SUMMARY: Optimizer phase times: " << phase_summary.str()
+              << "\n";
+  }
   // According to the doc, the message takes ownership of the allocated object
   // https://developers.google.com/protocol-buffers/docs/reference/cpp-generated#proto3_string
   // Hence no need to free fdeflib_new
@@ -31,6 +31,7 @@
 #include "ngraph_bridge/ngraph_api.h"
 #include "ngraph_bridge/ngraph_assign_clusters.h"
 #include "ngraph_bridge/ngraph_capture_variables.h"
+#include "ngraph_bridge/ngraph_cluster_profile.h"
 #include "ngraph_bridge/ngraph_deassign_clusters.h"
 #include "ngraph_bridge/ngraph_encapsulate_clusters.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
@@ -76,6 +77,8 @@ class NgraphOptimizer : public tensorflow::grappler::CustomGraphOptimizer {
   std::string config_device_id;
   std::unordered_map<std::string, std::string> config_map;
   std::vector<string> compulsory_attrs = {"ngraph_backend", "device_id"};
+  // Set by the optional profile_file attribute
+  std::unique_ptr<NGraphProfileCostModel> profile_cost_model;
 
   void DumpGraphs(Graph&, int, std::string, std::string);
 
@@ -15,6 +15,7 @@
  *******************************************************************************/
 
 #include "ngraph_bridge/ngraph_api.h"
+#include "ngraph_bridge/ngraph_runtime_config.h"
 
 namespace ng = ngraph;
 
@@ -72,6 +73,8 @@ extern void ngraph_set_disabled_ops(const char* op_type_list) {
 extern const char* ngraph_get_disabled_ops() {
   return ng::join(GetDisabledOps(), ",").c_str();
 }
+
+void ngraph_reload_runtime_config() { ReloadRuntimeConfig(); }
 }
 
 // note that TensorFlow always uses camel case for the C++ API, but not for
@@ -119,6 +122,8 @@ void SetDisabledOps(set<string> disabled_ops_set) {
   disabled_op_types = disabled_ops_set;
 }
 
+void ReloadRuntimeConfig() { NGraphRuntimeConfig::Reload(); }
+
 }  // namespace config
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
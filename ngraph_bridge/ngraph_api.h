@@ -47,6 +47,8 @@ extern bool ngraph_is_logging_placement();
 
 extern void ngraph_set_disabled_ops(const char* op_type_list);
 extern const char* ngraph_get_disabled_ops();
+
+extern void ngraph_reload_runtime_config();
 }
 
 extern void Enable();
@@ -67,6 +69,10 @@ extern bool IsLoggingPlacement();
 extern std::set<string> GetDisabledOps();
 extern void SetDisabledOps(std::set<string>);
 extern void SetDisabledOps(string);
+
+// Rereads the environment settings of NGraphRuntimeConfig and the NGRAPH_VLOG
+// level, which are otherwise read when a graph is rewritten
+extern void ReloadRuntimeConfig();
 }  // namespace config
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
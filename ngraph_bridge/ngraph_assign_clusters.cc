@@ -93,6 +93,8 @@ struct Cluster {
   int index;
   std::set<tensorflow::Node*> nodes;
   std::string backend;
+  // Number of merges done when this cluster last changed
+  int64 merged_at = 0;
 #if !defined(NGRAPH_TF_DISABLE_DEADNESS_CHECK)
   std::string predicate_string;
   std::set<const Edge*> outgoing_edges;
@@ -182,7 +184,7 @@ Status CanContractEdgeDeadnessCheck(
   // when, all outputs of the src cluster (other than the current edge) have the
   // predicate Y
   if (DeadnessAnalysis::IsTruePredString(src_predicate)) {
-    auto src_cluster_out_edges = cluster_map.at(src)->outgoing_edges;
+    const auto& src_cluster_out_edges = cluster_map.at(src)->outgoing_edges;
     bool found_same_out_preds = true;
     std::string pred_check = dst_predicate;
 
@@ -435,7 +437,6 @@ Status AssignClusters(Graph* graph) {
   }
 
   NGRAPH_VLOG(2) << "Starting contraction";
-  bool changed;
   bool collect_non_contracting_edge_info = false;  // Must init with false
 
   // 7 exhaustive reasons why edges might non contract
@@ -468,144 +469,226 @@ Status AssignClusters(Graph* graph) {
   std::unordered_map<std::string, tuple<string, string, vector<string>>>
       deadness_info;
 
-  do {
-    changed = false;
-
-    auto log_reason = [](EdgeNonContractionReasons reason, Edge* edge) {
-      NGRAPH_VLOG(0) << "NONCONTRACTION: " << reason_string[reason] << ": "
-                     << edge->src()->name() << "<" << edge->src()->type_string()
-                     << ">"
-                     << "[" << edge->src_output() << "] -> "
-                     << edge->dst()->name() << "<" << edge->dst()->type_string()
-                     << ">"
-                     << "[" << edge->dst_input() << "]";
-    };
+  auto log_reason = [](EdgeNonContractionReasons reason, Edge* edge) {
+    NGRAPH_VLOG(0) << "NONCONTRACTION: " << reason_string[reason] << ": "
+                   << edge->src()->name() << "<" << edge->src()->type_string()
+                   << ">"
+                   << "[" << edge->src_output() << "] -> "
+                   << edge->dst()->name() << "<" << edge->dst()->type_string()
+                   << ">"
+                   << "[" << edge->dst_input() << "]";
+  };
 
-    for (auto edge : graph->edges()) {
-      Node* src = edge->src();
-      Node* dst = edge->dst();
+  // Number of merges so far, a cluster records it in merged_at when it
+  // changes
+  int64 num_merges = 0;
+
+  // Tries to contract the edge. Sets contracted if it merged the clusters,
+  // and can_contract to false if the edge will never be contracted, whatever
+  // gets merged later
+  auto try_contract_edge = [&](Edge* edge, bool& contracted,
+                               bool& can_contract) -> Status {
+    contracted = false;
+    can_contract = false;
+    Node* src = edge->src();
+    Node* dst = edge->dst();
 
-      int src_index = cluster_map[src]->index;
-      int dst_index = cluster_map[dst]->index;
+    int src_index = cluster_map[src]->index;
+    int dst_index = cluster_map[dst]->index;
 
-      if (!src->IsOp() || !dst->IsOp()) {
-        if (collect_non_contracting_edge_info) {
-          log_reason(EdgeNonContractionReasons::NOTANOP, edge);
-          cluster_separation_reason[get_string_key(src_index, dst_index)]
-              .push_back(EdgeNonContractionReasons::NOTANOP);
-        }
-        continue;
+    if (!src->IsOp() || !dst->IsOp()) {
+      if (collect_non_contracting_edge_info) {
+        log_reason(EdgeNonContractionReasons::NOTANOP, edge);
+        cluster_separation_reason[get_string_key(src_index, dst_index)]
+            .push_back(EdgeNonContractionReasons::NOTANOP);
       }
+      return Status::OK();
+    }
 
-      if (!NodeIsMarkedForClustering(src) || !NodeIsMarkedForClustering(dst)) {
-        NGRAPH_VLOG(5) << "Skipping (not marked): " << src->name() << "["
-                       << edge->src_output() << "]@" << src_index << " -> "
-                       << dst->name() << "[" << edge->dst_input() << "]@"
-                       << dst_index;
-        if (collect_non_contracting_edge_info) {
-          log_reason(EdgeNonContractionReasons::UNSUPPORTED, edge);
-          cluster_separation_reason[get_string_key(src_index, dst_index)]
-              .push_back(EdgeNonContractionReasons::UNSUPPORTED);
-        }
-        continue;
+    if (!NodeIsMarkedForClustering(src) || !NodeIsMarkedForClustering(dst)) {
+      NGRAPH_VLOG(5) << "Skipping (not marked): " << src->name() << "["
+                     << edge->src_output() << "]@" << src_index << " -> "
+                     << dst->name() << "[" << edge->dst_input() << "]@"
+                     << dst_index;
+      if (collect_non_contracting_edge_info) {
+        log_reason(EdgeNonContractionReasons::UNSUPPORTED, edge);
+        cluster_separation_reason[get_string_key(src_index, dst_index)]
+            .push_back(EdgeNonContractionReasons::UNSUPPORTED);
       }
+      return Status::OK();
+    }
 
 #if !defined(NGRAPH_TF_DISABLE_DEADNESS_CHECK)
-      // check if the edge can be contracted with respect to deadness
-      bool is_deadness_ok = false;
-      TF_RETURN_IF_ERROR(
-          CanContractEdgeDeadnessCheck(edge, cluster_map, is_deadness_ok));
-      if (!is_deadness_ok) {
-        // do not contract, src and dst node cannot be in the same cluster
-        NGRAPH_VLOG(5) << "Skipping (deadness not ok): " << src->name() << "["
-                       << edge->src_output() << "]@" << src_index << " -> "
-                       << dst->name() << "[" << edge->dst_input() << "]@"
-                       << dst_index;
-        if (collect_non_contracting_edge_info) {
-          log_reason(EdgeNonContractionReasons::DEADNESS, edge);
-          cluster_separation_reason[get_string_key(src_index, dst_index)]
-              .push_back(EdgeNonContractionReasons::DEADNESS);
-
-          auto src_cluster = cluster_map[src];
-          auto dst_cluster = cluster_map[dst];
-          vector<string> neighbours_predicate;
-          // Collect predicates of src's neighbours (except dst)
-          for (const Edge* src_cluster_edge : src_cluster->outgoing_edges) {
-            if (src_cluster_edge != edge) {
-              neighbours_predicate.push_back(
-                  cluster_map[src_cluster_edge->dst()]->predicate_string);
-            }
+    // check if the edge can be contracted with respect to deadness
+    bool is_deadness_ok = false;
+    TF_RETURN_IF_ERROR(
+        CanContractEdgeDeadnessCheck(edge, cluster_map, is_deadness_ok));
+    if (!is_deadness_ok) {
+      // do not contract, src and dst node cannot be in the same cluster
+      NGRAPH_VLOG(5) << "Skipping (deadness not ok): " << src->name() << "["
+                     << edge->src_output() << "]@" << src_index << " -> "
+                     << dst->name() << "[" << edge->dst_input() << "]@"
+                     << dst_index;
+      if (collect_non_contracting_edge_info) {
+        log_reason(EdgeNonContractionReasons::DEADNESS, edge);
+        cluster_separation_reason[get_string_key(src_index, dst_index)]
+            .push_back(EdgeNonContractionReasons::DEADNESS);
+
+        auto src_cluster = cluster_map[src];
+        auto dst_cluster = cluster_map[dst];
+        vector<string> neighbours_predicate;
+        // Collect predicates of src's neighbours (except dst)
+        for (const Edge* src_cluster_edge : src_cluster->outgoing_edges) {
+          if (src_cluster_edge != edge) {
+            neighbours_predicate.push_back(
+                cluster_map[src_cluster_edge->dst()]->predicate_string);
           }
-          deadness_info[get_string_key(src_index, dst_index)] = make_tuple(
-              cluster_map.at(src)->predicate_string,
-              cluster_map.at(dst)->predicate_string, neighbours_predicate);
         }
-        continue;
+        deadness_info[get_string_key(src_index, dst_index)] = make_tuple(
+            cluster_map.at(src)->predicate_string,
+            cluster_map.at(dst)->predicate_string, neighbours_predicate);
       }
+      // The predicates may change with the clusters
+      can_contract = true;
+      return Status::OK();
+    }
 #endif
 
-      // check if the edge can be constracted with respect to backend
-      bool is_backend_ok = false;
-      TF_RETURN_IF_ERROR(
-          CanContractEdgeBackendCheck(edge, cluster_map, is_backend_ok));
-      if (!is_backend_ok) {
-        NGRAPH_VLOG(5) << "Skipping (backend not ok): " << src->name() << "["
-                       << edge->src_output() << "]@" << src_index << " -> "
-                       << dst->name() << "[" << edge->dst_input() << "]@"
-                       << dst_index;
-        if (collect_non_contracting_edge_info) {
-          log_reason(EdgeNonContractionReasons::BACKEND, edge);
-          cluster_separation_reason[get_string_key(src_index, dst_index)]
-              .push_back(EdgeNonContractionReasons::BACKEND);
-        }
-        // do not contract, src and dst node cannot be in the same cluster
-        continue;
+    // check if the edge can be constracted with respect to backend
+    bool is_backend_ok = false;
+    TF_RETURN_IF_ERROR(
+        CanContractEdgeBackendCheck(edge, cluster_map, is_backend_ok));
+    if (!is_backend_ok) {
+      NGRAPH_VLOG(5) << "Skipping (backend not ok): " << src->name() << "["
+                     << edge->src_output() << "]@" << src_index << " -> "
+                     << dst->name() << "[" << edge->dst_input() << "]@"
+                     << dst_index;
+      if (collect_non_contracting_edge_info) {
+        log_reason(EdgeNonContractionReasons::BACKEND, edge);
+        cluster_separation_reason[get_string_key(src_index, dst_index)]
+            .push_back(EdgeNonContractionReasons::BACKEND);
       }
+      // do not contract, src and dst node cannot be in the same cluster
+      return Status::OK();
+    }
 
-      // Check if contracting the edge will lead to cycles
-      // if not, MergeClusters
-      if (gc.HasEdge(src_index, dst_index) &&
-          gc.ContractEdge(src_index, dst_index)) {
-        MergeClusters(edge, cluster_map);
-        // something changed
-        changed = true;
-      } else {
-        if (collect_non_contracting_edge_info) {
-          // either static input
-          // or there exists a longer path, so contracting this edge causes
-          // cycles
-          std::vector<int32> static_inputs;
-          GetStaticInputs(dst, &static_inputs);
-          bool is_static = std::find(static_inputs.begin(), static_inputs.end(),
-                                     edge->dst_input()) != static_inputs.end();
-          bool is_not_const = src->type_string() != "Const";
-          // 3 possible reasons here:
-          // src dst lies in same cluster, so nothing to do (trivial cycle
-          // induced in graphcycles)
-          // dst has static input
-          // a longer irreducible path exists
-          auto reason = (src_index == dst_index
-                             ? EdgeNonContractionReasons::SAMECLUSTER
-                             : ((is_not_const && is_static)
-                                    ? EdgeNonContractionReasons::STATICINPUT
-                                    : EdgeNonContractionReasons::PATHEXISTS));
-          log_reason(reason, edge);
-          cluster_separation_reason[get_string_key(src_index, dst_index)]
-              .push_back(reason);
+    // Check if contracting the edge will lead to cycles
+    // if not, MergeClusters
+    if (gc.HasEdge(src_index, dst_index) &&
+        gc.ContractEdge(src_index, dst_index)) {
+#if !defined(NGRAPH_TF_DISABLE_DEADNESS_CHECK)
+      string src_predicate = cluster_map[src]->predicate_string;
+      string dst_predicate = cluster_map[dst]->predicate_string;
+#endif
+      MergeClusters(edge, cluster_map);
+      // something changed
+      contracted = true;
+      num_merges++;
+      auto merged_cluster = cluster_map[src];
+      merged_cluster->merged_at = num_merges;
+#if !defined(NGRAPH_TF_DISABLE_DEADNESS_CHECK)
+      // The deadness check of an edge also looks at the predicates of the
+      // clusters its src cluster feeds, so the clusters feeding this one
+      // have changed too if the merged predicate is a new one
+      if (merged_cluster->predicate_string != src_predicate ||
+          merged_cluster->predicate_string != dst_predicate) {
+        for (auto node : merged_cluster->nodes) {
+          for (auto in_edge : node->in_edges()) {
+            cluster_map[in_edge->src()]->merged_at = num_merges;
+          }
         }
       }
+#endif
+    } else {
+      can_contract = src_index != dst_index;
+      if (collect_non_contracting_edge_info) {
+        // either static input
+        // or there exists a longer path, so contracting this edge causes
+        // cycles
+        std::vector<int32> static_inputs;
+        GetStaticInputs(dst, &static_inputs);
+        bool is_static = std::find(static_inputs.begin(), static_inputs.end(),
+                                   edge->dst_input()) != static_inputs.end();
+        bool is_not_const = src->type_string() != "Const";
+        // 3 possible reasons here:
+        // src dst lies in same cluster, so nothing to do (trivial cycle
+        // induced in graphcycles)
+        // dst has static input
+        // a longer irreducible path exists
+        auto reason = (src_index == dst_index
+                           ? EdgeNonContractionReasons::SAMECLUSTER
+                           : ((is_not_const && is_static)
+                                  ? EdgeNonContractionReasons::STATICINPUT
+                                  : EdgeNonContractionReasons::PATHEXISTS));
+        log_reason(reason, edge);
+        cluster_separation_reason[get_string_key(src_index, dst_index)]
+            .push_back(reason);
+      }
     }
+    return Status::OK();
+  };
 
-    if (!changed && config::IsLoggingPlacement()) {
-      // This will be entered only once if logging is enabled
-      // When entered, it will force the do-while to run one last time,
-      // collecting information
-      if (!collect_non_contracting_edge_info) {
-        changed = true;
-        collect_non_contracting_edge_info = true;
+  // The edges are tried in id order, in sweeps until one merges nothing.
+  // Which clusters come out depends on that order, so it is kept, but a
+  // sweep only tries the edges whose outcome may have changed since they
+  // were last tried:
+  // - an edge that failed can only contract after its src or dst cluster
+  //   changed (or, for deadness, a cluster its src cluster feeds got a new
+  //   predicate), the backends, predicates and paths between them are the
+  //   same otherwise. So it is skipped until one of them has merged_at
+  //   past the edge's tried_at.
+  // - the edges inside a cluster, between non ops, unmarked ops or
+  //   different backends never contract and are dropped from the worklist.
+  // This gives the clusters that trying every edge in every sweep gives,
+  // while a sweep costs the size of the worklist, which shrinks as the
+  // clusters grow, and the expensive cycle checks are only redone next to a
+  // cluster that merged.
+  std::vector<Edge*> worklist;
+  worklist.reserve(graph->num_edges());
+  for (auto edge : graph->edges()) {
+    worklist.push_back(edge);
+  }
+  std::vector<int64> tried_at(graph->num_edge_ids(), -1);
+  int num_sweeps = 0;
+  int64 num_tries = 0;
+  bool changed;
+  do {
+    changed = false;
+    num_sweeps++;
+    size_t num_kept = 0;
+    for (auto edge : worklist) {
+      auto src_cluster = cluster_map[edge->src()].get();
+      auto dst_cluster = cluster_map[edge->dst()].get();
+      if (src_cluster == dst_cluster) {
+        continue;
+      }
+      if (tried_at[edge->id()] >=
+          std::max(src_cluster->merged_at, dst_cluster->merged_at)) {
+        worklist[num_kept++] = edge;
+        continue;
+      }
+      tried_at[edge->id()] = num_merges;
+      num_tries++;
+      bool contracted, can_contract;
+      TF_RETURN_IF_ERROR(try_contract_edge(edge, contracted, can_contract));
+      changed |= contracted;
+      if (can_contract) {
+        worklist[num_kept++] = edge;
       }
     }
+    worklist.resize(num_kept);
   } while (changed);
+  NGRAPH_VLOG(2) << "Contraction: " << num_merges << " merges in "
+                 << num_sweeps << " sweeps, " << num_tries << " edges tried";
+
+  if (config::IsLoggingPlacement()) {
+    // One last pass over all the edges, collecting why they did not contract
+    collect_non_contracting_edge_info = true;
+    for (auto edge : graph->edges()) {
+      bool contracted, can_contract;
+      TF_RETURN_IF_ERROR(try_contract_edge(edge, contracted, can_contract));
+    }
+  }
 
   NGRAPH_VLOG(2) << "Contraction done";
 
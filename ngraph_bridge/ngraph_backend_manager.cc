@@ -14,6 +14,10 @@
  * limitations under the License.
  *******************************************************************************/
 
+#include <cstdlib>
+
+#include "tensorflow/core/lib/hash/hash.h"
+
 #include "ngraph_bridge/ngraph_backend_manager.h"
 
 using namespace std;
@@ -63,6 +67,9 @@ Status BackendManager::CreateBackend(const string& backend_name) {
     }
     std::unique_ptr<Backend> bend = std::unique_ptr<Backend>(new Backend);
     bend->backend_ptr = std::move(bend_ptr);
+    bend->concurrency = DefaultBackendConcurrency(backend_name);
+    NGRAPH_VLOG(1) << "Backend " << backend_name << " concurrency: "
+                   << BackendConcurrencyToString(bend->concurrency);
     BackendManager::ng_backend_map_[backend_name] = std::move(bend);
     BackendManager::ref_count_each_backend_[backend_name] = 0;
   }
@@ -124,6 +131,123 @@ void BackendManager::UnlockBackend(const string& backend_name) {
   BackendManager::ng_backend_map_.at(backend_name)->backend_mutex.unlock();
 }
 
+// LockExecutable
+void BackendManager::LockExecutable(const string& backend_name,
+                                    const ng::runtime::Executable* ng_exec) {
+  Backend* backend = BackendManager::ng_backend_map_.at(backend_name).get();
+  switch (backend->concurrency) {
+    case BackendConcurrency::kReentrant:
+      break;
+    case BackendConcurrency::kPerExecutable:
+      GetExecutableMutex(backend, ng_exec).lock();
+      break;
+    case BackendConcurrency::kGlobal:
+      backend->backend_mutex.lock();
+      break;
+  }
+}
+
+// UnlockExecutable
+void BackendManager::UnlockExecutable(const string& backend_name,
+                                      const ng::runtime::Executable* ng_exec) {
+  Backend* backend = BackendManager::ng_backend_map_.at(backend_name).get();
+  switch (backend->concurrency) {
+    case BackendConcurrency::kReentrant:
+      break;
+    case BackendConcurrency::kPerExecutable:
+      GetExecutableMutex(backend, ng_exec).unlock();
+      break;
+    case BackendConcurrency::kGlobal:
+      backend->backend_mutex.unlock();
+      break;
+  }
+}
+
+mutex& BackendManager::GetExecutableMutex(
+    Backend* backend, const ng::runtime::Executable* ng_exec) {
+  // std::hash of a pointer is the pointer itself, and executables are
+  // aligned: mix all of its bits before picking a stripe
+  uintptr_t address = reinterpret_cast<uintptr_t>(ng_exec);
+  uint64 hash =
+      Hash64(reinterpret_cast<const char*>(&address), sizeof(address));
+  return backend->executable_mutexes[hash % backend->executable_mutexes.size()];
+}
+
+BackendConcurrency BackendManager::GetBackendConcurrency(
+    const string& backend_name) {
+  return BackendManager::ng_backend_map_.at(backend_name)->concurrency;
+}
+
+// Must not be called while the backend executes
+void BackendManager::SetBackendConcurrency(const string& backend_name,
+                                           BackendConcurrency concurrency) {
+  std::lock_guard<std::mutex> lock(BackendManager::ng_backend_map_mutex_);
+  BackendManager::ng_backend_map_.at(backend_name)->concurrency = concurrency;
+  NGRAPH_VLOG(1) << "Backend " << backend_name << " concurrency set to "
+                 << BackendConcurrencyToString(concurrency);
+}
+
+Status BackendManager::ParseBackendConcurrency(
+    const string& concurrency_string, BackendConcurrency* concurrency) {
+  if (concurrency_string == "reentrant") {
+    *concurrency = BackendConcurrency::kReentrant;
+  } else if (concurrency_string == "per_executable") {
+    *concurrency = BackendConcurrency::kPerExecutable;
+  } else if (concurrency_string == "global") {
+    *concurrency = BackendConcurrency::kGlobal;
+  } else {
+    return errors::InvalidArgument(
+        "Backend concurrency must be reentrant, per_executable or global, "
+        "got ",
+        concurrency_string);
+  }
+  return Status::OK();
+}
+
+string BackendManager::BackendConcurrencyToString(
+    BackendConcurrency concurrency) {
+  switch (concurrency) {
+    case BackendConcurrency::kReentrant:
+      return "reentrant";
+    case BackendConcurrency::kPerExecutable:
+      return "per_executable";
+    case BackendConcurrency::kGlobal:
+      return "global";
+  }
+  return "unknown";
+}
+
+BackendConcurrency BackendManager::DefaultBackendConcurrency(
+    const string& backend_name) {
+  string backend_type =
+      GetBackendAttributeValues(backend_name)["ngraph_backend"];
+
+  const char* concurrency_env = std::getenv("NGRAPH_TF_BACKEND_CONCURRENCY");
+  if (concurrency_env != nullptr) {
+    for (const string& entry : ng::split(concurrency_env, ';')) {
+      auto delimiter_index = entry.find('=');
+      if (delimiter_index == string::npos ||
+          entry.substr(0, delimiter_index) != backend_type) {
+        continue;
+      }
+      BackendConcurrency concurrency;
+      Status status = ParseBackendConcurrency(
+          entry.substr(delimiter_index + 1), &concurrency);
+      if (status.ok()) {
+        return concurrency;
+      }
+      NGRAPH_VLOG(0) << "NGRAPH_TF_BACKEND_CONCURRENCY: "
+                     << status.error_message();
+    }
+  }
+
+  // Executables of these backends keep their state to themselves
+  if (backend_type == "CPU" || backend_type == "INTERPRETER") {
+    return BackendConcurrency::kPerExecutable;
+  }
+  return BackendConcurrency::kGlobal;
+}
+
 // Returns the nGraph supported backend names
 vector<string> BackendManager::GetSupportedBackendNames() {
   return ng::runtime::BackendManager::get_registered_backends();
@@ -20,6 +20,7 @@
 #ifndef NGRAPH_TF_BRIDGE_BACKEND_MANAGER_H_
 #define NGRAPH_TF_BRIDGE_BACKEND_MANAGER_H_
 
+#include <array>
 #include <atomic>
 #include <mutex>
 #include <ostream>
@@ -39,9 +40,28 @@ namespace tensorflow {
 
 namespace ngraph_bridge {
 
+// Forward declaration for friend class
+namespace testing {
+class BackendManager_ExecutableMutexStripes_Test;
+}
+
+// What Executable::call() of a backend can run concurrently with
+enum class BackendConcurrency {
+  // Any call, including calls of the same executable
+  kReentrant,
+  // Calls of the other executables, but not of the same executable
+  kPerExecutable,
+  // Nothing else on the backend, calls hold the backend lock
+  kGlobal
+};
+
 struct Backend {
   shared_ptr<ng::runtime::Backend> backend_ptr;
   mutex backend_mutex;
+  BackendConcurrency concurrency = BackendConcurrency::kGlobal;
+  // Locks for kPerExecutable, an executable uses the one its address hashes
+  // to. Striping keeps them independent of the executables' lifetime.
+  std::array<mutex, 64> executable_mutexes;
 };
 
 class BackendManager {
@@ -86,6 +106,24 @@ class BackendManager {
   // UnlockBackend
   static void UnlockBackend(const string& backend_name);
 
+  // Takes the lock, if any, that backend_name's concurrency requires around
+  // ng_exec->call(), see BackendConcurrency
+  static void LockExecutable(const string& backend_name,
+                             const ng::runtime::Executable* ng_exec);
+  static void UnlockExecutable(const string& backend_name,
+                               const ng::runtime::Executable* ng_exec);
+
+  // The concurrency of a backend is kPerExecutable for CPU and INTERPRETER
+  // and kGlobal for the others, unless overridden with
+  // NGRAPH_TF_BACKEND_CONCURRENCY=<backend>=<reentrant|per_executable|
+  // global>[;...] (by backend name, without the device id)
+  static BackendConcurrency GetBackendConcurrency(const string& backend_name);
+  static void SetBackendConcurrency(const string& backend_name,
+                                    BackendConcurrency concurrency);
+  static Status ParseBackendConcurrency(const string& concurrency_string,
+                                        BackendConcurrency* concurrency);
+  static string BackendConcurrencyToString(BackendConcurrency concurrency);
+
   // Backend Config Functions
   // These functions facilitate getting/setting
   // of additional backend configurations by abstracting the
@@ -134,6 +172,16 @@ class BackendManager {
 
   // Map of backends and their reference counts
   static std::map<std::string, int> ref_count_each_backend_;
+
+  // Concurrency of a backend when it is created
+  static BackendConcurrency DefaultBackendConcurrency(
+      const string& backend_name);
+  static mutex& GetExecutableMutex(Backend* backend,
+                                   const ng::runtime::Executable* ng_exec);
+
+  // Test class
+  friend class tensorflow::ngraph_bridge::testing::
+      BackendManager_ExecutableMutexStripes_Test;
 };
 
 }  // namespace ngraph_bridge
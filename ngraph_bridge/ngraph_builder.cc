@@ -14,6 +14,7 @@
  * limitations under the License.
  *******************************************************************************/
 
+#include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb_text.h"
@@ -42,6 +43,16 @@
 #include "ngraph/distributed.hpp"
 #endif
 
+// With SharedBuffer an nGraph Constant can be built around memory it does
+// not own. Otherwise the Constants copy their values, and the constant pool
+// is not used.
+#if defined(__has_include)
+#if __has_include("ngraph/runtime/shared_buffer.hpp")
+#include "ngraph/runtime/shared_buffer.hpp"
+#define NGRAPH_TF_SHARED_CONSTANT_BUFFERS
+#endif
+#endif
+
 using tensorflow::int32;
 using namespace std;
 namespace ng = ngraph;
@@ -325,6 +336,43 @@ static Status MakeConstOp(const Node* op, ng::element::Type et,
   return Status::OK();
 }
 
+#if defined(NGRAPH_TF_SHARED_CONSTANT_BUFFERS)
+// Helper for Builder::TranslateGraph ("Const" op with a constant pool). The
+// Constant references the value held in the pool instead of a copy of it.
+// Sets ng_node to nullptr if the value cannot be used as is (for e.g. a type
+// that nGraph stores with a different element size), MakeConstOp is used
+// then.
+static Status MakePooledConstOp(const Node* op, ng::element::Type et,
+                                NGraphConstantPool* constant_pool,
+                                std::shared_ptr<ng::Node>* ng_node) {
+  *ng_node = nullptr;
+  Tensor value;
+  TF_RETURN_IF_ERROR(constant_pool->GetTensor(op, value));
+
+  ng::Shape ng_shape;
+  TF_RETURN_IF_ERROR(TFTensorShapeToNGraphShape(value.shape(), &ng_shape));
+  if (!DataTypeCanUseMemcpy(value.dtype()) ||
+      value.TotalBytes() != ng::shape_size(ng_shape) * et.size()) {
+    return Status::OK();
+  }
+
+  // The buffer keeps a reference to the tensor, and so its memory alive
+  auto buffer = std::make_shared<ng::runtime::SharedBuffer<Tensor>>(
+      static_cast<char*>(DMAHelper::base(&value)), value.TotalBytes(), value);
+  *ng_node =
+      ConstructNgNode<ng::op::Constant>(op->name(), et, ng_shape, buffer);
+  return Status::OK();
+}
+#endif
+
+bool Builder::CanPoolConstants() {
+#if defined(NGRAPH_TF_SHARED_CONSTANT_BUFFERS)
+  return true;
+#else
+  return false;
+#endif
+}
+
 const std::map<DataType,
                std::pair<std::function<Status(const Node*, ng::element::Type,
                                               std::shared_ptr<ng::Node>*)>,
@@ -5114,10 +5162,21 @@ const static std::map<
   }
 };
 
-Status Builder::TranslateGraph(
-    const std::vector<TensorShape>& inputs,
-    const std::vector<const Tensor*>& static_input_map,
-    const Graph* input_graph, shared_ptr<ng::Function>& ng_function) {
+bool Builder::TranslationPlan::IsBuilt() {
+  mutex_lock lock(m_mutex);
+  return m_built;
+}
+
+Status Builder::BuildTranslationPlan(const Graph* input_graph,
+                                     TranslationPlan* plan) {
+  mutex_lock lock(plan->m_mutex);
+  if (plan->m_built) {
+    return Status::OK();
+  }
+  plan->m_params.clear();
+  plan->m_ops.clear();
+  plan->m_ret_vals.clear();
+
   //
   // We will visit ops in topological order.
   //
@@ -5129,10 +5188,6 @@ Status Builder::TranslateGraph(
   //
   // Split ops into params, retvals, and all others.
   //
-  vector<const Node*> tf_params;
-  vector<const Node*> tf_ret_vals;
-  vector<const Node*> tf_ops;
-
   for (const auto n : ordered) {
     if (n->IsSink() || n->IsSource()) {
       continue;
@@ -5145,11 +5200,59 @@ Status Builder::TranslateGraph(
     }
 
     if (n->type_string() == "_Arg") {
-      tf_params.push_back(n);
+      DataType dtype;
+      if (GetNodeAttr(n->attrs(), "T", &dtype) != Status::OK()) {
+        return errors::InvalidArgument("No data type defined for _Arg");
+      }
+      int index;
+      if (GetNodeAttr(n->attrs(), "index", &index) != Status::OK()) {
+        return errors::InvalidArgument("No index defined for _Arg");
+      }
+
+      ng::element::Type ng_et;
+      TF_RETURN_IF_ERROR(TFDataTypeToNGraphElementType(dtype, &ng_et));
+
+      string prov_tag;
+      GetNodeAttr(n->attrs(), "_prov_tag", &prov_tag);
+      plan->m_params.push_back({n, index, ng_et, prov_tag});
     } else if (n->type_string() == "_Retval") {
-      tf_ret_vals.push_back(n);
+      // Make sure that this _Retval only has one input node.
+      if (n->num_inputs() != 1) {
+        return errors::InvalidArgument("_Retval has ", n->num_inputs(),
+                                       " inputs, should have 1");
+      }
+
+      int index;
+      if (GetNodeAttr(n->attrs(), "index", &index) != Status::OK()) {
+        return errors::InvalidArgument("No index defined for _Retval");
+      }
+      plan->m_ret_vals.push_back({n, index});
     } else {
-      tf_ops.push_back(n);
+      TranslationPlan::Op plan_op{n, nullptr, false, ng::element::f32};
+      try {
+        plan_op.translate = &(TRANSLATE_OP_MAP.at(n->type_string()));
+      } catch (const std::out_of_range&) {
+        // -----------------------------
+        // Catch-all for unsupported ops
+        // -----------------------------
+        NGRAPH_VLOG(3) << "No translation handler registered for op: "
+                       << n->name() << " (" << n->type_string() << ")";
+        NGRAPH_VLOG(3) << n->def().DebugString();
+        return errors::InvalidArgument(
+            "No translation handler registered for op: ", n->name(), " (",
+            n->type_string(), ")\n", n->def().DebugString());
+      }
+
+      if (n->type_string() == "Const") {
+        DataType dtype;
+        TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "dtype", &dtype));
+        auto itr = Builder::TF_NGRAPH_CONST_MAP().find(dtype);
+        if (itr != Builder::TF_NGRAPH_CONST_MAP().end()) {
+          plan_op.is_poolable_const = true;
+          plan_op.const_et = itr->second.second;
+        }
+      }
+      plan->m_ops.push_back(plan_op);
 #if defined(NGRAPH_DISTRIBUTED)
       if (n->type_string().find("Horovod") == 0) {
         int rank_id;
@@ -5160,6 +5263,25 @@ Status Builder::TranslateGraph(
     }
   }
 
+  plan->m_built = true;
+  return Status::OK();
+}
+
+Status Builder::TranslateGraph(
+    const std::vector<TensorShape>& inputs,
+    const std::vector<const Tensor*>& static_input_map,
+    const Graph* input_graph, shared_ptr<ng::Function>& ng_function,
+    NGraphConstantPool* constant_pool, TranslationPlan* plan) {
+  //
+  // Order the ops and resolve their handlers, unless the plan already has
+  // them from a previous translation of this graph.
+  //
+  TranslationPlan local_plan;
+  if (plan == nullptr) {
+    plan = &local_plan;
+  }
+  TF_RETURN_IF_ERROR(BuildTranslationPlan(input_graph, plan));
+
   //
   // The op map holds a mapping from TensorFlow op names (strings) to
   // vector of generated nGraph nodes.
@@ -5169,58 +5291,42 @@ Status Builder::TranslateGraph(
   //
   // Populate the parameter list, and also put parameters into the op map.
   //
-  vector<shared_ptr<ng::op::Parameter>> ng_parameter_list(tf_params.size());
-
-  for (auto parm : tf_params) {
-    DataType dtype;
-    if (GetNodeAttr(parm->attrs(), "T", &dtype) != Status::OK()) {
-      return errors::InvalidArgument("No data type defined for _Arg");
-    }
-    int index;
-    if (GetNodeAttr(parm->attrs(), "index", &index) != Status::OK()) {
-      return errors::InvalidArgument("No index defined for _Arg");
-    }
-
-    ng::element::Type ng_et;
-    TF_RETURN_IF_ERROR(TFDataTypeToNGraphElementType(dtype, &ng_et));
+  vector<shared_ptr<ng::op::Parameter>> ng_parameter_list(
+      plan->m_params.size());
 
+  for (const auto& parm : plan->m_params) {
     ng::Shape ng_shape;
-    TF_RETURN_IF_ERROR(TFTensorShapeToNGraphShape(inputs[index], &ng_shape));
+    TF_RETURN_IF_ERROR(
+        TFTensorShapeToNGraphShape(inputs[parm.index], &ng_shape));
 
-    string prov_tag;
-    GetNodeAttr(parm->attrs(), "_prov_tag", &prov_tag);
-    auto ng_param =
-        ConstructNgNode<ng::op::Parameter>(prov_tag, ng_et, ng_shape);
-    SaveNgOp(ng_op_map, parm->name(), ng_param);
-    ng_parameter_list[index] = ng_param;
+    auto ng_param = ConstructNgNode<ng::op::Parameter>(parm.prov_tag,
+                                                       parm.ng_et, ng_shape);
+    SaveNgOp(ng_op_map, parm.node->name(), ng_param);
+    ng_parameter_list[parm.index] = ng_param;
   }
 
   //
   // Now create the nGraph ops from TensorFlow ops.
   //
-  for (auto op : tf_ops) {
+  for (const auto& plan_op : plan->m_ops) {
+    const Node* op = plan_op.node;
     NGRAPH_VLOG(2) << "Constructing op " << op->name() << " which is "
                    << op->type_string();
 
-    const function<Status(const Node*, const std::vector<const Tensor*>&,
-                          Builder::OpMap&)>* op_fun;
-
-    try {
-      op_fun = &(TRANSLATE_OP_MAP.at(op->type_string()));
-    } catch (const std::out_of_range&) {
-      // -----------------------------
-      // Catch-all for unsupported ops
-      // -----------------------------
-      NGRAPH_VLOG(3) << "No translation handler registered for op: "
-                     << op->name() << " (" << op->type_string() << ")";
-      NGRAPH_VLOG(3) << op->def().DebugString();
-      return errors::InvalidArgument(
-          "No translation handler registered for op: ", op->name(), " (",
-          op->type_string(), ")\n", op->def().DebugString());
+#if defined(NGRAPH_TF_SHARED_CONSTANT_BUFFERS)
+    if (constant_pool != nullptr && plan_op.is_poolable_const) {
+      shared_ptr<ng::Node> ng_node;
+      TF_RETURN_IF_ERROR(MakePooledConstOp(op, plan_op.const_et,
+                                           constant_pool, &ng_node));
+      if (ng_node != nullptr) {
+        SaveNgOp(ng_op_map, op->name(), ng_node);
+        continue;
+      }
     }
+#endif
 
     try {
-      TF_RETURN_IF_ERROR((*op_fun)(op, static_input_map, ng_op_map));
+      TF_RETURN_IF_ERROR((*plan_op.translate)(op, static_input_map, ng_op_map));
     } catch (const std::exception& e) {
       return errors::Internal("Unhandled exception in op handler: ", op->name(),
                               " (", op->type_string(), ")\n",
@@ -5232,24 +5338,13 @@ Status Builder::TranslateGraph(
   //
   // Populate the result list.
   //
-  vector<shared_ptr<ng::Node>> ng_result_list(tf_ret_vals.size());
-
-  for (auto n : tf_ret_vals) {
-    // Make sure that this _Retval only has one input node.
-    if (n->num_inputs() != 1) {
-      return errors::InvalidArgument("_Retval has ", n->num_inputs(),
-                                     " inputs, should have 1");
-    }
-
-    int index;
-    if (GetNodeAttr(n->attrs(), "index", &index) != Status::OK()) {
-      return errors::InvalidArgument("No index defined for _Retval");
-    }
+  vector<shared_ptr<ng::Node>> ng_result_list(plan->m_ret_vals.size());
 
+  for (const auto& ret_val : plan->m_ret_vals) {
     shared_ptr<ng::Node> result;
-    TF_RETURN_IF_ERROR(GetInputNode(ng_op_map, n, 0, &result));
+    TF_RETURN_IF_ERROR(GetInputNode(ng_op_map, ret_val.node, 0, &result));
 
-    ng_result_list[index] = result;
+    ng_result_list[ret_val.index] = result;
   }
 
   //
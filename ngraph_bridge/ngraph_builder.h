@@ -16,15 +16,18 @@
 #ifndef NGRAPH_TF_BRIDGE_BUILDER_H_
 #define NGRAPH_TF_BRIDGE_BUILDER_H_
 
+#include <functional>
 #include <ostream>
 #include <vector>
 
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/mutex.h"
 
 #include "ngraph/ngraph.hpp"
 
 #include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_constant_pool.h"
 
 namespace tensorflow {
 
@@ -32,13 +35,73 @@ namespace ngraph_bridge {
 
 class Builder {
  public:
+  using OpMap = std::unordered_map<std::string,
+                                   std::vector<std::shared_ptr<ngraph::Node>>>;
+
+  using TranslateOpFunction = std::function<Status(
+      const Node*, const std::vector<const Tensor*>&, Builder::OpMap&)>;
+
+  //
+  // TranslationPlan is the part of the translation of a graph that does not
+  // depend on the input shapes: the ops in topological order, split into
+  // parameters, results and the others, the decoded attributes of the
+  // parameters and results, and the translation handler of every op.
+  //
+  // It is built by the first TranslateGraph() call it is given to and reused
+  // by the next ones, so translating the graph for another signature only
+  // redoes the construction of the nGraph nodes. A plan must only be used
+  // with the graph it was built from, and that graph must not change.
+  //
+  class TranslationPlan {
+   public:
+    bool IsBuilt();
+
+   private:
+    friend class Builder;
+
+    struct Param {
+      const Node* node;
+      int index;
+      ngraph::element::Type ng_et;
+      std::string prov_tag;
+    };
+    struct Op {
+      const Node* node;
+      const TranslateOpFunction* translate;
+      // Element type of a Const that can be built on a constant pool
+      bool is_poolable_const;
+      ngraph::element::Type const_et;
+    };
+    struct RetVal {
+      const Node* node;
+      int index;
+    };
+
+    mutex m_mutex;
+    // Set under m_mutex, the rest is not modified once it is
+    bool m_built = false;
+    std::vector<Param> m_params;
+    std::vector<Op> m_ops;
+    std::vector<RetVal> m_ret_vals;
+  };
+
+  // Translates tf_graph to an nGraph function for the given input shapes
+  // and static inputs. If constant_pool is given, the Const nodes are built
+  // on the tensors held in it, so that the functions translated from the same
+  // graph share their constants (only if CanPoolConstants(), the pool is not
+  // used otherwise). If plan is given, it is built on the first call and
+  // reused by the next ones.
   static Status TranslateGraph(
       const std::vector<TensorShape>& inputs,
       const std::vector<const Tensor*>& static_input_map, const Graph* tf_graph,
-      std::shared_ptr<ngraph::Function>& ng_function);
+      std::shared_ptr<ngraph::Function>& ng_function,
+      NGraphConstantPool* constant_pool = nullptr,
+      TranslationPlan* plan = nullptr);
 
-  using OpMap = std::unordered_map<std::string,
-                                   std::vector<std::shared_ptr<ngraph::Node>>>;
+  // True if an nGraph Constant can reference the memory of a pooled tensor.
+  // Without that every Constant would copy its value, and the pool would
+  // only add one more copy of every weight.
+  static bool CanPoolConstants();
 
   template <typename T>
   static void MakePadding(const std::string& tf_padding_type,
@@ -160,6 +223,10 @@ class Builder {
                              const std::shared_ptr<ngraph::Node> ng_node);
 
  private:
+  // Builds plan for tf_graph, unless it is already built
+  static Status BuildTranslationPlan(const Graph* tf_graph,
+                                     TranslationPlan* plan);
+
   static void ComputeScaleOffsetFolded(const uint& num_bits,
                                        const bool& unsigned_type,
                                        const bool& scaled, const int min_range,
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <cstdlib>
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_cache_budget.h"
+
+using namespace std;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+// -1 till the budget is read from the environment
+std::atomic<int64> NGraphCacheBudget::s_budget_in_bytes{-1};
+std::atomic<int64> NGraphCacheBudget::s_charged_bytes{0};
+std::atomic<int64> NGraphCacheBudget::s_shared_bytes{0};
+
+int64 NGraphCacheBudget::GetBudgetInBytes() {
+  int64 budget_in_bytes = s_budget_in_bytes;
+  if (budget_in_bytes < 0) {
+    budget_in_bytes = 0;
+    const char* budget_specified =
+        std::getenv("NGRAPH_TF_FUNCTION_CACHE_BYTE_BUDGET_MB");
+    if (budget_specified != nullptr) {
+      budget_in_bytes = atoll(budget_specified) * 1024 * 1024;
+      NGRAPH_VLOG(1) << "Executable cache budget: " << budget_specified
+                     << " MB";
+    }
+    int64 not_read = -1;
+    // Someone else might have set it in the meantime
+    if (!s_budget_in_bytes.compare_exchange_strong(not_read,
+                                                   budget_in_bytes)) {
+      budget_in_bytes = not_read;
+    }
+  }
+  return budget_in_bytes;
+}
+
+void NGraphCacheBudget::SetBudgetInBytes(int64 budget_in_bytes) {
+  s_budget_in_bytes = budget_in_bytes;
+}
+
+void NGraphCacheBudget::Charge(int64 bytes) { s_charged_bytes += bytes; }
+
+void NGraphCacheBudget::Release(int64 bytes) { s_charged_bytes -= bytes; }
+
+int64 NGraphCacheBudget::GetChargedBytes() { return s_charged_bytes; }
+
+void NGraphCacheBudget::ChargeShared(int64 bytes) { s_shared_bytes += bytes; }
+
+void NGraphCacheBudget::ReleaseShared(int64 bytes) { s_shared_bytes -= bytes; }
+
+int64 NGraphCacheBudget::GetSharedBytes() { return s_shared_bytes; }
+
+bool NGraphCacheBudget::WouldExceed(int64 bytes) {
+  int64 budget_in_bytes = GetBudgetInBytes();
+  return budget_in_bytes > 0 && s_charged_bytes + bytes > budget_in_bytes;
+}
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#ifndef NGRAPH_TF_CACHE_BUDGET_H_
+#define NGRAPH_TF_CACHE_BUDGET_H_
+#pragma once
+
+#include <atomic>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+// Process wide memory budget for the cached executables of all the
+// encapsulate ops. The budget is read from
+// NGRAPH_TF_FUNCTION_CACHE_BYTE_BUDGET_MB; when it is not set the budget is
+// unlimited and the caches are bounded by their item depth only.
+//
+// Every cache charges the bytes of the items it inserts and releases them
+// when the items are evicted. A cache that is about to insert an item while
+// the process is over budget evicts its own items first.
+//
+// Memory the caches cannot evict, like the constants shared by the
+// executables of a cluster (see NGraphConstantPool), is charged as shared
+// bytes: it is reported, but does not count against the budget, which only
+// eviction could bring back under.
+class NGraphCacheBudget {
+ public:
+  // Returns the budget in bytes, 0 means unlimited
+  static int64 GetBudgetInBytes();
+  static void SetBudgetInBytes(int64 budget_in_bytes);
+
+  static void Charge(int64 bytes);
+  static void Release(int64 bytes);
+  static int64 GetChargedBytes();
+
+  // Memory held for the cached executables that cannot be evicted
+  static void ChargeShared(int64 bytes);
+  static void ReleaseShared(int64 bytes);
+  static int64 GetSharedBytes();
+
+  // Returns true if charging bytes more would go over the budget. Only the
+  // evictable bytes count.
+  static bool WouldExceed(int64 bytes);
+
+ private:
+  static std::atomic<int64> s_budget_in_bytes;
+  static std::atomic<int64> s_charged_bytes;
+  static std::atomic<int64> s_shared_bytes;
+};
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_CACHE_BUDGET_H_
@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#ifndef NGRAPH_TF_CACHE_LRU_H_
+#define NGRAPH_TF_CACHE_LRU_H_
+#pragma once
+
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+// What it costs to keep a compiled executable in a cache, and what it would
+// cost to recreate it
+struct NGraphCacheItemCost {
+  // Memory taken by the compiled executable. An estimate computed from the
+  // function, nGraph does not report it (see EstimateExecutableBytes)
+  int64 executable_bytes = 0;
+  // Memory taken by the I/O tensors held for the executable
+  int64 tensor_bytes = 0;
+  // Time it took to translate and compile the executable
+  int64 compile_time_ms = 0;
+
+  int64 Bytes() const { return executable_bytes + tensor_bytes; }
+
+  // Compile time saved per byte held. Among the candidates for eviction the
+  // item with the lowest value goes first, so a small, quickly compiled item
+  // is evicted before a large one that took long to compile.
+  double RetentionValue() const {
+    return (compile_time_ms + 1.0) / (Bytes() + 1.0);
+  }
+};
+
+//
+// NGraphLRU keeps the keys of a cache in order of use. The keys are kept in
+// a list, and a map from key to its node in the list makes Touch() and
+// Remove() constant time.
+//
+// Eviction is cost aware: SelectVictim() looks at a small, fixed number of
+// the least recently used keys and picks the one with the lowest
+// NGraphCacheItemCost::RetentionValue(). With equal costs (or no costs at
+// all) this is plain LRU.
+//
+template <typename KeyType>
+class NGraphLRU {
+ public:
+  // Number of least recently used keys SelectVictim() chooses from
+  static const size_t kEvictionWindow = 4;
+
+  // Marks key as the most recently used one, adding it if needed
+  void Touch(const KeyType& key) {
+    auto itr = m_position.find(key);
+    if (itr != m_position.end()) {
+      m_order.splice(m_order.begin(), m_order, itr->second);
+    } else {
+      m_order.push_front(key);
+      m_position[key] = m_order.begin();
+    }
+  }
+
+  void Remove(const KeyType& key) {
+    auto itr = m_position.find(key);
+    if (itr != m_position.end()) {
+      m_order.erase(itr->second);
+      m_position.erase(itr);
+    }
+  }
+
+  void Clear() {
+    m_order.clear();
+    m_position.clear();
+  }
+
+  bool Contains(const KeyType& key) const {
+    return m_position.find(key) != m_position.end();
+  }
+
+  size_t Size() const { return m_order.size(); }
+
+  bool Empty() const { return m_order.empty(); }
+
+  const KeyType& MostRecent() const { return m_order.front(); }
+
+  const KeyType& LeastRecent() const { return m_order.back(); }
+
+  // Returns the key to evict. Must not be called on an empty LRU.
+  KeyType SelectVictim(
+      std::function<NGraphCacheItemCost(const KeyType&)> cost_of_item) const {
+    auto victim = m_order.rbegin();
+    double victim_value = cost_of_item(*victim).RetentionValue();
+    size_t candidates = 1;
+    for (auto itr = std::next(m_order.rbegin());
+         itr != m_order.rend() && candidates < kEvictionWindow;
+         itr++, candidates++) {
+      double value = cost_of_item(*itr).RetentionValue();
+      if (value < victim_value) {
+        victim = itr;
+        victim_value = value;
+      }
+    }
+    return *victim;
+  }
+
+ private:
+  // Most recently used first
+  std::list<KeyType> m_order;
+  std::unordered_map<KeyType, typename std::list<KeyType>::iterator>
+      m_position;
+};
+
+template <typename KeyType>
+const size_t NGraphLRU<KeyType>::kEvictionWindow;
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_CACHE_LRU_H_
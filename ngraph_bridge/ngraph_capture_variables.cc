@@ -136,25 +136,8 @@ Status CaptureVariables(Graph* graph, const std::set<string> skip_these_nodes) {
   // If Prefetch is requested
   if (std::getenv(NGraphPrefetchSharedResouce::NGRAPH_TF_USE_PREFETCH) !=
       nullptr) {
-    if (make_iterator_nodes.size() > 1) {
-      return errors::Internal(
-          "Found more than 1 MakeIterator nodes. This case is not supported.");
-    }
-    // Else try to capture it
-    Node* make_iterator_node = make_iterator_nodes[0];
-    // We expect the MakeIterator to have 1 input thats
-    // an iterator and the other one can be either a
-    // PrefetchDataset node or a ModelDataset node
-    // Other cases are not handled at the moment.
-    Node* prefetch_node = FindPrefetch(make_iterator_node);
-    if (prefetch_node != nullptr) {
-      return ReplacePrefetch(graph, prefetch_node);
-    } else {
-      return errors::Internal(
-          "Did not find PrefetchDataset or "
-          "ModelDataset+OptimizeDataset+PrefetchDataset as MakeIterator "
-          "nodes' inputs. Only those 2 cases are handled for now.");
-    }
+    // Each input pipeline has its MakeIterator
+    TF_RETURN_IF_ERROR(ReplacePrefetches(graph, make_iterator_nodes));
   }
 
   make_iterator_nodes.clear();
@@ -34,6 +34,10 @@ unordered_map<string, unordered_set<int>>
 unordered_map<string, tuple<string, bool>>
     NGraphCatalog::encap_output_info_map_;
 unordered_map<string, map<int, int>> NGraphCatalog::prefetched_input_index_map_;
+unordered_map<string, string> NGraphCatalog::prefetched_input_iterator_map_;
+map<pair<int, string>, set<int>> NGraphCatalog::iterator_encaps_map_;
+unordered_map<string, int> NGraphCatalog::iterator_graph_map_;
+std::mutex NGraphCatalog::prefetched_input_iterator_mutex_;
 
 // Function to create the Node Key
 string NGraphCatalog::CreateNodeKey(const int& graph_id,
@@ -54,6 +58,7 @@ void NGraphCatalog::ClearCatalog() {
   NGraphCatalog::ClearEncapOutputCopyIndexesMap();
   NGraphCatalog::ClearEncapOutputInfoMap();
   NGraphCatalog::ClearPrefetchedInputIndexMap();
+  NGraphCatalog::ClearPrefetchedInputIteratorMap();
 }
 
 // Functions for Encapsulate Output Copy Indexes Map
@@ -259,5 +264,77 @@ void NGraphCatalog::PrintPrefetchedInputIndexMap() {
     }
   }
 }
+
+// Functions for PrefetchedInputIterator Map
+void NGraphCatalog::AddToPrefetchedInputIteratorMap(
+    const int& graphid, const string& node_name, const int& cluster_id,
+    const string& iterator_name) {
+  string key = NGraphCatalog::CreateNodeKey(graphid, node_name);
+  std::lock_guard<std::mutex> lock(prefetched_input_iterator_mutex_);
+  if (prefetched_input_iterator_map_.find(key) !=
+      prefetched_input_iterator_map_.end()) {
+    throw runtime_error("Trying to add an already existing key ( " + key +
+                        " ) in PrefetchedInputIteratorMap ");
+  }
+  prefetched_input_iterator_map_.insert({key, iterator_name});
+  iterator_encaps_map_[{graphid, iterator_name}].insert(cluster_id);
+}
+
+bool NGraphCatalog::ExistsInPrefetchedInputIteratorMap(
+    const int& graphid, const string& node_name) {
+  string key = NGraphCatalog::CreateNodeKey(graphid, node_name);
+  std::lock_guard<std::mutex> lock(prefetched_input_iterator_mutex_);
+  return prefetched_input_iterator_map_.find(key) !=
+         prefetched_input_iterator_map_.end();
+}
+
+string NGraphCatalog::GetIteratorFromPrefetchedInputIteratorMap(
+    const int& graphid, const string& node_name) {
+  string key = NGraphCatalog::CreateNodeKey(graphid, node_name);
+  std::lock_guard<std::mutex> lock(prefetched_input_iterator_mutex_);
+  return prefetched_input_iterator_map_.at(key);
+}
+
+set<int> NGraphCatalog::GetEncapsFedByIterator(const int& graphid,
+                                               const string& iterator_name) {
+  std::lock_guard<std::mutex> lock(prefetched_input_iterator_mutex_);
+  auto itr = iterator_encaps_map_.find({graphid, iterator_name});
+  if (itr == iterator_encaps_map_.end()) {
+    return {};
+  }
+  return itr->second;
+}
+
+bool NGraphCatalog::ClaimPrefetchIterator(const int& graphid,
+                                          const string& iterator_name) {
+  std::lock_guard<std::mutex> lock(prefetched_input_iterator_mutex_);
+  auto itr = iterator_graph_map_.insert({iterator_name, graphid}).first;
+  return itr->second == graphid;
+}
+
+int NGraphCatalog::GetPrefetchIteratorGraph(const string& iterator_name) {
+  std::lock_guard<std::mutex> lock(prefetched_input_iterator_mutex_);
+  auto itr = iterator_graph_map_.find(iterator_name);
+  if (itr == iterator_graph_map_.end()) {
+    return -1;
+  }
+  return itr->second;
+}
+
+void NGraphCatalog::ClearPrefetchedInputIteratorMap() {
+  std::lock_guard<std::mutex> lock(prefetched_input_iterator_mutex_);
+  prefetched_input_iterator_map_.clear();
+  iterator_encaps_map_.clear();
+  iterator_graph_map_.clear();
+}
+
+void NGraphCatalog::PrintPrefetchedInputIteratorMap() {
+  std::lock_guard<std::mutex> lock(prefetched_input_iterator_mutex_);
+  NGRAPH_VLOG(4) << "PrefetchedInputIteratorMap";
+  for (auto it : prefetched_input_iterator_map_) {
+    NGRAPH_VLOG(4) << "Key: (GraphId_NodeName) " << it.first
+                   << " Iterator: " << it.second;
+  }
+}
 }  // ngraph_bridge
 }  // tensorflow
@@ -18,8 +18,10 @@
 #define NGRAPH_TF_CATALOG_H_
 
 #include <atomic>
+#include <map>
 #include <mutex>
 #include <ostream>
+#include <set>
 #include <vector>
 
 #include "tensorflow/core/lib/core/errors.h"
@@ -89,6 +91,28 @@ class NGraphCatalog {
 
   static unordered_map<string, map<int, int>> prefetched_input_index_map_;
 
+  // Map keeps track of the iterator whose IteratorGetNext feeds the
+  // prefetched inputs of an encap node, and the reverse map from an iterator
+  // to the encap nodes it feeds. The NGraphPrefetchDataset made for the
+  // iterator uses it at runtime to find the shared resources of these encaps.
+  // Map of
+  // Key
+  //      string : GraphId + _ + nodename
+  // Value : name of the iterator node
+  static unordered_map<string, string> prefetched_input_iterator_map_;
+  // Map of
+  // Key
+  //      {GraphId, name of the iterator node}
+  // Value : Set of ClusterIds of the encaps
+  static map<pair<int, string>, set<int>> iterator_encaps_map_;
+  // Map of
+  // Key
+  //      string : name of the iterator node
+  // Value : GraphId of the encaps the iterator prefetches for
+  static unordered_map<string, int> iterator_graph_map_;
+  // Protects the maps above, read while other graphs are rewritten
+  static std::mutex prefetched_input_iterator_mutex_;
+
  public:
   // Utility to create key to query the maps
   static string CreateNodeKey(const int& graph_id, const string& node_name,
@@ -165,6 +189,33 @@ class NGraphCatalog {
 
   static void ClearPrefetchedInputIndexMap();
   static void PrintPrefetchedInputIndexMap();
+
+  // Functions for PrefetchedInputIterator Map
+  static void AddToPrefetchedInputIteratorMap(const int& graphid,
+                                              const string& node_name,
+                                              const int& cluster_id,
+                                              const string& iterator_name);
+  static bool ExistsInPrefetchedInputIteratorMap(const int& graphid,
+                                                 const string& node_name);
+  static string GetIteratorFromPrefetchedInputIteratorMap(
+      const int& graphid, const string& node_name);
+  // ClusterIds of the encaps of the graph fed by the iterator
+  static set<int> GetEncapsFedByIterator(const int& graphid,
+                                         const string& iterator_name);
+
+  // An iterator prefetches for the encaps of one graph: every step of that
+  // graph consumes an element in each of them. The encaps of the other
+  // graphs reading the iterator (e.g. another set of fetches, which may not
+  // run all of them or not at every step) copy their inputs instead.
+  // Returns true if the iterator prefetches for the graph, making it the one
+  // if there is none yet.
+  static bool ClaimPrefetchIterator(const int& graphid,
+                                    const string& iterator_name);
+  // The GraphId the iterator prefetches for, -1 if none
+  static int GetPrefetchIteratorGraph(const string& iterator_name);
+
+  static void ClearPrefetchedInputIteratorMap();
+  static void PrintPrefetchedInputIteratorMap();
 };
 
 }  // ngraph_bridge
@@ -0,0 +1,215 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/mutex.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_cluster_cost_model.h"
+
+using namespace std;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+// A cluster needs at least this many nodes other than Const and Identity
+static const int MIN_NONTRIVIAL_NODES = 2;
+
+static mutex s_model_mutex;
+static std::unique_ptr<NGraphClusterCostModel> s_model;
+
+NGraphClusterCostModel& NGraphClusterCostModel::Get() {
+  mutex_lock lock(s_model_mutex);
+  if (s_model == nullptr) {
+    s_model.reset(new NGraphClusterCostModel());
+  }
+  return *s_model;
+}
+
+void NGraphClusterCostModel::Set(
+    std::unique_ptr<NGraphClusterCostModel> model) {
+  mutex_lock lock(s_model_mutex);
+  s_model = std::move(model);
+}
+
+double NGraphClusterCostModel::GetMinFlopsPerByte() {
+  static const double min_flops_per_byte = [] {
+    const char* specified = std::getenv("NGRAPH_TF_CLUSTER_MIN_FLOPS_PER_BYTE");
+    return specified == nullptr ? 0.0 : atof(specified);
+  }();
+  return min_flops_per_byte;
+}
+
+bool NGraphClusterCostModel::GetOutputShape(const Node* node, int index,
+                                            TensorShape& shape) {
+  std::vector<PartialTensorShape> output_shapes;
+  if (GetNodeAttr(node->attrs(), "_output_shapes", &output_shapes).ok() &&
+      index < output_shapes.size()) {
+    return output_shapes[index].AsTensorShape(&shape);
+  }
+  if (index != 0) {
+    return false;
+  }
+  if (node->type_string() == "Const") {
+    const TensorProto* value;
+    if (GetNodeAttr(node->attrs(), "value", &value).ok() &&
+        TensorShape::IsValid(value->tensor_shape())) {
+      shape = TensorShape(value->tensor_shape());
+      return true;
+    }
+  } else if (node->type_string() == "Placeholder") {
+    PartialTensorShape placeholder_shape;
+    if (GetNodeAttr(node->attrs(), "shape", &placeholder_shape).ok()) {
+      return placeholder_shape.AsTensorShape(&shape);
+    }
+  }
+  return false;
+}
+
+int64 NGraphClusterCostModel::NodeFlops(const Node* node, bool& shape_known) {
+  static const std::set<string> no_compute_ops{
+      "Const", "Identity", "Reshape",  "Squeeze",     "ExpandDims",
+      "Shape", "NoOp",     "Snapshot", "StopGradient"};
+  const string& type = node->type_string();
+  if (no_compute_ops.count(type) != 0) {
+    return 0;
+  }
+
+  TensorShape output_shape;
+  if (!GetOutputShape(node, 0, output_shape)) {
+    shape_known = false;
+    return 0;
+  }
+  int64 output_elements = output_shape.num_elements();
+  auto get_input_shape = [node](int index, TensorShape& shape) {
+    const Edge* edge;
+    return node->input_edge(index, &edge).ok() &&
+           GetOutputShape(edge->src(), edge->src_output(), shape);
+  };
+
+  // Multiply-adds per output element
+  if (type == "MatMul" || type == "BatchMatMul" || type == "BatchMatMulV2") {
+    TensorShape a_shape;
+    if (!get_input_shape(0, a_shape) || a_shape.dims() < 2) {
+      shape_known = false;
+      return output_elements;
+    }
+    bool transpose_a = false;
+    GetNodeAttr(node->attrs(), type == "MatMul" ? "transpose_a" : "adj_x",
+                &transpose_a)
+        .IgnoreError();
+    int64 inner = a_shape.dim_size(a_shape.dims() - (transpose_a ? 2 : 1));
+    return 2 * output_elements * inner;
+  }
+  if (type == "Conv2D" || type == "Conv3D" ||
+      type == "DepthwiseConv2dNative" || type == "Conv2DBackpropInput" ||
+      type == "Conv2DBackpropFilter") {
+    // The filter is an input, or the output of the filter gradient
+    TensorShape filter_shape = output_shape;
+    if (type != "Conv2DBackpropFilter" && !get_input_shape(1, filter_shape)) {
+      shape_known = false;
+      return output_elements;
+    }
+    int rank = filter_shape.dims();
+    if (rank < 2 || filter_shape.num_elements() == 0) {
+      return output_elements;
+    }
+    if (type == "Conv2DBackpropFilter") {
+      // One multiply-add per output gradient element and filter element
+      // along the input channels and the window
+      TensorShape grad_shape;
+      if (!get_input_shape(2, grad_shape)) {
+        shape_known = false;
+        return output_elements;
+      }
+      return 2 * grad_shape.num_elements() * filter_shape.num_elements() /
+             filter_shape.dim_size(rank - 1);
+    }
+    // Window and channels reduced into each output element
+    int64 reduced_dim = filter_shape.dim_size(rank - 1);
+    if (type == "DepthwiseConv2dNative") {
+      reduced_dim *= filter_shape.dim_size(rank - 2);
+    } else if (type == "Conv2DBackpropInput") {
+      reduced_dim = filter_shape.dim_size(rank - 2);
+    }
+    return 2 * output_elements * filter_shape.num_elements() / reduced_dim;
+  }
+
+  // About one flop per element of the output, or of the first input for
+  // the reductions
+  TensorShape input_shape;
+  if (node->num_inputs() > 0 && get_input_shape(0, input_shape)) {
+    return std::max(output_elements, input_shape.num_elements());
+  }
+  return output_elements;
+}
+
+Status NGraphClusterCostModel::Estimate(const std::set<Node*>& nodes,
+                                        NGraphClusterCost& cost) {
+  cost = NGraphClusterCost();
+  // (node, output) of the tensors crossing the boundary
+  std::set<std::pair<const Node*, int>> boundary_tensors;
+  for (auto node : nodes) {
+    if (node->type_string() != "Const" && node->type_string() != "Identity") {
+      cost.num_nontrivial_nodes++;
+    }
+    bool shape_known = true;
+    cost.flops += NodeFlops(node, shape_known);
+    cost.shapes_known &= shape_known;
+
+    for (auto edge : node->in_edges()) {
+      if (!edge->IsControlEdge() && nodes.count(edge->src()) == 0) {
+        boundary_tensors.insert({edge->src(), edge->src_output()});
+      }
+    }
+    for (auto edge : node->out_edges()) {
+      if (!edge->IsControlEdge() && nodes.count(edge->dst()) == 0) {
+        boundary_tensors.insert({node, edge->src_output()});
+      }
+    }
+  }
+
+  for (const auto& tensor : boundary_tensors) {
+    TensorShape shape;
+    if (!GetOutputShape(tensor.first, tensor.second, shape)) {
+      cost.shapes_known = false;
+      continue;
+    }
+    DataType dtype = BaseType(tensor.first->output_type(tensor.second));
+    cost.transfer_bytes += shape.num_elements() * DataTypeSize(dtype);
+  }
+
+  cost.benefit = cost.flops - m_min_flops_per_byte * cost.transfer_bytes;
+  return Status::OK();
+}
+
+bool NGraphClusterCostModel::KeepCluster(const NGraphClusterCost& cost) {
+  if (cost.num_nontrivial_nodes < MIN_NONTRIVIAL_NODES) {
+    return false;
+  }
+  // Without all the shapes the estimate is too rough to bust the cluster
+  return !cost.shapes_known || cost.benefit >= 0;
+}
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
@@ -0,0 +1,103 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#ifndef NGRAPH_TF_CLUSTER_COST_MODEL_H_
+#define NGRAPH_TF_CLUSTER_COST_MODEL_H_
+#pragma once
+
+#include <memory>
+#include <set>
+
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+// Estimated cost of running a cluster on nGraph
+struct NGraphClusterCost {
+  // Nodes other than Const and Identity
+  int num_nontrivial_nodes = 0;
+  // Compute of the nodes, in floating point operations
+  int64 flops = 0;
+  // Bytes of the tensors that cross the cluster boundary, copied in and out
+  // of the nGraph tensors on every call
+  int64 transfer_bytes = 0;
+  // False if some shape needed for flops or transfer_bytes was unknown, they
+  // are lower bounds then
+  bool shapes_known = true;
+  // Estimated gain of running the cluster on nGraph, in flops. Negative if
+  // the transfers are expected to cost more than the compute saves.
+  double benefit = 0;
+  // Measured average time of a step on nGraph and on TensorFlow, negative
+  // if not measured (see NGraphProfileCostModel)
+  double ngraph_step_us = -1;
+  double tf_step_us = -1;
+};
+
+//
+// NGraphClusterCostModel decides which clusters DeassignClusters keeps. The
+// default model estimates the flops of the nodes from their types and output
+// shapes (the _output_shapes attribute, or the shape of Consts and
+// Placeholders) and the bytes crossing the boundary of the cluster. A
+// cluster is kept if it has at least two non trivial nodes and, when all the
+// shapes are known, does at least NGRAPH_TF_CLUSTER_MIN_FLOPS_PER_BYTE flops
+// per byte it transfers. That threshold defaults to 0, i.e. only the number
+// of nodes counts unless it is set.
+//
+// Another model can be plugged in with Set, for example one calibrated for a
+// backend.
+//
+class NGraphClusterCostModel {
+ public:
+  NGraphClusterCostModel() : m_min_flops_per_byte(GetMinFlopsPerByte()) {}
+  explicit NGraphClusterCostModel(double min_flops_per_byte)
+      : m_min_flops_per_byte(min_flops_per_byte) {}
+  virtual ~NGraphClusterCostModel() = default;
+
+  // Estimates the cost of the cluster made of nodes
+  virtual Status Estimate(const std::set<Node*>& nodes,
+                          NGraphClusterCost& cost);
+  // Whether the cluster is worth running on nGraph
+  virtual bool KeepCluster(const NGraphClusterCost& cost);
+
+  // The model in use, the default one unless another was set
+  static NGraphClusterCostModel& Get();
+  // Sets the model in use, nullptr restores the default. Not to be called
+  // while a graph is being rewritten.
+  static void Set(std::unique_ptr<NGraphClusterCostModel> model);
+
+  // Flops the cluster has to do per transferred byte to be kept, from
+  // NGRAPH_TF_CLUSTER_MIN_FLOPS_PER_BYTE
+  static double GetMinFlopsPerByte();
+
+  // Shape of output index of node, if known
+  static bool GetOutputShape(const Node* node, int index, TensorShape& shape);
+
+ protected:
+  // Estimated flops of node
+  virtual int64 NodeFlops(const Node* node, bool& shape_known);
+
+  const double m_min_flops_per_byte;
+};
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_CLUSTER_COST_MODEL_H_
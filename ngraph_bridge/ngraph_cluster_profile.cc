@@ -0,0 +1,215 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_cluster_profile.h"
+
+using namespace std;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+static mutex s_recorded_mutex;
+static std::map<string, NGraphClusterTimings> s_recorded;
+// Encapsulates that record, guarded by s_recorded_mutex
+static int s_recorders = 0;
+
+double NGraphClusterTimings::NGraphStepUs() const {
+  if (ngraph_steps == 0) {
+    return -1;
+  }
+  return double(compile_us + copy_in_us + execute_us + copy_out_us) /
+         ngraph_steps;
+}
+
+double NGraphClusterTimings::TensorFlowStepUs() const {
+  if (fallback_steps == 0) {
+    return -1;
+  }
+  return double(fallback_us) / fallback_steps;
+}
+
+string NGraphClusterProfile::ClusterKey(std::vector<string> node_names) {
+  std::sort(node_names.begin(), node_names.end());
+  uint64 hash = 0;
+  for (const auto& node_name : node_names) {
+    hash = Hash64(node_name.data(), node_name.size(), hash);
+  }
+  return strings::StrCat(strings::Hex(hash, strings::kZeroPad16));
+}
+
+const string& NGraphClusterProfile::GetRecordingFile() {
+  static const string recording_file = [] {
+    const char* path = std::getenv("NGRAPH_TF_CLUSTER_PROFILE");
+    return string(path == nullptr ? "" : path);
+  }();
+  return recording_file;
+}
+
+int64 NGraphClusterProfile::GetTensorFlowSteps() {
+  static const int64 tf_steps = [] {
+    const char* specified = std::getenv("NGRAPH_TF_CLUSTER_PROFILE_TF_STEPS");
+    return specified == nullptr ? 10 : atol(specified);
+  }();
+  return tf_steps;
+}
+
+void NGraphClusterProfile::RecordNGraphStep(const string& key,
+                                            int64 compile_us,
+                                            int64 copy_in_us,
+                                            int64 execute_us,
+                                            int64 copy_out_us) {
+  mutex_lock lock(s_recorded_mutex);
+  NGraphClusterTimings& timings = s_recorded[key];
+  timings.ngraph_steps++;
+  timings.compile_us += compile_us;
+  timings.copy_in_us += copy_in_us;
+  timings.execute_us += execute_us;
+  timings.copy_out_us += copy_out_us;
+}
+
+void NGraphClusterProfile::RecordFallbackStep(const string& key, int64 us) {
+  mutex_lock lock(s_recorded_mutex);
+  NGraphClusterTimings& timings = s_recorded[key];
+  timings.fallback_steps++;
+  timings.fallback_us += us;
+}
+
+std::map<string, NGraphClusterTimings> NGraphClusterProfile::GetRecorded() {
+  mutex_lock lock(s_recorded_mutex);
+  return s_recorded;
+}
+
+Status NGraphClusterProfile::WriteRecorded() {
+  if (!IsRecording()) {
+    return Status::OK();
+  }
+  return Write(GetRecordingFile(), GetRecorded());
+}
+
+void NGraphClusterProfile::AddRecorder() {
+  mutex_lock lock(s_recorded_mutex);
+  s_recorders++;
+}
+
+Status NGraphClusterProfile::RemoveRecorder() {
+  {
+    mutex_lock lock(s_recorded_mutex);
+    if (--s_recorders > 0) {
+      return Status::OK();
+    }
+  }
+  return WriteRecorded();
+}
+
+Status NGraphClusterProfile::Write(
+    const string& path, const std::map<string, NGraphClusterTimings>& profile) {
+  // A reader never sees a partly written profile
+  string tmp_path = path + ".tmp";
+  std::ofstream file(tmp_path);
+  if (!file) {
+    return errors::Internal("Cannot write the cluster profile ", tmp_path);
+  }
+  file << "# key ngraph_steps compile_us copy_in_us execute_us copy_out_us "
+          "fallback_steps fallback_us\n";
+  for (const auto& kv : profile) {
+    const NGraphClusterTimings& timings = kv.second;
+    file << kv.first << " " << timings.ngraph_steps << " "
+         << timings.compile_us << " " << timings.copy_in_us << " "
+         << timings.execute_us << " " << timings.copy_out_us << " "
+         << timings.fallback_steps << " " << timings.fallback_us << "\n";
+  }
+  file.close();
+  if (!file) {
+    std::remove(tmp_path.c_str());
+    return errors::Internal("Error writing the cluster profile ", tmp_path);
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return errors::Internal("Cannot rename the cluster profile ", tmp_path,
+                            " to ", path);
+  }
+  NGRAPH_VLOG(1) << "Wrote the profile of " << profile.size()
+                 << " clusters to " << path;
+  return Status::OK();
+}
+
+Status NGraphClusterProfile::Read(
+    const string& path, std::map<string, NGraphClusterTimings>& profile) {
+  std::ifstream file(path);
+  if (!file) {
+    return errors::NotFound("Cannot read the cluster profile ", path);
+  }
+  profile.clear();
+  string line;
+  int line_number = 0;
+  while (std::getline(file, line)) {
+    line_number++;
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    string key;
+    NGraphClusterTimings timings;
+    if (!(fields >> key >> timings.ngraph_steps >> timings.compile_us >>
+          timings.copy_in_us >> timings.execute_us >> timings.copy_out_us >>
+          timings.fallback_steps >> timings.fallback_us)) {
+      return errors::InvalidArgument("Malformed cluster profile ", path,
+                                     " at line ", line_number);
+    }
+    profile[key] = timings;
+  }
+  NGRAPH_VLOG(1) << "Read the profile of " << profile.size()
+                 << " clusters from " << path;
+  return Status::OK();
+}
+
+Status NGraphProfileCostModel::Estimate(const std::set<Node*>& nodes,
+                                        NGraphClusterCost& cost) {
+  TF_RETURN_IF_ERROR(NGraphClusterCostModel::Estimate(nodes, cost));
+  std::vector<string> node_names;
+  for (auto node : nodes) {
+    node_names.push_back(node->name());
+  }
+  auto itr = m_profile.find(NGraphClusterProfile::ClusterKey(node_names));
+  if (itr != m_profile.end()) {
+    cost.ngraph_step_us = itr->second.NGraphStepUs();
+    cost.tf_step_us = itr->second.TensorFlowStepUs();
+  }
+  return Status::OK();
+}
+
+bool NGraphProfileCostModel::KeepCluster(const NGraphClusterCost& cost) {
+  if (cost.ngraph_step_us >= 0 && cost.tf_step_us >= 0) {
+    return cost.ngraph_step_us <= cost.tf_step_us;
+  }
+  return NGraphClusterCostModel::KeepCluster(cost);
+}
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
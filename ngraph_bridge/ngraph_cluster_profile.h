@@ -0,0 +1,131 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#ifndef NGRAPH_TF_CLUSTER_PROFILE_H_
+#define NGRAPH_TF_CLUSTER_PROFILE_H_
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+
+#include "ngraph_bridge/ngraph_cluster_cost_model.h"
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+// Measured times of a cluster, summed over the profiled steps
+struct NGraphClusterTimings {
+  // Steps run by nGraph, and their times
+  int64 ngraph_steps = 0;
+  int64 compile_us = 0;
+  int64 copy_in_us = 0;
+  int64 execute_us = 0;
+  int64 copy_out_us = 0;
+  // Steps run by the TensorFlow kernels of the cluster (the fallback of
+  // NGRAPH_TF_ASYNC_COMPILE), and their time
+  int64 fallback_steps = 0;
+  int64 fallback_us = 0;
+
+  // Average time of a step run by nGraph, the compilations spread over the
+  // steps. Negative if no step ran.
+  double NGraphStepUs() const;
+  // Average time of a step run by TensorFlow, negative if no step ran
+  double TensorFlowStepUs() const;
+};
+
+//
+// NGraphClusterProfile records how long the encapsulates take, to guide the
+// placement of a later run of the same graph.
+//
+// The profiling run sets NGRAPH_TF_CLUSTER_PROFILE=<file>. Every encapsulate
+// then records its compile, copy and execute times, and runs every other
+// step on the TensorFlow fallback to time it too, till it has
+// NGRAPH_TF_CLUSTER_PROFILE_TF_STEPS (default 10) such steps. The first
+// fallback step of an encapsulate instantiates the function and is not
+// recorded. The profile is written to the file once the last encapsulate is
+// destroyed. The profile_file parameter of the ngraph-optimizer then reads
+// it back (see NGraphProfileCostModel).
+//
+// A cluster is identified by a hash of the names of its nodes, which stay
+// the same from a run of the graph to the next.
+//
+class NGraphClusterProfile {
+ public:
+  // Key of the cluster made of the nodes with these names
+  static std::string ClusterKey(std::vector<std::string> node_names);
+
+  // The file NGRAPH_TF_CLUSTER_PROFILE names, empty if not recording
+  static const std::string& GetRecordingFile();
+  static bool IsRecording() { return !GetRecordingFile().empty(); }
+
+  // Number of steps of each encapsulate to run on the TensorFlow fallback
+  static int64 GetTensorFlowSteps();
+
+  // Add the times of a step of the cluster
+  static void RecordNGraphStep(const std::string& key, int64 compile_us,
+                               int64 copy_in_us, int64 execute_us,
+                               int64 copy_out_us);
+  static void RecordFallbackStep(const std::string& key, int64 us);
+
+  // Timings recorded so far, by cluster key
+  static std::map<std::string, NGraphClusterTimings> GetRecorded();
+
+  // Writes the recorded timings to the recording file
+  static Status WriteRecorded();
+
+  // Called by the encapsulates that record, when they are created and
+  // destroyed. The last one to go away writes the recorded timings.
+  static void AddRecorder();
+  static Status RemoveRecorder();
+
+  // One line per cluster: the key, then the fields of NGraphClusterTimings.
+  // Written to a temporary file first, and renamed to path.
+  static Status Write(
+      const std::string& path,
+      const std::map<std::string, NGraphClusterTimings>& profile);
+  static Status Read(const std::string& path,
+                     std::map<std::string, NGraphClusterTimings>& profile);
+};
+
+//
+// NGraphProfileCostModel keeps the profiled clusters that ran faster on
+// nGraph than on TensorFlow, compile and copies included, and deassigns the
+// ones that ran slower. Clusters that are not in the profile, or never ran
+// on TensorFlow, are decided by the default model.
+//
+class NGraphProfileCostModel : public NGraphClusterCostModel {
+ public:
+  explicit NGraphProfileCostModel(
+      std::map<std::string, NGraphClusterTimings> profile)
+      : m_profile(std::move(profile)) {}
+
+  Status Estimate(const std::set<Node*>& nodes,
+                  NGraphClusterCost& cost) override;
+  bool KeepCluster(const NGraphClusterCost& cost) override;
+
+ private:
+  const std::map<std::string, NGraphClusterTimings> m_profile;
+};
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_CLUSTER_PROFILE_H_
@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "tensorflow/core/common_runtime/dma_helper.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_cache_budget.h"
+#include "ngraph_bridge/ngraph_constant_pool.h"
+
+using namespace std;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+NGraphConstantPool::~NGraphConstantPool() {
+  NGraphCacheBudget::ReleaseShared(m_bytes);
+}
+
+Status NGraphConstantPool::GetTensor(const Node* op, Tensor& tensor) {
+  mutex_lock lock(m_mutex);
+  auto itr = m_tensors.find(op->name());
+  if (itr != m_tensors.end()) {
+    tensor = itr->second;
+    return Status::OK();
+  }
+
+  if (op->type_string() != "Const") {
+    return errors::InvalidArgument("Node ", op->name(), " is not a Const");
+  }
+  Tensor value;
+  if (!value.FromProto(op->def().attr().at("value").tensor())) {
+    return errors::Internal("Const tensor proto parsing failed for ",
+                            op->name());
+  }
+  m_tensors[op->name()] = value;
+  m_buffers.insert(DMAHelper::base(&value));
+  m_bytes += value.TotalBytes();
+  NGraphCacheBudget::ChargeShared(value.TotalBytes());
+  NGRAPH_VLOG(5) << "Constant pool: added " << op->name() << ", "
+                 << m_tensors.size() << " constants, " << m_bytes << " bytes";
+  tensor = value;
+  return Status::OK();
+}
+
+size_t NGraphConstantPool::Size() {
+  mutex_lock lock(m_mutex);
+  return m_tensors.size();
+}
+
+int64 NGraphConstantPool::GetBytes() {
+  mutex_lock lock(m_mutex);
+  return m_bytes;
+}
+
+bool NGraphConstantPool::Holds(const void* data) {
+  mutex_lock lock(m_mutex);
+  return m_buffers.count(data) > 0;
+}
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#ifndef NGRAPH_TF_CONSTANT_POOL_H_
+#define NGRAPH_TF_CONSTANT_POOL_H_
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+//
+// NGraphConstantPool holds the values of the Const nodes of one encapsulated
+// graph, parsed once from their protos. Every nGraph function translated from
+// that graph (one per input signature) builds its Constants on top of these
+// tensors instead of copying the values out of the proto, so a new signature
+// does not parse or duplicate the weights again.
+//
+// The tensors are refcounted, the nGraph Constants that reference one keep it
+// alive even if the pool goes away first. The pool is only used if nGraph
+// can build a Constant on memory it does not own (see
+// Builder::CanPoolConstants), otherwise it stays empty.
+//
+// The pooled bytes are reported to the NGraphCacheBudget as shared bytes once,
+// when a value is added, and released with the pool. They cannot be evicted,
+// so they do not count against the budget. The cost of the executables built
+// on the pool does not include them (see NGraphExecutor::CreateCallback), so
+// another signature of the same cluster is charged for its private memory
+// only.
+//
+class NGraphConstantPool {
+ public:
+  NGraphConstantPool() = default;
+  ~NGraphConstantPool();
+
+  // Sets tensor to the value of the Const node op, parsing it on first use
+  Status GetTensor(const Node* op, Tensor& tensor);
+
+  // Number of constants and their total size
+  size_t Size();
+  int64 GetBytes();
+
+  // Returns true if data is the buffer of one of the constants
+  bool Holds(const void* data);
+
+ private:
+  mutex m_mutex;
+  // Const node name -> value
+  std::unordered_map<std::string, Tensor> m_tensors;
+  std::unordered_set<const void*> m_buffers;
+  int64 m_bytes = 0;
+};
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_CONSTANT_POOL_H_
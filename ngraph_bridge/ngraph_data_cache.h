@@ -18,7 +18,8 @@
 #define NGRAPH_DATA_CACHE_H_
 #pragma once
 
-#include <deque>
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <ostream>
 #include <vector>
@@ -30,6 +31,8 @@
 #include "logging/ngraph_log.h"
 #include "ngraph/ngraph.hpp"
 
+#include "ngraph_bridge/ngraph_cache_budget.h"
+#include "ngraph_bridge/ngraph_cache_lru.h"
 #include "ngraph_bridge/ngraph_freshness_tracker.h"
 #include "ngraph_bridge/ngraph_pipelined_tensors.h"
 
@@ -43,14 +46,28 @@ class NGraphDataCacheTest_SameKeyMultiThread_Test;
 class NGraphDataCacheTest_RemoveItemTest_Test;
 }
 
+// NgraphDataCache holds at most depth items. When it is full, or when the
+// process is over the NGraphCacheBudget, items are evicted in (cost aware)
+// LRU order, see NGraphLRU. The cost of an item is given by the optional
+// callback_item_cost, without it all items cost the same.
+//
+// A cache can only evict its own items. If emptying it would not bring the
+// process under budget, because of the items of the other caches, the new
+// item is added without evicting anything for the budget.
 template <typename KeyType, typename ValueType>
 class NgraphDataCache {
  public:
   explicit NgraphDataCache(int depth);
+  NgraphDataCache(int depth,
+                  std::function<NGraphCacheItemCost(KeyType, ValueType)>
+                      callback_item_cost);
   ~NgraphDataCache();
 
   // This method performs lookup in the cache for requested key, if not found
-  // it will create item, put it in the cache and returns item and status
+  // it will create item, put it in the cache and returns item and status.
+  // Only one thread creates the item for a given key, other threads asking
+  // for the same key meanwhile wait for its result (or error) instead of
+  // creating the item again
   std::pair<Status, ValueType> LookUpOrCreate(
       KeyType key,
       std::function<std::pair<Status, ValueType>(KeyType)> callback_create_item,
@@ -61,16 +78,46 @@ class NgraphDataCache {
       KeyType key,
       std::function<std::pair<Status, ValueType>(KeyType)> callback_create_item,
       bool& cache_hit);
+
+  // Looks up the key without creating the item on a miss. Returns true and
+  // sets item if it is in the cache
+  bool LookUp(KeyType key, ValueType& item);
+
   Status RemoveItem(KeyType key);
   Status RemoveItem(KeyType key,
                     std::function<void(ValueType)> callback_destroy_item);
   Status RemoveAll(std::function<void(ValueType)> callback_destroy_item);
 
+  // Number of lookups that waited for another thread's creation of the same
+  // item instead of creating it themselves
+  int64 GetCoalescedWaiterCount() const { return m_coalesced_waiters; }
+
+  // Number of items in the cache and the bytes they are charged for
+  int Size();
+  int64 GetChargedBytes();
+
  private:
+  // An item that is being created by one thread
+  struct InFlightItem {
+    bool done = false;
+    std::pair<Status, ValueType> result;
+  };
+
+  // Destroys the item and forgets about it, must be called with m_mutex held
+  Status EvictItem(KeyType key,
+                   std::function<void(ValueType)> callback_destroy_item);
+  // Bytes charged for the items of this cache, must be called with m_mutex
+  // held
+  int64 ChargedBytesLocked() const;
+
   std::unordered_map<KeyType, ValueType> m_ng_items_map;
-  std::deque<KeyType> m_lru;
+  std::unordered_map<KeyType, NGraphCacheItemCost> m_item_costs;
+  std::unordered_map<KeyType, std::shared_ptr<InFlightItem>> m_in_flight_items;
+  NGraphLRU<KeyType> m_lru;
   int m_depth;
+  std::function<NGraphCacheItemCost(KeyType, ValueType)> m_callback_item_cost;
   absl::Mutex m_mutex;
+  std::atomic<int64> m_coalesced_waiters{0};
 
   // Test class
   friend class tensorflow::ngraph_bridge::testing::
@@ -83,10 +130,37 @@ template <typename KeyType, typename ValueType>
 NgraphDataCache<KeyType, ValueType>::NgraphDataCache(int depth)
     : m_depth(depth) {}
 
+template <typename KeyType, typename ValueType>
+NgraphDataCache<KeyType, ValueType>::NgraphDataCache(
+    int depth,
+    std::function<NGraphCacheItemCost(KeyType, ValueType)> callback_item_cost)
+    : m_depth(depth), m_callback_item_cost(callback_item_cost) {}
+
 template <typename KeyType, typename ValueType>
 NgraphDataCache<KeyType, ValueType>::~NgraphDataCache() {
+  for (const auto& key_cost : m_item_costs) {
+    NGraphCacheBudget::Release(key_cost.second.Bytes());
+  }
   m_ng_items_map.clear();
-  m_lru.clear();
+  m_item_costs.clear();
+  m_lru.Clear();
+}
+
+template <typename KeyType, typename ValueType>
+Status NgraphDataCache<KeyType, ValueType>::EvictItem(
+    KeyType key, std::function<void(ValueType)> callback_destroy_item) {
+  try {
+    callback_destroy_item(m_ng_items_map.at(key));
+  } catch (std::bad_function_call& exception) {
+    return errors::Internal(
+        "Failed to destroy item. Invalid Callback to Destroy ",
+        exception.what(), "\n");
+  }
+  NGraphCacheBudget::Release(m_item_costs[key].Bytes());
+  m_ng_items_map.erase(key);
+  m_item_costs.erase(key);
+  m_lru.Remove(key);
+  return Status::OK();
 }
 
 template <typename KeyType, typename ValueType>
@@ -94,17 +168,9 @@ Status NgraphDataCache<KeyType, ValueType>::RemoveItem(
     KeyType key, std::function<void(ValueType)> callback_destroy_item) {
   absl::MutexLock lock(&m_mutex);
   if (m_ng_items_map.find(key) != m_ng_items_map.end()) {
-    try {
-      callback_destroy_item(m_ng_items_map.at(key));
-    } catch (std::bad_function_call& exception) {
-      return errors::Internal(
-          "Failed to destroy item. Invalid Callback to Destroy ",
-          exception.what(), "\n");
-    }
-    m_ng_items_map.erase(key);
-    m_lru.pop_back();
+    TF_RETURN_IF_ERROR(EvictItem(key, callback_destroy_item));
   }
-  if (m_ng_items_map.size() != m_lru.size()) {
+  if (m_ng_items_map.size() != m_lru.Size()) {
     return errors::Internal(
         "Error occured: size of m_ng_items_map is not same as that of m_lru");
   }
@@ -129,15 +195,53 @@ Status NgraphDataCache<KeyType, ValueType>::RemoveAll(
           exception.what(), "\n");
     }
   }
-  if (m_ng_items_map.size() != m_lru.size()) {
+  if (m_ng_items_map.size() != m_lru.Size()) {
     return errors::Internal(
         "Error occured: size of m_ng_items_map is not same as that of m_lru");
   }
+  for (const auto& key_cost : m_item_costs) {
+    NGraphCacheBudget::Release(key_cost.second.Bytes());
+  }
   m_ng_items_map.erase(m_ng_items_map.begin(), m_ng_items_map.end());
-  m_lru.clear();
+  m_item_costs.clear();
+  m_lru.Clear();
   return Status::OK();
 }
 
+template <typename KeyType, typename ValueType>
+int NgraphDataCache<KeyType, ValueType>::Size() {
+  absl::MutexLock lock(&m_mutex);
+  return m_ng_items_map.size();
+}
+
+template <typename KeyType, typename ValueType>
+int64 NgraphDataCache<KeyType, ValueType>::ChargedBytesLocked() const {
+  int64 bytes = 0;
+  for (const auto& key_cost : m_item_costs) {
+    bytes += key_cost.second.Bytes();
+  }
+  return bytes;
+}
+
+template <typename KeyType, typename ValueType>
+int64 NgraphDataCache<KeyType, ValueType>::GetChargedBytes() {
+  absl::MutexLock lock(&m_mutex);
+  return ChargedBytesLocked();
+}
+
+template <typename KeyType, typename ValueType>
+bool NgraphDataCache<KeyType, ValueType>::LookUp(KeyType key,
+                                                 ValueType& item) {
+  absl::MutexLock lock(&m_mutex);
+  auto it = m_ng_items_map.find(key);
+  if (it == m_ng_items_map.end()) {
+    return false;
+  }
+  m_lru.Touch(key);
+  item = it->second;
+  return true;
+}
+
 template <typename KeyType, typename ValueType>
 std::pair<Status, ValueType>
 NgraphDataCache<KeyType, ValueType>::LookUpOrCreate(
@@ -146,66 +250,102 @@ NgraphDataCache<KeyType, ValueType>::LookUpOrCreate(
     std::function<void(ValueType)> callback_destroy_item,
     bool& found_in_cache) {
   // look up in the cache
+  std::shared_ptr<InFlightItem> in_flight;
   {
     absl::MutexLock lock(&m_mutex);
     auto it = m_ng_items_map.find(key);
     found_in_cache = (it != m_ng_items_map.end());
     if (found_in_cache) {
+      m_lru.Touch(key);
       return std::make_pair(Status::OK(), m_ng_items_map.at(key));
     }
+    // Some other thread is already creating this item, wait for it
+    auto in_flight_itr = m_in_flight_items.find(key);
+    if (in_flight_itr != m_in_flight_items.end()) {
+      in_flight = in_flight_itr->second;
+      m_coalesced_waiters++;
+      NGRAPH_VLOG(1) << "NGRAPH_TF_CACHE_PROFILE: Waiting for item in flight. "
+                     << "Coalesced waiters: " << m_coalesced_waiters;
+      m_mutex.Await(absl::Condition(&in_flight->done));
+      return in_flight->result;
+    }
+    in_flight = std::make_shared<InFlightItem>();
+    m_in_flight_items.emplace(key, in_flight);
   }
-  // Item not found in cache, create item
-  ValueType item;
+  // Item not found in cache, create item. Whatever it throws is turned into
+  // an error result, the waiters must always be woken up and the in flight
+  // entry removed
   pair<Status, ValueType> status_item_pair;
   try {
     status_item_pair = callback_create_item(key);
   } catch (std::bad_function_call& exception) {
-    return std::make_pair(
+    status_item_pair = std::make_pair(
         errors::Internal(
             "Failed to create an item. Invalid Callback to Create ",
             exception.what(), "\n"),
-        item);
+        ValueType());
+  } catch (const std::exception& exception) {
+    status_item_pair = std::make_pair(
+        errors::Internal("Failed to create an item: ", exception.what()),
+        ValueType());
+  } catch (...) {
+    status_item_pair = std::make_pair(
+        errors::Internal("Failed to create an item: unknown exception"),
+        ValueType());
   }
-  // If item is successfully created we will place in the cache.
-  if (status_item_pair.first == Status::OK()) {
-    item = status_item_pair.second;
-    // lock begins
-    {
-      absl::MutexLock lock(&m_mutex);
-      // Remove item if cache is full
-      if (m_ng_items_map.size() == m_depth) {
-        auto key_to_evict = m_lru.back();
-        try {
-          callback_destroy_item(m_ng_items_map.at(key_to_evict));
-        } catch (std::bad_function_call& exception) {
-          return std::make_pair(
-              errors::Internal(
-                  "Failed to destroy item. Invalid Callback to Destroy ",
-                  exception.what(), "\n"),
-              item);
+  // lock begins
+  {
+    absl::MutexLock lock(&m_mutex);
+    // If item is successfully created we will place in the cache.
+    if (status_item_pair.first == Status::OK()) {
+      ValueType item = status_item_pair.second;
+      NGraphCacheItemCost cost;
+      if (m_callback_item_cost) {
+        cost = m_callback_item_cost(key, item);
+      }
+      bool can_add_item = true;
+      // Remove items if cache is full, or if the process is over its budget
+      // and evicting from this cache can bring it back under
+      auto cost_of_item = [this](const KeyType& k) {
+        return m_item_costs.at(k);
+      };
+      const bool evict_for_budget =
+          NGraphCacheBudget::WouldExceed(cost.Bytes()) &&
+          !NGraphCacheBudget::WouldExceed(cost.Bytes() - ChargedBytesLocked());
+      if (NGraphCacheBudget::WouldExceed(cost.Bytes()) && !evict_for_budget) {
+        NGRAPH_VLOG(1) << "NGRAPH_TF_CACHE_PROFILE: Over the cache budget "
+                          "because of the other caches, not evicting";
+      }
+      while (!m_lru.Empty() &&
+             (m_ng_items_map.size() >= m_depth ||
+              (evict_for_budget &&
+               NGraphCacheBudget::WouldExceed(cost.Bytes())))) {
+        Status status_evict =
+            EvictItem(m_lru.SelectVictim(cost_of_item), callback_destroy_item);
+        if (status_evict != Status::OK()) {
+          status_item_pair.first = status_evict;
+          can_add_item = false;
+          break;
         }
-        m_ng_items_map.erase(key_to_evict);
-        m_lru.pop_back();
       }
       // Add item to cache
-      auto it = m_ng_items_map.emplace(key, item);
-      if (it.second == true) {
-        m_lru.push_front(key);
-      } else {
-        auto key_itr = find(m_lru.begin(), m_lru.end(), key);
-        m_lru.erase(key_itr);
-        m_lru.push_front(key);
+      if (can_add_item) {
+        m_ng_items_map[key] = item;
+        m_item_costs[key] = cost;
+        m_lru.Touch(key);
+        NGraphCacheBudget::Charge(cost.Bytes());
+      }
+      if (m_ng_items_map.size() != m_lru.Size()) {
+        status_item_pair.first = errors::Internal(
+            "Error occured: size of m_ng_items_map is not same as that of "
+            "m_lru");
       }
-    }  // lock ends here.
-
-    if (m_ng_items_map.size() != m_lru.size()) {
-      return std::make_pair(
-          errors::Internal("Error occured: size of m_ng_items_map is not same "
-                           "as that of m_lru"),
-          item);
     }
-    return std::make_pair(Status::OK(), item);
-  }
+    // Hand the result over to the threads waiting for it
+    in_flight->result = status_item_pair;
+    in_flight->done = true;
+    m_in_flight_items.erase(key);
+  }  // lock ends here.
 
   return status_item_pair;
 }
@@ -30,6 +30,7 @@
 #include "logging/ngraph_log.h"
 #include "ngraph_bridge/ngraph_api.h"
 #include "ngraph_bridge/ngraph_assign_clusters.h"
+#include "ngraph_bridge/ngraph_cluster_cost_model.h"
 #include "ngraph_bridge/ngraph_deassign_clusters.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
 #include "ngraph_bridge/ngraph_utils.h"
@@ -42,20 +43,22 @@ namespace ngraph_bridge {
 
 //
 // The clustering pass of ngraph_assign_clusters.cc sometimes generates many
-// small, trivial clusters. In this pass, we simply deassign (i.e., remove the
-// _ngraph_cluster and _ngraph_marked_for_clustering attributes) any such
-// trivial clusters. For now, "trivial" just means that there are not at least
-// two non-trivial ops in the graph, where a "trivial op" means "Const" or
-// "Identity".
+// small, trivial clusters, or clusters that cost more to copy the inputs and
+// outputs of than they compute. In this pass, we simply deassign (i.e.,
+// remove the _ngraph_cluster and _ngraph_marked_for_clustering attributes)
+// any cluster the NGraphClusterCostModel does not keep. The default model
+// drops the clusters with less than two non-trivial ops, where a "trivial
+// op" means "Const" or "Identity", and the ones doing too few flops for the
+// bytes crossing their boundary.
 //
 // For unit testing purposes, this pass can be bypassed by setting
 // NGRAPH_TF_DISABLE_DEASSIGN_CLUSTERS=1.
 //
 
-static const int MIN_NONTRIVIAL_NODES = 2;
-
 unordered_map<string, int> deassigned_histogram;
 int num_nodes_marked_before_deassign = 0;
+// Estimated costs of the clusters before deassign
+std::map<int, NGraphClusterCost> cluster_costs;
 
 static void MaybeLogPlacement(const Graph* graph) {
   if (!config::IsLoggingPlacement()) return;
@@ -122,6 +125,23 @@ static void MaybeLogPlacement(const Graph* graph) {
     }
   }
 
+  for (const auto& kv : cluster_costs) {
+    const NGraphClusterCost& cost = kv.second;
+    std::cout << "NGTF_SUMMARY: Cost of nGraph Cluster[" << kv.first
+              << "]:\tflops " << cost.flops << ", transfer bytes "
+              << cost.transfer_bytes << ", estimated benefit " << cost.benefit
+              << (cost.shapes_known ? "" : " (shapes unknown)");
+    if (cost.ngraph_step_us >= 0) {
+      std::cout << ", measured step " << cost.ngraph_step_us << " us";
+    }
+    if (cost.tf_step_us >= 0) {
+      std::cout << ", measured TensorFlow step " << cost.tf_step_us << " us";
+    }
+    std::cout << (final_cluster_map.count(kv.first) != 0 ? ", kept"
+                                                         : ", deassigned")
+              << std::endl;
+  }
+
   // log the ops gets deassigned
   std::cout << "NGTF_SUMMARY: Op_deassigned: ";
   print_node_histogram(deassigned_histogram);
@@ -145,13 +165,15 @@ static void MaybeLogPlacement(const Graph* graph) {
   std::cout << endl;
 }
 
-Status DeassignClusters(Graph* graph) {
+Status DeassignClusters(Graph* graph,
+                        NGraphClusterCostModel* cost_model) {
   //
   // When running unit tests, we do not want to see trivial clusters
   // deassigned. This flag (used by the Python tests) makes this possible.
   //
   num_nodes_marked_before_deassign = 0;  // reset for every TF graph
   deassigned_histogram.clear();          // reset the histogram
+  cluster_costs.clear();
 
   if (std::getenv("NGRAPH_TF_DISABLE_DEASSIGN_CLUSTERS") != nullptr) {
     // still need to calculate num_nodes_marked_before_deassign
@@ -179,20 +201,21 @@ Status DeassignClusters(Graph* graph) {
     cluster_map[cluster_idx].insert(node);
   }
 
+  if (cost_model == nullptr) {
+    cost_model = &NGraphClusterCostModel::Get();
+  }
   for (auto& kv : cluster_map) {
     int cluster_idx = kv.first;
     std::set<Node*>& nodes = kv.second;
 
-    int non_trivial_count = 0;
-
-    for (auto node : nodes) {
-      // TODO(amprocte): less hard-coding here
-      if (node->type_string() != "Const" && node->type_string() != "Identity") {
-        non_trivial_count++;
-      }
-    }
+    NGraphClusterCost& cost = cluster_costs[cluster_idx];
+    TF_RETURN_IF_ERROR(cost_model->Estimate(nodes, cost));
+    NGRAPH_VLOG(2) << "Cluster " << cluster_idx << ": "
+                   << cost.num_nontrivial_nodes << " non trivial nodes, "
+                   << cost.flops << " flops, " << cost.transfer_bytes
+                   << " transfer bytes, benefit " << cost.benefit;
 
-    if (non_trivial_count < MIN_NONTRIVIAL_NODES) {
+    if (!cost_model->KeepCluster(cost)) {
       NGRAPH_VLOG(2) << "Busting cluster " << cluster_idx;
       for (auto node : nodes) {
         NGRAPH_VLOG(2) << "Busting node: " << node->name() << " ["
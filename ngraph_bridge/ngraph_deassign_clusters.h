@@ -20,11 +20,16 @@
 
 #include "tensorflow/core/graph/graph.h"
 
+#include "ngraph_bridge/ngraph_cluster_cost_model.h"
+
 namespace tensorflow {
 
 namespace ngraph_bridge {
 
-Status DeassignClusters(Graph* graph);
+// Deassigns the clusters cost_model does not keep, NGraphClusterCostModel::Get
+// by default
+Status DeassignClusters(Graph* graph,
+                        NGraphClusterCostModel* cost_model = nullptr);
 
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
@@ -73,6 +73,113 @@ static void AddInput(NodeDef* dst, StringPiece src_name, int src_slot) {
 }
 // ...end code copied and pasted (and modified) from graph.cc
 
+// Sets input_shapes to the shapes of the inputs of the encapsulate node, if
+// they are all known: from the shape hint if it has the node feeding the
+// input, or else from the shape attributes of that node. Returns an error
+// naming the first input whose shape is not known otherwise.
+static Status GetWarmUpShapes(const Node* node, const ShapeHintMap* hint,
+                              std::vector<TensorShape>& input_shapes) {
+  std::vector<int32> static_inputs;
+  GetStaticInputs(node, &static_inputs);
+  if (!static_inputs.empty()) {
+    return errors::Unimplemented("Encapsulate ", node->name(),
+                                 " has static inputs");
+  }
+
+  input_shapes.resize(node->num_inputs());
+  for (const Edge* edge : node->in_edges()) {
+    if (edge->IsControlEdge()) {
+      continue;
+    }
+    const Node* src = edge->src();
+    PartialTensorShape shape;
+    std::vector<PartialTensorShape> output_shapes;
+    if (hint != nullptr && hint->find(src->name()) != hint->end()) {
+      const vector<int>& dims = hint->at(src->name());
+      shape = PartialTensorShape(std::vector<int64>(dims.begin(), dims.end()));
+    } else if (GetNodeAttr(src->attrs(), "_output_shapes", &output_shapes)
+                   .ok() &&
+               edge->src_output() < output_shapes.size()) {
+      shape = output_shapes[edge->src_output()];
+    } else if (src->type_string() == "Placeholder") {
+      GetNodeAttr(src->attrs(), "shape", &shape);
+    }
+    if (!shape.AsTensorShape(&input_shapes[edge->dst_input()])) {
+      return errors::NotFound("Shape of input ", edge->dst_input(), " of ",
+                              node->name(), " (from ", src->name(),
+                              ") is not known");
+    }
+  }
+  return Status::OK();
+}
+
+// Adds a copy of node to cluster_graph, the graph of its cluster, with its
+// inputs renamed as in input_rename_map
+static void CopyNodeToClusterGraph(
+    const Node* node, int cluster_idx,
+    const std::map<std::tuple<int, std::string, int>, string>&
+        input_rename_map,
+    GraphDef* cluster_graph) {
+  // Because the input names may have changed from the original node def,
+  // we will need to borrow some code from Graph::ToGraphDefSubRange in
+  // tensorflow/core/graph/graph.cc that rewrites the node's input list.
+
+  // begin code copied and pasted (and modified) from graph.cc...
+  NodeDef original_def = node->def();
+
+  // Get the inputs for this Node.  We make sure control inputs are
+  // after data inputs, as required by GraphDef.
+  std::vector<const Edge*> inputs;
+  inputs.resize(node->num_inputs(), nullptr);
+  for (const Edge* edge : node->in_edges()) {
+    if (edge->IsControlEdge()) {
+      inputs.push_back(edge);
+    } else {
+      CHECK(inputs[edge->dst_input()] == nullptr)
+          << "Edge " << edge->src()->DebugString() << ":"
+          << edge->dst()->DebugString() << " with dst_input "
+          << edge->dst_input() << " and had pre-existing input edge "
+          << inputs[edge->dst_input()]->src()->DebugString() << ":"
+          << inputs[edge->dst_input()]->dst()->DebugString();
+
+      inputs[edge->dst_input()] = edge;
+    }
+  }
+  original_def.clear_input();
+  original_def.mutable_input()->Reserve(inputs.size());
+
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const Edge* edge = inputs[i];
+    if (edge == nullptr) {
+      if (i < node->requested_inputs().size()) {
+        original_def.add_input(node->requested_inputs()[i]);
+      } else {
+        original_def.add_input("");
+      }
+    } else {
+      const Node* src = edge->src();
+      if (!src->IsOp()) continue;
+      AddInput(&original_def, src->name(), edge->src_output());
+    }
+  }
+  // ...end code copied and pasted (and modified) from graph.cc
+
+  auto node_def = cluster_graph->add_node();
+  *node_def = original_def;
+
+  for (auto& input : *(node_def->mutable_input())) {
+    TensorId tensor_id = ParseTensorName(input);
+
+    string tensor_name(tensor_id.first);
+    auto it = input_rename_map.find(
+        std::make_tuple(cluster_idx, tensor_name, tensor_id.second));
+
+    if (it != input_rename_map.end()) {
+      input = it->second;
+    }
+  }
+}
+
 Status EncapsulateClusters(
     Graph* graph, int graph_id, FunctionDefLibrary* fdeflib,
     std::unordered_map<std::string, std::string> device_config,
@@ -421,8 +528,9 @@ Status EncapsulateClusters(
   }
 
   // Pass 5: Make copies of all clustered nodes inside the cluster graphs,
-  // rewiring the inputs in their NodeDefs as we go.
-  std::set<int> cluster_indices_for_this_graph;
+  // rewiring the inputs in their NodeDefs as we go. Each cluster graph is
+  // built by one task, with its nodes in the order of the graph.
+  std::map<int, std::vector<const Node*>> cluster_nodes;
   for (auto node : graph->op_nodes()) {
     int cluster_idx;
 
@@ -430,68 +538,26 @@ Status EncapsulateClusters(
         Status::OK()) {
       continue;
     }
+    cluster_nodes[cluster_idx].push_back(node);
+  }
 
-    // Because the input names may have changed from the original node def,
-    // we will need to borrow some code from Graph::ToGraphDefSubRange in
-    // tensorflow/core/graph/graph.cc that rewrites the node's input list.
-
-    // begin code copied and pasted (and modified) from graph.cc...
-    NodeDef original_def = node->def();
-
-    // Get the inputs for this Node.  We make sure control inputs are
-    // after data inputs, as required by GraphDef.
-    std::vector<const Edge*> inputs;
-    inputs.resize(node->num_inputs(), nullptr);
-    for (const Edge* edge : node->in_edges()) {
-      if (edge->IsControlEdge()) {
-        inputs.push_back(edge);
-      } else {
-        CHECK(inputs[edge->dst_input()] == nullptr)
-            << "Edge " << edge->src()->DebugString() << ":"
-            << edge->dst()->DebugString() << " with dst_input "
-            << edge->dst_input() << " and had pre-existing input edge "
-            << inputs[edge->dst_input()]->src()->DebugString() << ":"
-            << inputs[edge->dst_input()]->dst()->DebugString();
-
-        inputs[edge->dst_input()] = edge;
-      }
-    }
-    original_def.clear_input();
-    original_def.mutable_input()->Reserve(inputs.size());
-
-    for (size_t i = 0; i < inputs.size(); ++i) {
-      const Edge* edge = inputs[i];
-      if (edge == nullptr) {
-        if (i < node->requested_inputs().size()) {
-          original_def.add_input(node->requested_inputs()[i]);
-        } else {
-          original_def.add_input("");
-        }
-      } else {
-        const Node* src = edge->src();
-        if (!src->IsOp()) continue;
-        AddInput(&original_def, src->name(), edge->src_output());
-      }
-    }
-    // ...end code copied and pasted (and modified) from graph.cc
-
-    auto node_def =
-        NGraphClusterManager::GetClusterGraph(cluster_idx)->add_node();
-    cluster_indices_for_this_graph.insert(cluster_idx);
-    *node_def = original_def;
-
-    for (auto& input : *(node_def->mutable_input())) {
-      TensorId tensor_id = ParseTensorName(input);
-
-      string tensor_name(tensor_id.first);
-      auto it = input_rename_map.find(
-          std::make_tuple(cluster_idx, tensor_name, tensor_id.second));
-
-      if (it != input_rename_map.end()) {
-        input = it->second;
-      }
-    }
+  std::vector<int> cluster_indices_for_this_graph;
+  for (const auto& kv : cluster_nodes) {
+    cluster_indices_for_this_graph.push_back(kv.first);
   }
+  TF_RETURN_IF_ERROR(ParallelForEach(
+      cluster_indices_for_this_graph.size(), /*cost_per_unit=*/100000,
+      [&cluster_indices_for_this_graph, &cluster_nodes,
+       &input_rename_map](int64 i) {
+        int cluster_idx = cluster_indices_for_this_graph[i];
+        GraphDef* cluster_graph =
+            NGraphClusterManager::GetClusterGraph(cluster_idx);
+        for (auto node : cluster_nodes.at(cluster_idx)) {
+          CopyNodeToClusterGraph(node, cluster_idx, input_rename_map,
+                                 cluster_graph);
+        }
+        return Status::OK();
+      }));
 
   // Pass 6: Remove clustered nodes from the graph.
   std::vector<Node*> nodes_to_remove;
@@ -512,23 +578,31 @@ Status EncapsulateClusters(
 
   // Pass 7: Insert to function library
   // Note: We loop over cluster_indices_for_this_graph and not all the
-  // contents of ClusterManager
-  for (const auto& cluster_idx : cluster_indices_for_this_graph) {
-    // The transformation happening inside this loop is:
-    // graphdef --> graph --> functiondef
-    // NGraphClusterManager::GetClusterGraph(cluster_idx)-->subgraph-->fdef
-    // TODO: whats the right flib to use in subgraph's constructor?
-    Graph subgraph(graph->flib_def());
-    // TODO: When this works, NGraphClusterManager can go away
-    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(
-        GraphConstructorOptions(),
-        *(NGraphClusterManager::GetClusterGraph(cluster_idx)), &subgraph));
-    FunctionDef* fdef = fdeflib->add_function();
-    // TODO: if func lib has func with same name etc?
-    TF_RETURN_IF_ERROR(GraphToFunctionDef(
-        subgraph, strings::StrCat("ngraph_cluster_", to_string(cluster_idx)),
-        fdef));
+  // contents of ClusterManager. The FunctionDefs are added in the order of
+  // the clusters, then built in parallel.
+  std::vector<FunctionDef*> fdefs;
+  for (size_t i = 0; i < cluster_indices_for_this_graph.size(); i++) {
+    fdefs.push_back(fdeflib->add_function());
   }
+  TF_RETURN_IF_ERROR(ParallelForEach(
+      cluster_indices_for_this_graph.size(), /*cost_per_unit=*/1000000,
+      [&cluster_indices_for_this_graph, &fdefs, graph](int64 i) {
+        int cluster_idx = cluster_indices_for_this_graph[i];
+        // The transformation happening here is:
+        // graphdef --> graph --> functiondef
+        // NGraphClusterManager::GetClusterGraph(cluster_idx)-->subgraph-->fdef
+        // TODO: whats the right flib to use in subgraph's constructor?
+        Graph subgraph(graph->flib_def());
+        // TODO: When this works, NGraphClusterManager can go away
+        TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(
+            GraphConstructorOptions(),
+            *(NGraphClusterManager::GetClusterGraph(cluster_idx)), &subgraph));
+        // TODO: if func lib has func with same name etc?
+        return GraphToFunctionDef(
+            subgraph,
+            strings::StrCat("ngraph_cluster_", to_string(cluster_idx)),
+            fdefs[i]);
+      }));
 
   // Pass 8:
   bool aot_requested;
@@ -880,6 +954,31 @@ Status EncapsulateClusters(
   }  // end of if (aot_requested)
 
   // Pass 9 (optional, only run if environment variable
+  // NGRAPH_TF_EAGER_WARMUP is set): record on the encapsulates whose input
+  // shapes are all known what these shapes are, the encapsulate op then
+  // compiles for them as soon as it is created instead of on its first step.
+  // With shape hints, the first hint is used.
+  if (std::getenv("NGRAPH_TF_EAGER_WARMUP") != nullptr) {
+    const ShapeHintMap* warmup_hint = node_shapes_hints_sets.empty()
+                                          ? nullptr
+                                          : &(*node_shapes_hints_sets.begin());
+    for (auto node : graph->op_nodes()) {
+      if (node->type_string() != "NGraphEncapsulate") {
+        continue;
+      }
+      std::vector<TensorShape> input_shapes;
+      Status status = GetWarmUpShapes(node, warmup_hint, input_shapes);
+      if (status.ok()) {
+        node->AddAttr("_ngraph_warmup_shapes", input_shapes);
+        NGRAPH_VLOG(1) << "Eager warm-up of " << node->name();
+      } else {
+        NGRAPH_VLOG(1) << "No eager warm-up of " << node->name() << ": "
+                       << status.error_message();
+      }
+    }
+  }
+
+  // Pass 10 (optional, only run if environment variable
   // NGRAPH_TF_DUMP_CLUSTERS is set): validate the graph def, and
   // make sure we can construct a graph from it.
   if (std::getenv("NGRAPH_TF_DUMP_CLUSTERS")) {
@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  *******************************************************************************/
+#include <algorithm>
 #include <cstdlib>
 #include <mutex>
 #include <utility>
@@ -38,10 +39,13 @@
 #include "logging/ngraph_log.h"
 #include "ngraph_bridge/ngraph_backend_manager.h"
 #include "ngraph_bridge/ngraph_builder.h"
+#include "ngraph_bridge/ngraph_cache_budget.h"
 #include "ngraph_bridge/ngraph_cluster_manager.h"
 #include "ngraph_bridge/ngraph_encapsulate_impl.h"
 #include "ngraph_bridge/ngraph_encapsulate_op.h"
+#include "ngraph_bridge/ngraph_executable_disk_cache.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "ngraph_bridge/ngraph_runtime_config.h"
 #include "ngraph_bridge/ngraph_timer.h"
 #include "ngraph_bridge/ngraph_utils.h"
 
@@ -73,29 +77,18 @@ Status NGraphEncapsulateImpl::ComputeSignature(
     const std::vector<Tensor>& tf_input_tensors,
     std::vector<TensorShape>& input_shapes,
     std::vector<const Tensor*>& static_input_map,
-    std::stringstream& signature_ss) {
+    NGraphSignature& signature) {
   // Get the inputs
-  for (int i = 0; i < tf_input_tensors.size(); i++) {
-    const Tensor& input_tensor = tf_input_tensors[i];
-    input_shapes.push_back(input_tensor.shape());
-    for (const auto& x : input_tensor.shape()) {
-      signature_ss << x.size << ",";
-    }
-    signature_ss << ";";
-  }
-
-  signature_ss << "/";
-
   static_input_map.resize(tf_input_tensors.size());
   for (int i = 0; i < tf_input_tensors.size(); i++) {
     const Tensor& input_tensor = tf_input_tensors[i];
+    input_shapes.push_back(input_tensor.shape());
     if (m_input_is_static[i]) {
       static_input_map[i] = &input_tensor;
-      TF_RETURN_IF_ERROR(TensorToStream(signature_ss, input_tensor));
-      signature_ss << ";";
     }
   }
-  return Status::OK();
+  return NGraphSignature::Compute(tf_input_tensors, m_input_is_static,
+                                  signature);
 }
 
 // Calls ComputeSignature and gets ngraph executable
@@ -105,11 +98,9 @@ Status NGraphEncapsulateImpl::GetNgExecutable(
     std::vector<const Tensor*>& static_input_map,
     ng::runtime::Backend*& op_backend,
     std::shared_ptr<ngraph::runtime::Executable>& ng_exec) {
-  std::stringstream signature_ss;
-  string signature;
+  NGraphSignature signature;
 
   std::shared_ptr<ngraph::Function> ng_function;
-  std::shared_ptr<ngraph::runtime::Executable> evicted_ng_exec;
 
   NGRAPH_VLOG(4) << "GetNgExecutable: Got backend of type: "
                  << m_op_backend_name;
@@ -117,10 +108,9 @@ Status NGraphEncapsulateImpl::GetNgExecutable(
 
   // Compute Signature
   TF_RETURN_IF_ERROR(ComputeSignature(tf_input_tensors, input_shapes,
-                                      static_input_map, signature_ss));
-  signature = signature_ss.str();
+                                      static_input_map, signature));
 
-  NGRAPH_VLOG(5) << "Computed signature: " << signature;
+  NGRAPH_VLOG(5) << "Computed signature: " << signature.ToString();
 
   auto it = m_ng_exec_map.find(signature);
 
@@ -132,129 +122,168 @@ Status NGraphEncapsulateImpl::GetNgExecutable(
     // Measure the current total memory usage
     long vm, rss, vm0, rss0;
     MemoryProfile(vm0, rss0);
+    Timer compile_timer;
+    auto cost_of_signature = [this](const NGraphSignature& sig) {
+      return m_ng_exec_cost_map[m_ng_exec_map[sig]];
+    };
 
     NGRAPH_VLOG(1) << "Compilation cache miss: " << m_name;
-    string serialized_ng_func;
-    if (!m_do_aot) {
-      TF_RETURN_IF_ERROR(Builder::TranslateGraph(input_shapes, static_input_map,
-                                                 &m_graph, ng_function));
+
+    // The AOT executables and the disk cache entries are named by the text
+    // signature
+    auto disk_cache = NGraphExecutableDiskCache::Global();
+    string text_signature;
+    if (m_do_aot || disk_cache != nullptr) {
+      TF_RETURN_IF_ERROR(ComputeTextSignature(input_shapes, static_input_map,
+                                              text_signature));
+    }
+
+    // Look in the persistent executable cache first, a hit there skips both
+    // the translation and the compilation
+    string disk_cache_key;
+    if (disk_cache != nullptr && !m_do_aot) {
+      if (m_graph_fingerprint.empty()) {
+        m_graph_fingerprint =
+            NGraphExecutableDiskCache::GraphFingerprint(m_graph);
+      }
+      disk_cache_key = NGraphExecutableDiskCache::ComputeKey(
+          m_graph_fingerprint, m_op_backend_name, text_signature);
+      BackendManager::LockBackend(m_op_backend_name);
+      ng_exec = disk_cache->Load(disk_cache_key, op_backend);
+      BackendManager::UnlockBackend(m_op_backend_name);
+    }
+
+    NGraphFunctionRef ng_function_ref;
+    if (ng_exec != nullptr) {
+      NGRAPH_VLOG(1) << "Loaded executable from disk cache: " << m_name;
+    } else if (!m_do_aot) {
+      TF_RETURN_IF_ERROR(Builder::TranslateGraph(
+          input_shapes, static_input_map, &m_graph, ng_function,
+          &m_constant_pool, &m_translation_plan));
       ng_function->set_friendly_name(m_name);
-      int json_indentation = 4;
-      serialized_ng_func = ngraph::serialize(ng_function, json_indentation);
+      ng_function_ref = NGraphFunctionRef(ng_function);
     } else {
-      auto itr = m_aot_functions.find(signature);
+      auto itr = m_aot_functions.find(text_signature);
       if (itr == m_aot_functions.end()) {
         return errors::Internal(
             "Expected to find AOT precompiled ng function of signature: ",
-            signature);
+            text_signature);
       }
-      serialized_ng_func = itr->second;
+      ng_function_ref = NGraphFunctionRef(itr->second);
     }
 
     // Serialize to nGraph if needed
-    if (std::getenv("NGRAPH_ENABLE_SERIALIZE") != nullptr) {
-      std::string file_name = "tf_function_" + m_name + ".json";
+    const NGraphRuntimeConfig& runtime_config = NGraphRuntimeConfig::Get();
+    if (ng_exec == nullptr && runtime_config.enable_serialize) {
       TF_RETURN_IF_ERROR(
-          StringToFile("tf_function_" + m_name + ".json", serialized_ng_func));
+          ng_function_ref.ToFile("tf_function_" + m_name + ".json"));
 #if defined NGRAPH_DISTRIBUTED
       int rank_id;
       rank_id = ng::get_distributed_interface()->get_rank();
-      TF_RETURN_IF_ERROR(StringToFile(
-          "tf_function_" + m_name + "_" + to_string(rank_id) + ".json",
-          serialized_ng_func));
+      TF_RETURN_IF_ERROR(ng_function_ref.ToFile(
+          "tf_function_" + m_name + "_" + to_string(rank_id) + ".json"));
 #endif
     }
     // Evict the cache if the number of elements exceeds the limit
-    const char* cache_depth_specified =
-        std::getenv("NGRAPH_TF_FUNCTION_CACHE_ITEM_DEPTH");
-    if (cache_depth_specified != nullptr) {
-      my_function_cache_depth_in_items = atoi(cache_depth_specified);
+    if (runtime_config.function_cache_item_depth >= 0) {
+      my_function_cache_depth_in_items =
+          runtime_config.function_cache_item_depth;
     }
-    if (m_ng_exec_map.size() >= my_function_cache_depth_in_items) {
-      int input_tensors_bytes_free = 0;
-      evicted_ng_exec = m_ng_exec_map[m_lru.back()];
-      m_ng_exec_map.erase(m_lru.back());
-      m_serialized_ng_function_map.erase(evicted_ng_exec);
-
-      // Call delete function here for the erased func
-      op_backend->remove_compiled_function(evicted_ng_exec);
-      // Now clean the input cache
-      std::vector<std::pair<void*, std::shared_ptr<ng::runtime::Tensor>>>&
-          input_caches = m_ng_exec_input_cache_map[evicted_ng_exec];
-      for (auto& next_input : input_caches) {
-        input_tensors_bytes_free += next_input.second->get_size_in_bytes();
-        next_input.second.reset();
-      }
-      m_ng_exec_input_cache_map.erase(evicted_ng_exec);
-
-      // Clean the output cache
-      std::vector<std::pair<void*, std::shared_ptr<ng::runtime::Tensor>>>&
-          output_caches = m_ng_exec_output_cache_map[evicted_ng_exec];
-      int output_tensors_bytes_free = 0;
-      for (auto& next_output : output_caches) {
-        output_tensors_bytes_free += next_output.second->get_size_in_bytes();
-        next_output.second.reset();
-      }
-      m_ng_exec_output_cache_map.erase(evicted_ng_exec);
-      m_lru.pop_back();
-      NGRAPH_VLOG(1) << "NGRAPH_TF_MEM_PROFILE:  OP_ID: " << my_instance_id
-                     << " Cluster: " << m_name << " Input Tensors freed: "
-                     << input_tensors_bytes_free / (1024 * 1024) << " MB"
-                     << " Output Tensors freed: "
-                     << output_tensors_bytes_free / (1024 * 1024) << " MB";
+    while (!m_lru.Empty() &&
+           m_ng_exec_map.size() >= my_function_cache_depth_in_items) {
+      EvictNgExecutable(m_lru.SelectVictim(cost_of_signature), op_backend);
     }  // cache eviction if cache size greater than cache depth
 
-    ngraph::Event event_compile("Compile nGraph", m_name, "");
-    BackendManager::LockBackend(m_op_backend_name);
-    try {
-      if (m_do_aot) {
-        auto itr = m_aot_execs.find(signature);
-        if (itr == m_aot_execs.end()) {
-          BackendManager::UnlockBackend(m_op_backend_name);
-          return errors::Internal(
-              "Requested AOT, but could not find string with the "
-              "signature: ",
-              signature);
+    if (ng_exec == nullptr) {
+      ngraph::Event event_compile("Compile nGraph", m_name, "");
+      BackendManager::LockBackend(m_op_backend_name);
+      try {
+        if (m_do_aot) {
+          auto itr = m_aot_execs.find(text_signature);
+          if (itr == m_aot_execs.end()) {
+            BackendManager::UnlockBackend(m_op_backend_name);
+            return errors::Internal(
+                "Requested AOT, but could not find string with the "
+                "signature: ",
+                text_signature);
+          }
+          stringstream serialized_exec_read;
+          serialized_exec_read << (itr->second);
+          ng_exec = op_backend->load(serialized_exec_read);
+        } else {
+          ng_exec = op_backend->compile(ng_function);
         }
-        stringstream serialized_exec_read;
-        serialized_exec_read << (itr->second);
-        ng_exec = op_backend->load(serialized_exec_read);
-      } else {
-        ng_exec = op_backend->compile(ng_function);
+      } catch (const std::exception& exp) {
+        BackendManager::UnlockBackend(m_op_backend_name);
+        Status st =
+            ng_function_ref.ToFile("tf_function_error_" + m_name + ".json");
+        string status_string =
+            "Caught exception while compiling op_backend: " +
+            string(exp.what()) +
+            (st.ok() ? "" : (" Also error in dumping serialized function: " +
+                             st.error_message()));
+        return errors::Internal(status_string);
+      } catch (...) {
+        BackendManager::UnlockBackend(m_op_backend_name);
+        Status st =
+            ng_function_ref.ToFile("tf_function_error_" + m_name + ".json");
+        string status_string =
+            "Error in compiling op_backend." +
+            (st.ok() ? "" : (" Also error in dumping serialized function: " +
+                             st.error_message()));
+        return errors::Internal(status_string);
       }
-    } catch (const std::exception& exp) {
       BackendManager::UnlockBackend(m_op_backend_name);
-      Status st = StringToFile("tf_function_error_" + m_name + ".json",
-                               serialized_ng_func);
-      string status_string =
-          "Caught exception while compiling op_backend: " + string(exp.what()) +
-          (st.ok() ? "" : (" Also error in dumping serialized function: " +
-                           st.error_message()));
-      return errors::Internal(status_string);
-    } catch (...) {
-      BackendManager::UnlockBackend(m_op_backend_name);
-      Status st = StringToFile("tf_function_error_" + m_name + ".json",
-                               serialized_ng_func);
-      string status_string =
-          "Error in compiling op_backend." +
-          (st.ok() ? "" : (" Also error in dumping serialized function: " +
-                           st.error_message()));
-      return errors::Internal(status_string);
+      event_compile.Stop();
+      ngraph::Event::write_trace(event_compile);
+
+      // Persist the freshly compiled executable for the next process
+      if (!disk_cache_key.empty()) {
+        Status status_store = disk_cache->Store(disk_cache_key, ng_exec);
+        if (!status_store.ok()) {
+          NGRAPH_VLOG(0) << "Failed to write executable disk cache entry for "
+                         << m_name << ": " << status_store.error_message();
+        }
+      }
     }
-    BackendManager::UnlockBackend(m_op_backend_name);
-    event_compile.Stop();
-    ngraph::Event::write_trace(event_compile);
 
-    SetNgExecMap(signature, ng_exec);
-
-    // caching ng_function to serialize to ngraph if needed
-    m_serialized_ng_function_map[ng_exec] = serialized_ng_func;
-
-    m_lru.push_front(signature);
     // Memory after
     MemoryProfile(vm, rss);
     auto delta_vm_mem = vm - vm0;
     auto delta_res_mem = rss - rss0;
+
+    NGraphCacheItemCost cost;
+    // See NGraphCacheItemCost::executable_bytes. There is no function to
+    // estimate from for an AOT or disk cache executable.
+    if (ng_function != nullptr) {
+      cost.executable_bytes =
+          EstimateExecutableBytes(ng_function, &m_constant_pool);
+    } else {
+      NGRAPH_VLOG(1) << "No function to estimate the executable bytes of "
+                     << m_name << " from, charging 0";
+    }
+    cost.compile_time_ms = compile_timer.ElapsedInMS();
+    // Make room if the cached executables of the process are over budget,
+    // unless even an empty cache would not be under it: the other caches
+    // hold the budget then, and this one is not flushed for nothing
+    int64 cached_bytes = 0;
+    for (const auto& exec_cost : m_ng_exec_cost_map) {
+      cached_bytes += exec_cost.second.Bytes();
+    }
+    if (!NGraphCacheBudget::WouldExceed(cost.Bytes() - cached_bytes)) {
+      while (!m_lru.Empty() && NGraphCacheBudget::WouldExceed(cost.Bytes())) {
+        EvictNgExecutable(m_lru.SelectVictim(cost_of_signature), op_backend);
+      }
+    }
+
+    SetNgExecMap(signature, ng_exec);
+
+    // caching ng_function to serialize to ngraph if needed
+    m_ng_function_ref_map[ng_exec] = ng_function_ref;
+
+    m_ng_exec_cost_map[ng_exec] = cost;
+    NGraphCacheBudget::Charge(cost.Bytes());
+    m_lru.Touch(signature);
     NGRAPH_VLOG(1) << "NGRAPH_TF_CACHE_PROFILE: OP_ID: " << my_instance_id
                    << " Cache length: " << m_ng_exec_map.size()
                    << " Cluster: " << m_name << " Delta VM: " << delta_vm_mem
@@ -265,15 +294,54 @@ Status NGraphEncapsulateImpl::GetNgExecutable(
   else {
     // Found the input signature in m_ng_exec_map, use the cached executable
     // Update the m_lru
-    if (signature != m_lru.front()) {
-      m_lru.remove(signature);
-      m_lru.push_front(signature);
-    }
+    m_lru.Touch(signature);
     ng_exec = it->second;
   }
   return Status::OK();
 }
 
+// Removes the executable of the signature from the cache, along with the
+// tensors held for it
+void NGraphEncapsulateImpl::EvictNgExecutable(
+    const NGraphSignature& signature, ng::runtime::Backend* const op_backend) {
+  int input_tensors_bytes_free = 0;
+  std::shared_ptr<ngraph::runtime::Executable> evicted_ng_exec =
+      m_ng_exec_map[signature];
+  m_ng_exec_map.erase(signature);
+  m_ng_function_ref_map.erase(evicted_ng_exec);
+
+  // Call delete function here for the erased func
+  op_backend->remove_compiled_function(evicted_ng_exec);
+  // Now clean the input cache
+  std::vector<std::pair<void*, std::shared_ptr<ng::runtime::Tensor>>>&
+      input_caches = m_ng_exec_input_cache_map[evicted_ng_exec];
+  for (auto& next_input : input_caches) {
+    input_tensors_bytes_free += next_input.second->get_size_in_bytes();
+    next_input.second.reset();
+  }
+  m_ng_exec_input_cache_map.erase(evicted_ng_exec);
+
+  // Clean the output cache
+  std::vector<std::pair<void*, std::shared_ptr<ng::runtime::Tensor>>>&
+      output_caches = m_ng_exec_output_cache_map[evicted_ng_exec];
+  int output_tensors_bytes_free = 0;
+  for (auto& next_output : output_caches) {
+    output_tensors_bytes_free += next_output.second->get_size_in_bytes();
+    next_output.second.reset();
+  }
+  m_ng_exec_output_cache_map.erase(evicted_ng_exec);
+  m_executable_pipelined_tensors_map.erase(evicted_ng_exec);
+
+  NGraphCacheBudget::Release(m_ng_exec_cost_map[evicted_ng_exec].Bytes());
+  m_ng_exec_cost_map.erase(evicted_ng_exec);
+  m_lru.Remove(signature);
+  NGRAPH_VLOG(1) << "NGRAPH_TF_MEM_PROFILE:  OP_ID: " << my_instance_id
+                 << " Cluster: " << m_name << " Input Tensors freed: "
+                 << input_tensors_bytes_free / (1024 * 1024) << " MB"
+                 << " Output Tensors freed: "
+                 << output_tensors_bytes_free / (1024 * 1024) << " MB";
+}
+
 // Allocate tensors for input arguments. Creates ngraph input tensors using
 // tensorflow tensors required to execute ngraph function
 Status NGraphEncapsulateImpl::AllocateNGInputTensors(
@@ -573,9 +641,16 @@ Status NGraphEncapsulateImpl::UpdatePipelinedTensorCache(
         pipelined_output_tensors[j].push_back(temp[j]);
       }
     }
-    m_executable_pipelined_tensors_map.insert(
+    auto pts_itr = m_executable_pipelined_tensors_map.insert(
         {ng_exec, PipelinedTensorsStore(pipelined_input_tensors,
                                         pipelined_output_tensors)});
+    // The pipelined tensors are part of the cost of caching the executable
+    auto cost_itr = m_ng_exec_cost_map.find(ng_exec);
+    if (cost_itr != m_ng_exec_cost_map.end()) {
+      int64 tensor_bytes = pts_itr.first->second.get_size_in_bytes();
+      cost_itr->second.tensor_bytes += tensor_bytes;
+      NGraphCacheBudget::Charge(tensor_bytes);
+    }
   }
   return Status::OK();
 }
@@ -585,38 +660,34 @@ NGraphEncapsulateImpl::GetTensorsFromPipeline(
     std::shared_ptr<ngraph::runtime::Executable> ng_exec) {
   PipelinedTensorsStore pts = m_executable_pipelined_tensors_map.at(ng_exec);
 
-  // TODO: do something about this spin lock
-  // get_tensors returns an index integer, that can be -1, 0, ... depth-1
-  // If it returns -1, then it indicates there are no free groups of tensors
-  // or the pipeline is full. In that case, we need to wait, hence the while
-  std::tuple<int, PipelinedTensorVector, PipelinedTensorVector> out_tpl;
-  while (true) {
-    out_tpl = pts.get_tensors();
-
-    if (std::get<0>(out_tpl) >= 0) {
-      break;
-    }
-  }
-  return out_tpl;
+  // get_tensors returns an index integer, that can be 0, ... depth-1
+  // If there are no free groups of tensors i.e. the pipeline is full, it
+  // waits for a group to be returned
+  return pts.get_tensors(-1, nullptr);
 }
 
 Status NGraphEncapsulateImpl::DumpNgFunction(
     const string& file_name,
     std::shared_ptr<ngraph::runtime::Executable> ng_exec) {
-  auto itr = m_serialized_ng_function_map.find(ng_exec);
-  if (itr == m_serialized_ng_function_map.end()) {
+  auto itr = m_ng_function_ref_map.find(ng_exec);
+  if (itr == m_ng_function_ref_map.end()) {
     return errors::Internal(
-        "Did not find requested executable in map for exec->serialized ngraph "
-        "function when dumping ngraph function");
+        "Did not find requested executable in map for exec->ngraph function "
+        "when dumping ngraph function");
   }
-  return StringToFile(file_name, itr->second);
+  return itr->second.ToFile(file_name);
 }
 
 void NGraphEncapsulateImpl::NGraphEncapsulateImpl::ClearExecMaps() {
+  for (const auto& exec_cost : m_ng_exec_cost_map) {
+    NGraphCacheBudget::Release(exec_cost.second.Bytes());
+  }
+  m_ng_exec_cost_map.clear();
+  m_lru.Clear();
   m_ng_exec_input_cache_map.clear();
   m_ng_exec_output_cache_map.clear();
   m_ng_exec_map.clear();
-  m_serialized_ng_function_map.clear();
+  m_ng_function_ref_map.clear();
   m_executable_pipelined_tensors_map.clear();
 }
 
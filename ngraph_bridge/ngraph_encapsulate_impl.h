@@ -27,8 +27,13 @@
 #include "ngraph/ngraph.hpp"
 
 #include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_builder.h"
+#include "ngraph_bridge/ngraph_cache_lru.h"
+#include "ngraph_bridge/ngraph_constant_pool.h"
 #include "ngraph_bridge/ngraph_freshness_tracker.h"
 #include "ngraph_bridge/ngraph_pipelined_tensors.h"
+#include "ngraph_bridge/ngraph_signature.h"
+#include "ngraph_bridge/ngraph_utils.h"
 
 namespace tensorflow {
 
@@ -48,7 +53,7 @@ class NGraphEncapsulateImpl {
   Status ComputeSignature(const std::vector<Tensor>& tf_input_tensors,
                           std::vector<TensorShape>& input_shapes,
                           std::vector<const Tensor*>& static_input_map,
-                          std::stringstream& signature_ss);
+                          NGraphSignature& signature);
 
   // Calls Compute Signature and gets ngraph executable
   Status GetNgExecutable(const std::vector<Tensor>& tf_input_tensors,
@@ -155,12 +160,13 @@ class NGraphEncapsulateImpl {
     m_input_is_static[index] = value;
   }
 
-  std::unordered_map<std::string, std::shared_ptr<ngraph::runtime::Executable>>
+  std::unordered_map<NGraphSignature,
+                     std::shared_ptr<ngraph::runtime::Executable>>
   GetNgExecMap() {
     return m_ng_exec_map;
   }
 
-  void SetNgExecMap(const std::string& ng_map_key,
+  void SetNgExecMap(const NGraphSignature& ng_map_key,
                     const std::shared_ptr<ngraph::runtime::Executable>& exec) {
     m_ng_exec_map[ng_map_key] = exec;
   }
@@ -186,7 +192,7 @@ class NGraphEncapsulateImpl {
   void ClearNgExecOutputCache() { m_ng_exec_output_cache_map.clear(); }
 
   void ClearNgExecSerializedFunctionCache() {
-    m_serialized_ng_function_map.clear();
+    m_ng_function_ref_map.clear();
   }
 
   NGraphFreshnessTracker* GetNgraphFreshnessTracker() {
@@ -226,17 +232,30 @@ class NGraphEncapsulateImpl {
   std::stringstream copy_log_str;
   bool log_copies = false;
   std::vector<bool> m_input_is_static;
-  std::list<std::string> m_lru;
+  NGraphLRU<NGraphSignature> m_lru;
   static int s_instance_count;
   bool m_do_aot = false;
   map<string, string> m_aot_functions;
   map<string, string> m_aot_execs;
+  // Hash of m_graph, used to key the executable disk cache
+  string m_graph_fingerprint;
+  // Values of the Const nodes of m_graph, shared by the functions of all the
+  // signatures
+  NGraphConstantPool m_constant_pool;
+  // Order and handlers of the ops of m_graph, shared by the translations of
+  // all the signatures
+  Builder::TranslationPlan m_translation_plan;
 
   // ng_function, ng_executable, Output and Input Cache maps
-  std::unordered_map<std::string, std::shared_ptr<ngraph::runtime::Executable>>
+  std::unordered_map<NGraphSignature,
+                     std::shared_ptr<ngraph::runtime::Executable>>
       m_ng_exec_map;
-  std::unordered_map<std::shared_ptr<ngraph::runtime::Executable>, std::string>
-      m_serialized_ng_function_map;
+  std::unordered_map<std::shared_ptr<ngraph::runtime::Executable>,
+                     NGraphFunctionRef>
+      m_ng_function_ref_map;
+  std::unordered_map<std::shared_ptr<ngraph::runtime::Executable>,
+                     NGraphCacheItemCost>
+      m_ng_exec_cost_map;
 
   NgFunctionIOCache m_ng_exec_input_cache_map;
   NgFunctionIOCache m_ng_exec_output_cache_map;
@@ -254,6 +273,8 @@ class NGraphEncapsulateImpl {
 
   Status UpdatePipelinedTensorCache(
       std::shared_ptr<ngraph::runtime::Executable> ng_exec);
+  void EvictNgExecutable(const NGraphSignature& signature,
+                         ng::runtime::Backend* const op_backend);
   std::tuple<int, PipelinedTensorVector, PipelinedTensorVector>
   GetTensorsFromPipeline(std::shared_ptr<ngraph::runtime::Executable> ng_exec);
 
@@ -40,6 +40,7 @@
 #include "ngraph_bridge/ngraph_backend_manager.h"
 #include "ngraph_bridge/ngraph_builder.h"
 #include "ngraph_bridge/ngraph_cluster_manager.h"
+#include "ngraph_bridge/ngraph_cluster_profile.h"
 #include "ngraph_bridge/ngraph_encapsulate_impl.h"
 #include "ngraph_bridge/ngraph_encapsulate_op.h"
 #include "ngraph_bridge/ngraph_encapsulate_op_utils.h"
@@ -47,6 +48,8 @@
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
 #include "ngraph_bridge/ngraph_pipelined_tensors.h"
 #include "ngraph_bridge/ngraph_prefetch_shared_data.h"
+#include "ngraph_bridge/ngraph_runtime_config.h"
+#include "ngraph_bridge/ngraph_shape_bucketing.h"
 #include "ngraph_bridge/ngraph_timer.h"
 #include "ngraph_bridge/ngraph_utils.h"
 #include "ngraph_bridge/ngraph_var.h"
@@ -147,10 +150,10 @@ void NGraphEncapsulateOp::CreateParallelExecutor(OpKernelConstruction* ctx,
 
   const int cache_depth = 16;
   int my_function_cache_depth_in_items = cache_depth;
-  const char* cache_depth_specified =
-      std::getenv("NGRAPH_TF_FUNCTION_CACHE_ITEM_DEPTH");
-  if (cache_depth_specified != nullptr) {
-    my_function_cache_depth_in_items = atoi(cache_depth_specified);
+  const int cache_depth_specified =
+      NGraphRuntimeConfig::Get().function_cache_item_depth;
+  if (cache_depth_specified >= 0) {
+    my_function_cache_depth_in_items = cache_depth_specified;
   }
 
   // Create the Executor object
@@ -167,6 +170,19 @@ void NGraphEncapsulateOp::CreateParallelExecutor(OpKernelConstruction* ctx,
                   "Num of outputs from TensorManager and Ctx do not match"));
   s_instance_id++;
 
+  // Profiling runs every other step with the TensorFlow kernels
+  if (NGraphClusterProfile::IsRecording() &&
+      !m_parallel_executor->CanUseFallback()) {
+    NGRAPH_VLOG(1) << "Not profiling " << name()
+                   << " since it has variables or prefetched inputs";
+  } else if (NGraphClusterProfile::IsRecording()) {
+    m_profile_key = NGraphClusterProfile::ClusterKey(
+        m_parallel_executor->GetClusterNodeNames());
+    NGRAPH_VLOG(1) << "Profiling " << name() << " as cluster "
+                   << m_profile_key;
+    NGraphClusterProfile::AddRecorder();
+  }
+
   // Get the optional attributes
   std::unordered_map<std::string, std::string> additional_attribute_map;
   auto node_def = ctx->def();
@@ -174,6 +190,14 @@ void NGraphEncapsulateOp::CreateParallelExecutor(OpKernelConstruction* ctx,
                           node_def.attr(), &additional_attribute_map));
   // SetConfig will be called for each EncapsulateOp
   BackendManager::SetConfig(backend_name, additional_attribute_map);
+
+  // The rewrite pass records the input shapes when they are known and eager
+  // warm-up is requested, compile for them now rather than on the first step
+  if (HasNodeAttr(node_def, "_ngraph_warmup_shapes")) {
+    std::vector<TensorShape> warmup_shapes;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("_ngraph_warmup_shapes", &warmup_shapes));
+    OP_REQUIRES_OK(ctx, m_parallel_executor->WarmUp(warmup_shapes));
+  }
 }
 
 //---------------------------------------------------------------------------
@@ -322,6 +346,13 @@ NGraphEncapsulateOp::~NGraphEncapsulateOp() {
   ngraph::Event event(oss.str(), name(), "");
   NGRAPH_VLOG(2) << "~NGraphEncapsulateOp::" << name();
 
+  if (!m_profile_key.empty()) {
+    Status status = NGraphClusterProfile::RemoveRecorder();
+    if (!status.ok()) {
+      NGRAPH_VLOG(0) << "Cluster profile not written: " << status;
+    }
+  }
+
   if (m_use_parallel_executor) {
     NGRAPH_VLOG(2)
         << "~NGraphEncapsulateOp():: ParallelExecutor: ReleaseBackend";
@@ -394,14 +425,31 @@ NGraphEncapsulateOp::~NGraphEncapsulateOp() {
 }
 
 //---------------------------------------------------------------------------
-// OpKernel::Compute
+// AsyncOpKernel::ComputeAsync
 //---------------------------------------------------------------------------
-void NGraphEncapsulateOp::Compute(OpKernelContext* ctx) {
+void NGraphEncapsulateOp::ComputeAsync(OpKernelContext* ctx,
+                                       DoneCallback done) {
   ngraph::Event event_compute("NGEncap::Compute::" + name(), name(), "");
 
   if (m_use_parallel_executor) {
+    // While profiling, every other step times the TensorFlow kernels
+    if (!m_profile_key.empty() &&
+        m_profile_tf_steps < NGraphClusterProfile::GetTensorFlowSteps() &&
+        m_profile_steps++ % 2 == 1) {
+      event_compute.Stop();
+      ngraph::Event::write_trace(event_compute);
+      ComputeUsingFallback(ctx, std::move(done));
+      return;
+    }
     NGRAPH_VLOG(1) << "NGraphEncapsulateOp::Compute: Using Parallel Executor";
-    ComputeUsingParallelExecutor(ctx);
+    bool run_fallback = false;
+    ComputeUsingParallelExecutor(ctx, &run_fallback);
+    if (run_fallback) {
+      event_compute.Stop();
+      ngraph::Event::write_trace(event_compute);
+      ComputeUsingFallback(ctx, std::move(done));
+      return;
+    }
   } else {
     NGRAPH_VLOG(1) << "NGraphEncapsulateOp::Compute: Using Legacy Executor";
     ComputeUsingLegacyExecutor(ctx);
@@ -409,12 +457,14 @@ void NGraphEncapsulateOp::Compute(OpKernelContext* ctx) {
 
   event_compute.Stop();
   ngraph::Event::write_trace(event_compute);
+  done();
 }
 
 //---------------------------------------------------------------------------
 // ComputeUsingParallelExecutor
 //---------------------------------------------------------------------------
-void NGraphEncapsulateOp::ComputeUsingParallelExecutor(OpKernelContext* ctx) {
+void NGraphEncapsulateOp::ComputeUsingParallelExecutor(OpKernelContext* ctx,
+                                                       bool* run_fallback) {
   NGRAPH_VLOG(1) << "Compute using Parallel Executor " << name();
   // TF input tensors
   std::vector<Tensor> tf_input_tensors;
@@ -428,16 +478,36 @@ void NGraphEncapsulateOp::ComputeUsingParallelExecutor(OpKernelContext* ctx) {
     tf_input_tensors.push_back(ctx->input(i));
   }
 
+  // Round the input shapes up to their buckets, if requested. The outputs
+  // are then sliced back along output_bucketed_dims
+  std::vector<BucketedDims> output_bucketed_dims;
+  OP_REQUIRES_OK(ctx, m_parallel_executor->BucketInputTensors(
+                          tf_input_tensors, output_bucketed_dims));
+
   // Get ngraph executable,function and Pipelined Tensor Store
   ngraph::Event event_get_ng_item("GetExecutableAndTensors", "", "");
+  Timer get_ng_item_timer;
   std::shared_ptr<ngraph::runtime::Executable> ng_exec;
-  std::string serialized_ng_function;
+  NGraphFunctionRef ng_function_ref;
   shared_ptr<PipelinedTensorsStore> pipelined_tensor_store;
   bool cache_hit;
 
-  OP_REQUIRES_OK(ctx, m_parallel_executor->GetExecutableFunctionAndTensors(
-                          tf_input_tensors, ng_exec, serialized_ng_function,
-                          pipelined_tensor_store, cache_hit));
+  if (m_parallel_executor->IsAsyncCompileEnabled()) {
+    OP_REQUIRES_OK(ctx,
+                   m_parallel_executor->GetExecutableFunctionAndTensorsAsync(
+                       tf_input_tensors, ng_exec, ng_function_ref,
+                       pipelined_tensor_store, cache_hit));
+    if (ng_exec == nullptr) {
+      event_get_ng_item.Stop();
+      ngraph::Event::write_trace(event_get_ng_item);
+      *run_fallback = true;
+      return;
+    }
+  } else {
+    OP_REQUIRES_OK(ctx, m_parallel_executor->GetExecutableFunctionAndTensors(
+                            tf_input_tensors, ng_exec, ng_function_ref,
+                            pipelined_tensor_store, cache_hit));
+  }
   NGRAPH_VLOG(2) << "CACHE HIT: " << PrintBool(cache_hit) << endl;
   NGRAPH_VLOG(2) << " Step_ID: " << ctx->step_id();
 
@@ -446,15 +516,20 @@ void NGraphEncapsulateOp::ComputeUsingParallelExecutor(OpKernelContext* ctx) {
       << m_parallel_executor->GetNgraphClusterId();
 
   event_get_ng_item.Stop();
+  get_ng_item_timer.Stop();
   ngraph::Event::write_trace(event_get_ng_item);
 
   // Error check for pipelined tensors and pipeline depth
-  OP_REQUIRES(ctx, m_parallel_executor->GetTensorPipelineDepth() == 2,
-              errors::Internal("Pipeline Depth is not 2, got ",
-                               m_parallel_executor->GetTensorPipelineDepth()));
+  OP_REQUIRES(ctx, m_parallel_executor->GetTensorPipelineDepth() ==
+                       pipelined_tensor_store->get_depth(),
+              errors::Internal("Pipeline Depth is ",
+                               m_parallel_executor->GetTensorPipelineDepth(),
+                               " but the pipelined tensor store has depth ",
+                               pipelined_tensor_store->get_depth()));
 
   // Get Tensor Manager and some error checking
   ngraph::Event event_prepare_ng_tensors("Prepare NG In/Out Tensors", "", "");
+  Timer prepare_ng_tensors_timer;
   auto tensor_manager = m_parallel_executor->GetTensorManager();
   int num_of_inputs = tensor_manager->GetNumberOfInputs();
   int num_of_outputs = tensor_manager->GetNumberOfOutputs();
@@ -501,46 +576,12 @@ void NGraphEncapsulateOp::ComputeUsingParallelExecutor(OpKernelContext* ctx) {
                           ctx, tensor_manager, get<1>(pipelined_io_tensors),
                           get<2>(pipelined_io_tensors), ng_inputs, ng_outputs));
   event_prepare_ng_tensors.Stop();
+  prepare_ng_tensors_timer.Stop();
   ngraph::Event::write_trace(event_prepare_ng_tensors);
 
-  // And execute
-  ngraph::Event event_execute_graph(
-      "Execute Graph Pipeline Indx" + to_string(current_iter_pipeline_depth),
-      "", "");
-
-  BackendManager::LockBackend(m_parallel_executor->GetOpBackendName());
-  NGRAPH_VLOG(4) << "NGraphEncapsulateOp::Compute call starting for cluster "
-                 << m_parallel_executor->GetNgraphClusterId();
-  try {
-    ng_exec->call(ng_outputs, ng_inputs);
-  } catch (const std::exception& exp) {
-    BackendManager::UnlockBackend(m_parallel_executor->GetOpBackendName());
-    Status st =
-        StringToFile("tf_function_error" + ctx->op_kernel().name() + ".json",
-                     serialized_ng_function);
-    string status_string =
-        "Caught exception while executing nGraph computation: " +
-        string(exp.what()) +
-        (st.ok() ? "" : (" Also error in dumping serialized function: " +
-                         st.error_message()));
-    OP_REQUIRES(ctx, false, errors::Internal(status_string));
-  } catch (...) {
-    BackendManager::UnlockBackend(m_parallel_executor->GetOpBackendName());
-    Status st =
-        StringToFile("tf_function_error" + ctx->op_kernel().name() + ".json",
-                     serialized_ng_function);
-    string status_string =
-        "Error in executing the nGraph computation." +
-        (st.ok() ? "" : (" Also error in dumping serialized function: " +
-                         st.error_message()));
-    OP_REQUIRES(ctx, false, errors::Internal(status_string));
-  }
-  BackendManager::UnlockBackend(m_parallel_executor->GetOpBackendName());
-  event_execute_graph.Stop();
-  ngraph::Event::write_trace(event_execute_graph);
-
   // Now prepare the output
-  // Allocate TF Tensors
+  // Allocate TF Tensors, before the execution so that nGraph can write to
+  // them directly
   NGRAPH_VLOG(4) << "NGraphEncapsulateOp::Compute Allocating TF Output Tensors "
                  << m_parallel_executor->GetNgraphClusterId();
 
@@ -558,6 +599,10 @@ void NGraphEncapsulateOp::ComputeUsingParallelExecutor(OpKernelContext* ctx) {
       dims.push_back(dim);
     }
     TensorShape tf_shape(dims);
+    if (!output_bucketed_dims.empty()) {
+      tf_shape = NGraphShapeBucketing::UnpaddedShape(tf_shape,
+                                                     output_bucketed_dims[i]);
+    }
     Tensor* tf_output_tensor = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(i, tf_shape, &tf_output_tensor));
     tf_output_tensors.push_back(tf_output_tensor);
@@ -573,30 +618,119 @@ void NGraphEncapsulateOp::ComputeUsingParallelExecutor(OpKernelContext* ctx) {
                          "the element type expected by TensorFlow"));
   }
 
+  // On host memory backends the outputs that would be copied to TF are
+  // computed in place instead, into ng tensors wrapping the TF buffers. Not
+  // for outputs that need their bucketing padding sliced off.
+  vector<bool> output_is_zero_copy(num_of_outputs, false);
+  if (m_parallel_executor->IsZeroCopyOutputEnabled() &&
+      output_bucketed_dims.empty()) {
+    ng::runtime::Backend* op_backend =
+        BackendManager::GetBackend(m_parallel_executor->GetOpBackendName());
+    for (auto output_index : tensor_manager->GetOutputIndexesThatNeedCopy()) {
+      Tensor* tf_output_tensor = tf_output_tensors[output_index];
+      if (tf_output_tensor->NumElements() == 0) {
+        continue;
+      }
+      auto ng_element = ng_exec->get_results()[output_index];
+      ng_outputs[output_index] = op_backend->create_tensor(
+          ng_element->get_element_type(), ng_element->get_shape(),
+          DMAHelper::base(tf_output_tensor));
+      output_is_zero_copy[output_index] = true;
+    }
+  }
+  event_prepare_tf_output_tensors.Stop();
+  ngraph::Event::write_trace(event_prepare_tf_output_tensors);
+
+  // And execute
+  ngraph::Event event_execute_graph(
+      "Execute Graph Pipeline Indx" + to_string(current_iter_pipeline_depth),
+      "", "");
+  Timer execute_graph_timer;
+
+  // Take only the lock the backend needs, calls of other executables (or of
+  // this one too, on a re-entrant backend) can run meanwhile
+  BackendManager::LockExecutable(m_parallel_executor->GetOpBackendName(),
+                                 ng_exec.get());
+  NGRAPH_VLOG(4) << "NGraphEncapsulateOp::Compute call starting for cluster "
+                 << m_parallel_executor->GetNgraphClusterId();
+  try {
+    ng_exec->call(ng_outputs, ng_inputs);
+  } catch (const std::exception& exp) {
+    BackendManager::UnlockExecutable(m_parallel_executor->GetOpBackendName(),
+                                     ng_exec.get());
+    Status st = ng_function_ref.ToFile("tf_function_error" +
+                                       ctx->op_kernel().name() + ".json");
+    string status_string =
+        "Caught exception while executing nGraph computation: " +
+        string(exp.what()) +
+        (st.ok() ? "" : (" Also error in dumping serialized function: " +
+                         st.error_message()));
+    OP_REQUIRES(ctx, false, errors::Internal(status_string));
+  } catch (...) {
+    BackendManager::UnlockExecutable(m_parallel_executor->GetOpBackendName(),
+                                     ng_exec.get());
+    Status st = ng_function_ref.ToFile("tf_function_error" +
+                                       ctx->op_kernel().name() + ".json");
+    string status_string =
+        "Error in executing the nGraph computation." +
+        (st.ok() ? "" : (" Also error in dumping serialized function: " +
+                         st.error_message()));
+    OP_REQUIRES(ctx, false, errors::Internal(status_string));
+  }
+  BackendManager::UnlockExecutable(m_parallel_executor->GetOpBackendName(),
+                                   ng_exec.get());
+  event_execute_graph.Stop();
+  execute_graph_timer.Stop();
+  ngraph::Event::write_trace(event_execute_graph);
+
   // Copy Tensors that are required
   NGRAPH_VLOG(4) << "NGraphEncapsulateOp::Compute Read NG Output Tensors "
                  << m_parallel_executor->GetNgraphClusterId();
 
+  ngraph::Event event_copy_tf_output_tensors("Copy TF Output Tensor", "", "");
+  Timer copy_tf_output_tensors_timer;
   std::vector<std::unique_ptr<ngraph::Event>> output_copy_events;
 
   auto output_indexes_to_be_copied =
       tensor_manager->GetOutputIndexesThatNeedCopy();
   for (auto output_index : output_indexes_to_be_copied) {
+    if (output_is_zero_copy[output_index]) {
+      continue;
+    }
     // Copy the nGraph Tensor to Host Tensor
     std::unique_ptr<ngraph::Event> event_copy_d2h(new ngraph::Event(
         "D2H_Output_" + std::to_string(output_index), "", ""));
     void* dst_ptr = (void*)DMAHelper::base(tf_output_tensors[output_index]);
-    ng_outputs[output_index]->read(
-        dst_ptr, ng_outputs[output_index]->get_element_count() *
-                     ng_outputs[output_index]->get_element_type().size());
+    size_t ng_output_bytes =
+        ng_outputs[output_index]->get_element_count() *
+        ng_outputs[output_index]->get_element_type().size();
+    if (tf_output_tensors[output_index]->TotalBytes() == ng_output_bytes) {
+      ng_outputs[output_index]->read(dst_ptr, ng_output_bytes);
+    } else {
+      // Computed on bucketed inputs, slice off the padding
+      vector<int64> padded_dims;
+      for (auto dim : ng_outputs[output_index]->get_shape()) {
+        padded_dims.push_back(dim);
+      }
+      Tensor padded_output(tf_output_tensors[output_index]->dtype(),
+                           TensorShape(padded_dims));
+      ng_outputs[output_index]->read(DMAHelper::base(&padded_output),
+                                     ng_output_bytes);
+      NGraphShapeBucketing::CopyRegion(
+          static_cast<const char*>(DMAHelper::base(&padded_output)),
+          padded_output.shape(), static_cast<char*>(dst_ptr),
+          tf_output_tensors[output_index]->shape(),
+          DataTypeSize(padded_output.dtype()));
+    }
     event_copy_d2h->Stop();
     output_copy_events.push_back(std::move(event_copy_d2h));
   }
   for (auto& next : output_copy_events) {
     ngraph::Event::write_trace(*next.get());
   }
-  event_prepare_tf_output_tensors.Stop();
-  ngraph::Event::write_trace(event_prepare_tf_output_tensors);
+  event_copy_tf_output_tensors.Stop();
+  copy_tf_output_tensors_timer.Stop();
+  ngraph::Event::write_trace(event_copy_tf_output_tensors);
 
   // Synch Var Output Tensors as required
   NGRAPH_VLOG(4)
@@ -616,9 +750,109 @@ void NGraphEncapsulateOp::ComputeUsingParallelExecutor(OpKernelContext* ctx) {
   event_return_tensor.Stop();
   ngraph::Event::write_trace(event_return_tensor);
 
+  if (!m_profile_key.empty()) {
+    NGraphClusterProfile::RecordNGraphStep(
+        m_profile_key, get_ng_item_timer.ElapsedInMicroSec(),
+        prepare_ng_tensors_timer.ElapsedInMicroSec(),
+        execute_graph_timer.ElapsedInMicroSec(),
+        copy_tf_output_tensors_timer.ElapsedInMicroSec());
+  }
+
   NGRAPH_VLOG(2) << "COMPUTE: Done " << name();
 }
 
+//---------------------------------------------------------------------------
+// ComputeUsingFallback
+//---------------------------------------------------------------------------
+void NGraphEncapsulateOp::ComputeUsingFallback(OpKernelContext* ctx,
+                                               DoneCallback done) {
+  NGRAPH_VLOG(1) << "Compute using TensorFlow fallback " << name();
+  auto event_fallback =
+      std::make_shared<ngraph::Event>("Fallback", name(), "");
+  auto fallback_timer = std::make_shared<Timer>();
+  FunctionLibraryRuntime* flr = ctx->function_library();
+  OP_REQUIRES_ASYNC(
+      ctx, flr != nullptr,
+      errors::Internal("No function library to run the fallback of ", name()),
+      done);
+
+  FunctionLibraryRuntime::Handle handle;
+  bool instantiated = false;
+  {
+    std::lock_guard<std::mutex> lock(m_fallback_mutex);
+    if (m_fallback_handle == kInvalidHandle) {
+      instantiated = true;
+      string function_name =
+          "ngraph_cluster_" +
+          to_string(m_parallel_executor->GetNgraphClusterId()) + "_fallback";
+      FunctionDef fdef;
+      OP_REQUIRES_OK_ASYNC(ctx, m_parallel_executor->GetFallbackFunctionDef(
+                                    function_name, &fdef),
+                           done);
+      // Overlay on the library of the graph, the cluster may call functions
+      // from it
+      m_fallback_flib_def.reset(
+          new FunctionLibraryDefinition(*flr->GetFunctionLibraryDefinition()));
+      OP_REQUIRES_OK_ASYNC(ctx, m_fallback_flib_def->AddFunctionDef(fdef),
+                           done);
+      FunctionLibraryRuntime::InstantiateOptions instantiate_opts;
+      instantiate_opts.lib_def = m_fallback_flib_def.get();
+      OP_REQUIRES_OK_ASYNC(
+          ctx, flr->Instantiate(function_name, AttrSlice(), instantiate_opts,
+                                &m_fallback_handle),
+          done);
+    }
+    handle = m_fallback_handle;
+  }
+
+  std::vector<Tensor> args;
+  for (int i = 0; i < ctx->num_inputs(); i++) {
+    args.push_back(ctx->input(i));
+  }
+  auto rets = std::make_shared<std::vector<Tensor>>();
+  FunctionLibraryRuntime::Options opts;
+  opts.step_id = ctx->step_id();
+  opts.rendezvous = ctx->rendezvous();
+  opts.cancellation_manager = ctx->cancellation_manager();
+  opts.runner = ctx->runner();
+  opts.step_container = ctx->step_container();
+  opts.stats_collector = ctx->stats_collector();
+
+  // The kernels of the function run on the inter-op pool, this thread
+  // returns to it instead of waiting for them
+  auto fallback_done = [this, ctx, done, rets, event_fallback, fallback_timer,
+                        instantiated](const Status& run_status) {
+    OP_REQUIRES_OK_ASYNC(ctx, run_status, done);
+    OP_REQUIRES_ASYNC(ctx, rets->size() == ctx->num_outputs(),
+                      errors::Internal("Fallback of ", name(), " returned ",
+                                       rets->size(), " outputs, expected ",
+                                       ctx->num_outputs()),
+                      done);
+    for (int i = 0; i < ctx->num_outputs(); i++) {
+      ctx->set_output(i, (*rets)[i]);
+    }
+
+    m_parallel_executor->RecordFallbackStep();
+    NGRAPH_VLOG(1) << "NGRAPH_TF_ASYNC_COMPILE_PROFILE: OP_ID: "
+                   << m_parallel_executor->GetNgraphClusterId()
+                   << " Step_ID: " << ctx->step_id() << " Fallback steps: "
+                   << m_parallel_executor->GetFallbackStepCount()
+                   << " Compile queue depth: "
+                   << NGraphExecutor::GetCompileQueueDepth();
+    event_fallback->Stop();
+    ngraph::Event::write_trace(*event_fallback);
+    // The time of the step that instantiated the function is not that of
+    // the kernels
+    if (!m_profile_key.empty() && !instantiated) {
+      m_profile_tf_steps++;
+      NGraphClusterProfile::RecordFallbackStep(
+          m_profile_key, fallback_timer->ElapsedInMicroSec());
+    }
+    done();
+  };
+  flr->Run(opts, handle, args, rets.get(), std::move(fallback_done));
+}
+
 //---------------------------------------------------------------------------
 //    ComputeUsingLegacyExecutor
 //---------------------------------------------------------------------------
@@ -845,13 +1079,15 @@ void NGraphEncapsulateOp::ComputeUsingLegacyExecutor(OpKernelContext* ctx) {
   ngraph::Event event_execute_function("Execute nGraph", name(), "");
   Timer execute_function;
   {
-    BackendManager::LockBackend(ng_encap_impl_.GetOpBackend());
+    BackendManager::LockExecutable(ng_encap_impl_.GetOpBackend(),
+                                   ng_exec.get());
     NGRAPH_VLOG(4) << "NGraphEncapsulateOp::Compute call starting for cluster "
                    << ng_encap_impl_.GetNgraphCluster();
     try {
       ng_exec->call(ng_outputs, ng_inputs);
     } catch (const std::exception& exp) {
-      BackendManager::UnlockBackend(ng_encap_impl_.GetOpBackend());
+      BackendManager::UnlockExecutable(ng_encap_impl_.GetOpBackend(),
+                                       ng_exec.get());
       Status st = ng_encap_impl_.DumpNgFunction(
           "tf_function_error_" + ctx->op_kernel().name() + ".json", ng_exec);
       string status_string =
@@ -861,7 +1097,8 @@ void NGraphEncapsulateOp::ComputeUsingLegacyExecutor(OpKernelContext* ctx) {
                            st.error_message()));
       OP_REQUIRES(ctx, false, errors::Internal(status_string));
     } catch (...) {
-      BackendManager::UnlockBackend(ng_encap_impl_.GetOpBackend());
+      BackendManager::UnlockExecutable(ng_encap_impl_.GetOpBackend(),
+                                       ng_exec.get());
       Status st = ng_encap_impl_.DumpNgFunction(
           "tf_function_error_" + ctx->op_kernel().name() + ".json", ng_exec);
       string status_string =
@@ -870,7 +1107,8 @@ void NGraphEncapsulateOp::ComputeUsingLegacyExecutor(OpKernelContext* ctx) {
                            st.error_message()));
       OP_REQUIRES(ctx, false, errors::Internal(status_string));
     }
-    BackendManager::UnlockBackend(ng_encap_impl_.GetOpBackend());
+    BackendManager::UnlockExecutable(ng_encap_impl_.GetOpBackend(),
+                                     ng_exec.get());
   }
   int time_execute_function = execute_function.ElapsedInMS();
   event_execute_function.Stop();
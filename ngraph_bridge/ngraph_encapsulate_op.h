@@ -18,9 +18,11 @@
 #define NGRAPH_TF_ENCAPSULATE_OP_H_
 #pragma once
 
+#include <atomic>
 #include <ostream>
 #include <vector>
 
+#include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/graph/graph.h"
 
@@ -34,11 +36,14 @@ namespace tensorflow {
 
 namespace ngraph_bridge {
 
-class NGraphEncapsulateOp : public OpKernel {
+// Asynchronous so that the TensorFlow fallback does not hold an inter-op
+// thread while the kernels of the cluster run on the same pool. The nGraph
+// steps still run synchronously in ComputeAsync.
+class NGraphEncapsulateOp : public AsyncOpKernel {
  public:
   explicit NGraphEncapsulateOp(OpKernelConstruction* ctx);
   ~NGraphEncapsulateOp() override;
-  void Compute(OpKernelContext* ctx) override;
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override;
 
  private:
   void CreateParallelExecutor(OpKernelConstruction* ctx,
@@ -46,13 +51,32 @@ class NGraphEncapsulateOp : public OpKernel {
   void CreateLegacyExecutor(OpKernelConstruction* ctx,
                             const string& backend_name);
   void ComputeUsingLegacyExecutor(OpKernelContext* ctx);
-  void ComputeUsingParallelExecutor(OpKernelContext* ctx);
+  // Sets run_fallback instead of running the step if its executable is
+  // still being compiled
+  void ComputeUsingParallelExecutor(OpKernelContext* ctx, bool* run_fallback);
+  // Runs the step with the TensorFlow kernels of the cluster, while its
+  // executable is compiled in the background or to profile them. done is
+  // called once the function returns.
+  void ComputeUsingFallback(OpKernelContext* ctx, DoneCallback done);
 
   static int s_instance_id;
   NGraphEncapsulateImpl ng_encap_impl_;
   bool m_use_parallel_executor = false;
   std::mutex m_compute_lock_;
   unique_ptr<NGraphExecutor> m_parallel_executor;
+
+  // The cluster graph as a function, instantiated on the first fallback
+  std::mutex m_fallback_mutex;
+  unique_ptr<FunctionLibraryDefinition> m_fallback_flib_def;
+  FunctionLibraryRuntime::Handle m_fallback_handle = kInvalidHandle;
+
+  // Key of the cluster in the profile, when NGRAPH_TF_CLUSTER_PROFILE is set
+  // and the cluster can run with the fallback
+  string m_profile_key;
+  // Steps run while profiling, and how many of them were timed on the
+  // fallback
+  std::atomic<int64> m_profile_steps{0};
+  std::atomic<int64> m_profile_tf_steps{0};
 };
 
 }  // namespace ngraph_bridge
@@ -14,8 +14,12 @@
  * limitations under the License.
  *******************************************************************************/
 
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/mutex.h"
+
 #include "ngraph_bridge/ngraph_encapsulate_op_utils.h"
 #include "ngraph_bridge/ngraph_prefetch_shared_data.h"
+#include "ngraph_bridge/ngraph_runtime_config.h"
 #include "ngraph_bridge/ngraph_utils.h"
 
 #include "ngraph_bridge/ngraph_var.h"
@@ -26,6 +30,107 @@ namespace tensorflow {
 
 namespace ngraph_bridge {
 
+// Returns the error of a step whose wait for a free pipeline group failed,
+// idx is what the wait returned
+static Status PipelineWaitError(int idx, const string& what,
+                                const string& name, int64 wait_timeout_ms) {
+  if (idx == IndexLibrary::kCancelled) {
+    return errors::Cancelled("Cancelled while waiting for ", what, " of ",
+                             name);
+  }
+  return errors::DeadlineExceeded("Waited ", wait_timeout_ms, " ms for ", what,
+                                  " of ", name);
+}
+
+// Serializes the first steps of the prefetched encapsulates
+static mutex s_prefetch_setup_mutex(LINKER_INITIALIZED);
+
+// Creates the prefetch shared data of an encapsulate on its first step, or
+// looks it up if a concurrent first step created it meanwhile, and sets
+// io_tensors to the group this step runs with.
+// The creating step takes all the groups of the store: one for itself, and
+// the depth - 1 others it hands to the shared data, for the prefetcher to
+// copy up to depth - 1 elements ahead of the current iteration. The calling
+// step must have returned its group: concurrent first steps wait for the
+// setup without holding a group, else they could each hold one and wait for
+// the other's.
+// On success shared_data holds a reference the caller releases.
+static Status SetUpPrefetchSharedData(
+    OpKernelContext* ctx,
+    const shared_ptr<PipelinedTensorsStore>& pipelined_tensor_store,
+    const shared_ptr<NGraphTensorManager>& tensor_manager,
+    const string& resource_name,
+    tuple<int, PipelinedTensorVector, PipelinedTensorVector>& io_tensors,
+    NGraphPrefetchSharedResouce** shared_data, bool& created) {
+  const int64 wait_timeout_ms =
+      NGraphRuntimeConfig::Get().pipeline_wait_timeout_ms;
+  created = false;
+  {
+    mutex_lock lock(s_prefetch_setup_mutex);
+    Status s = ctx->resource_manager()->Lookup(
+        NGraphPrefetchSharedResouce::CONTAINER_NAME, resource_name,
+        shared_data);
+    if (!s.ok()) {
+      // The groups may still be held by the previous steps, wait for them
+      // like for the group of a step. On an error the groups taken so far go
+      // back to the store.
+      std::vector<NGraphPrefetchSharedResouce::IOTensorBundle> bundles;
+      auto release_bundles = [&]() {
+        for (const auto& bundle : bundles) {
+          pipelined_tensor_store->return_tensors(bundle.Id);
+        }
+      };
+      for (size_t i = 0; i < pipelined_tensor_store->get_depth(); i++) {
+        auto group = pipelined_tensor_store->get_tensors(
+            wait_timeout_ms, ctx->cancellation_manager());
+        if (get<0>(group) < 0) {
+          release_bundles();
+          return PipelineWaitError(get<0>(group), "the prefetch tensors",
+                                   tensor_manager->GetName(),
+                                   wait_timeout_ms);
+        }
+        bundles.push_back({get<0>(group), get<1>(group), get<2>(group)});
+      }
+
+      s = ctx->resource_manager()->LookupOrCreate<NGraphPrefetchSharedResouce>(
+          NGraphPrefetchSharedResouce::CONTAINER_NAME, resource_name,
+          shared_data, [&](NGraphPrefetchSharedResouce** resource) {
+            *resource = new NGraphPrefetchSharedResouce(
+                tensor_manager->GetName(), tensor_manager->GetClusterId(),
+                tensor_manager->GetGraphId(),
+                tensor_manager->GetInputIndexesForPrefetchSharedObject(),
+                bundles.size());
+            for (size_t i = 1; i < bundles.size(); i++) {
+              (*resource)->AddNextIOTensorBundleForDeviceTransfer(bundles[i]);
+            }
+            created = true;
+            return Status::OK();
+          });
+      if (!s.ok()) {
+        release_bundles();
+        return s;
+      }
+      if (created) {
+        io_tensors =
+            make_tuple(bundles[0].Id, bundles[0].Inputs, bundles[0].Outputs);
+        return Status::OK();
+      }
+      release_bundles();
+    }
+  }
+
+  // Set up by another step, this one takes a group as usual
+  io_tensors = pipelined_tensor_store->get_tensors(
+      wait_timeout_ms, ctx->cancellation_manager());
+  if (get<0>(io_tensors) < 0) {
+    (*shared_data)->Unref();
+    *shared_data = nullptr;
+    return PipelineWaitError(get<0>(io_tensors), "a free tensor",
+                             tensor_manager->GetName(), wait_timeout_ms);
+  }
+  return Status::OK();
+}
+
 //---------------------------------------------------------------------------
 //  GetPipelinedIOTensorsReadyForExecution
 //---------------------------------------------------------------------------
@@ -35,7 +140,13 @@ Status GetPipelinedIOTensorsReadyForExecution(
     const shared_ptr<NGraphTensorManager>& tensor_manager,
     tuple<int, PipelinedTensorVector, PipelinedTensorVector>&
         pipelined_io_tensors) {
-  auto io_tensors = pipelined_tensor_store->get_tensors();
+  const NGraphRuntimeConfig& runtime_config = NGraphRuntimeConfig::Get();
+  // Steps beyond the pipeline depth queue up here till a group is returned.
+  // The wait times out after NGRAPH_TF_PIPELINE_WAIT_TIMEOUT_MS, or never if
+  // it is negative
+  const int64 wait_timeout_ms = runtime_config.pipeline_wait_timeout_ms;
+  auto io_tensors = pipelined_tensor_store->get_tensors(
+      wait_timeout_ms, ctx->cancellation_manager());
 
   int current_iter_pipeline_depth = get<0>(io_tensors);
   PipelinedTensorVector ng_pipelined_inputs = get<1>(io_tensors);
@@ -44,8 +155,13 @@ Status GetPipelinedIOTensorsReadyForExecution(
   auto pipelined_output_indexes = tensor_manager->GetPipelinedOutputIndexes();
 
   if (current_iter_pipeline_depth < 0) {
-    return errors::Internal("No free tensor available");
+    return PipelineWaitError(current_iter_pipeline_depth, "a free tensor",
+                             tensor_manager->GetName(), wait_timeout_ms);
   }
+  NGRAPH_VLOG(1) << "NGRAPH_TF_PIPELINE_WAIT_PROFILE: Cluster: "
+                 << tensor_manager->GetName() << " Wait histogram (us): "
+                 << pipelined_tensor_store->get_index_library()
+                        ->get_wait_histogram_string();
 
   if (pipelined_input_indexes.size() != ng_pipelined_inputs.size()) {
     return errors::Internal(
@@ -64,53 +180,38 @@ Status GetPipelinedIOTensorsReadyForExecution(
   bool skip_tf2ng_copy = false;
   // Prefetch only if there are input tensors that are prefetched && prefetch
   // has been requested
-  // [TODO] we support prefetching only when there is atmost 1 encap
-  // that has prefetched inputs
-  if (std::getenv(NGraphPrefetchSharedResouce::NGRAPH_TF_USE_PREFETCH) !=
-          nullptr &&
-      !(tensor_manager->GetPipelinedInputIndexesThatArePrefetched()).empty()) {
+  // Each encap has its own shared data, keyed by its graph id, cluster id and
+  // the iterator feeding it, which the NGraphPrefetchDataset made for that
+  // iterator finds in the catalog
+  if (runtime_config.use_prefetch &&
+      !(tensor_manager->GetPipelinedInputIndexesThatArePrefetched()).empty() &&
+      !tensor_manager->GetPrefetchIterator().empty()) {
     NGRAPH_VLOG(2) << "[PREFETCH] NGRAPH_TF_USE_PREFETCH Set";
+    const string resource_name = NGraphPrefetchSharedResouce::ResourceName(
+        tensor_manager->GetGraphId(), tensor_manager->GetClusterId(),
+        tensor_manager->GetPrefetchIterator());
     // Set the prefetch shared obj if applicable
     NGraphPrefetchSharedResouce* shared_data = nullptr;
+    bool created = false;
     Status s = ctx->resource_manager()->Lookup(
-        NGraphPrefetchSharedResouce::CONTAINER_NAME,
-        NGraphPrefetchSharedResouce::RESOURCE_NAME, &shared_data);
-
+        NGraphPrefetchSharedResouce::CONTAINER_NAME, resource_name,
+        &shared_data);
     if (!s.ok()) {
-      // We are using this for the first time i.e., we need to do the following
-      // 1. Create the shared data object
-      // 2. We get another pipelined tensor pair for the current iteration and
-      //   add it to the shared data. It will be accessed by prefetcher to copy
-      //   the prefetched inputs to device
-
-      shared_data = new NGraphPrefetchSharedResouce(
-          tensor_manager->GetName(), tensor_manager->GetGraphId(),
-          tensor_manager->GetClusterId(),
-          tensor_manager->GetInputIndexesForPrefetchSharedObject());
-
-      // Get the set of IO tensors for the next iteration
-      tuple<int, PipelinedTensorVector, PipelinedTensorVector>
-          io_tensors_next_iter;
-      io_tensors_next_iter = pipelined_tensor_store->get_tensors();
-
-      // Save the prefetched input ngTensors for the next iteration
-      NGraphPrefetchSharedResouce::IOTensorBundle next_io_tensor_bundle{
-          get<0>(io_tensors_next_iter), get<1>(io_tensors_next_iter),
-          get<2>(io_tensors_next_iter)};
-
-      if (current_iter_pipeline_depth != (!next_io_tensor_bundle.Id)) {
-        return errors::Internal("Current Pipeline Depth is ",
-                                current_iter_pipeline_depth,
-                                " and next iter pipeline depth is also  ",
-                                next_io_tensor_bundle.Id);
-      }
-
-      shared_data->AddNextIOTensorBundleForDeviceTransfer(
-          next_io_tensor_bundle);
+      // We are using this for the first time, the group of this step goes
+      // back to the store while the shared data is set up
+      pipelined_tensor_store->return_tensors(current_iter_pipeline_depth);
+      TF_RETURN_IF_ERROR(SetUpPrefetchSharedData(
+          ctx, pipelined_tensor_store, tensor_manager, resource_name,
+          io_tensors, &shared_data, created));
+      current_iter_pipeline_depth = get<0>(io_tensors);
+      ng_pipelined_inputs = get<1>(io_tensors);
+      ng_pipelined_outputs = get<2>(io_tensors);
+    }
+    // Release the reference Lookup or SetUpPrefetchSharedData took, on every
+    // path
+    core::ScopedUnref unref_shared_data(shared_data);
 
-      ctx->SetStatus(ctx->resource_manager()->Create(
-          NGraphPrefetchSharedResouce::CONTAINER_NAME,
-          NGraphPrefetchSharedResouce::RESOURCE_NAME, shared_data));
+    if (created) {
       // Continue the execution with the currently supplied TF tensor for the
       // last time
       NGRAPH_VLOG(2) << "[PREFETCH] COMPUTE: Creating the shared object to "
@@ -144,7 +245,7 @@ Status GetPipelinedIOTensorsReadyForExecution(
         current_iter_pipeline_depth = ng_io_tensor_bundle_ready.Id;
         ng_pipelined_inputs = ng_io_tensor_bundle_ready.Inputs;
         ng_pipelined_outputs = ng_io_tensor_bundle_ready.Outputs;
-        if (current_iter_pipeline_depth != (!prefetch_io_tensor_bundle.Id)) {
+        if (current_iter_pipeline_depth == prefetch_io_tensor_bundle.Id) {
           return errors::Internal("Current Pipeline Depth is ",
                                   current_iter_pipeline_depth,
                                   " and next iter pipeline depth is ", "also ",
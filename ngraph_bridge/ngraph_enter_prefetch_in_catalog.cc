@@ -33,7 +33,7 @@ namespace tensorflow {
 
 namespace ngraph_bridge {
 
-// Populate the PrefetchedInputIndexMap
+// Populate the PrefetchedInputIndexMap and the PrefetchedInputIteratorMap
 
 // We collect the below information for the catalog
 // 1. If the input to "NGraphEncapsulate" node
@@ -42,6 +42,14 @@ namespace ngraph_bridge {
 // "NGraphEncapsulate" node to the PrefetchedInputIndexMap
 // We add mapping of {graphId_nodename : (input_indexs)} to the
 // PrefetchedInputIndexMap
+// 2. The iterator read by that IteratorGetNext, i.e. we add
+// {graphId_nodename : iterator} and {iterator : (graphId, clusterId)} to the
+// PrefetchedInputIteratorMap, so that the NGraphPrefetchDataset made for the
+// iterator finds the encapsulates it feeds
+//
+// Each encapsulate is fed by one input pipeline: an encapsulate with inputs
+// from several IteratorGetNext nodes is not prefetched, its inputs are
+// copied when it runs.
 //
 
 Status EnterPrefetchInCatalog(Graph* graph, int graph_id) {
@@ -57,11 +65,10 @@ Status EnterPrefetchInCatalog(Graph* graph, int graph_id) {
     // inputs
     map<int, int> in_indexes_for_encap;
     if (node->type_string() == "NGraphEncapsulate") {
+      std::set<Node*> iterator_get_next_nodes;
       for (auto edge : node->in_edges()) {
         // If any input is coming from "IteratorGetNext" then
         // add the input index for it to the set
-        // [TODO] Data Pipeling assumes there is only 1 IteratorGetNext
-        //
         if (edge->src()->type_string() == "IteratorGetNext") {
           NGRAPH_VLOG(4) << "Adding to PrefetchedInputIndexMap";
           NGRAPH_VLOG(4) << "Key: " << node->name();
@@ -69,13 +76,32 @@ Status EnterPrefetchInCatalog(Graph* graph, int graph_id) {
           NGRAPH_VLOG(4) << "IteratorGetNext Output index: "
                          << edge->src_output();
           in_indexes_for_encap.insert({edge->dst_input(), edge->src_output()});
+          iterator_get_next_nodes.insert(edge->src());
         }
       }  // end loop over input edges
 
+      if (iterator_get_next_nodes.size() > 1) {
+        NGRAPH_VLOG(1) << "Not prefetching the inputs of " << node->name()
+                       << ": they come from "
+                       << iterator_get_next_nodes.size()
+                       << " IteratorGetNext nodes";
+        continue;
+      }
+
       if (in_indexes_for_encap.size() > 0) {
+        int cluster_id;
+        TF_RETURN_IF_ERROR(
+            GetNodeAttr(node->attrs(), "ngraph_cluster", &cluster_id));
+        const Edge* iterator_edge;
+        TF_RETURN_IF_ERROR(
+            (*iterator_get_next_nodes.begin())->input_edge(0, &iterator_edge));
+        const string& iterator_name = iterator_edge->src()->name();
+        NGRAPH_VLOG(4) << "Iterator: " << iterator_name;
         try {
           NGraphCatalog::AddToPrefetchedInputIndexMap(graph_id, node->name(),
                                                       in_indexes_for_encap);
+          NGraphCatalog::AddToPrefetchedInputIteratorMap(
+              graph_id, node->name(), cluster_id, iterator_name);
         } catch (const std::exception& exp) {
           return errors::Internal(
               "Caught exception while entering in catalog: ", exp.what(), "\n");
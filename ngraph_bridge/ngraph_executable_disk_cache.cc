@@ -0,0 +1,241 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <unistd.h>
+#include <utime.h>
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_executable_disk_cache.h"
+#include "ngraph_bridge/version.h"
+
+using namespace std;
+namespace ng = ngraph;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+static const char* const kEntrySuffix = ".ngexec";
+static const char* const kEntryHeader = "ngtf-executable-cache:";
+static const int64 kDefaultCapacityInMB = 2048;
+
+// Two independent 64 bit hashes make up the 128 bit content hash
+static const uint64 kHashSeedLow = 0x6e677266ULL;
+static const uint64 kHashSeedHigh = 0x74666578ULL;
+
+static string HashToHex(const string& data) {
+  uint64 low = Hash64(data.data(), data.size(), kHashSeedLow);
+  uint64 high = Hash64(data.data(), data.size(), kHashSeedHigh);
+  return strings::StrCat(strings::Hex(high, strings::kZeroPad16),
+                         strings::Hex(low, strings::kZeroPad16));
+}
+
+NGraphExecutableDiskCache::NGraphExecutableDiskCache(const string& cache_dir,
+                                                     int64 capacity_in_bytes)
+    : m_cache_dir(cache_dir), m_capacity_in_bytes(capacity_in_bytes) {}
+
+NGraphExecutableDiskCache* NGraphExecutableDiskCache::Global() {
+  static NGraphExecutableDiskCache* global_cache =
+      []() -> NGraphExecutableDiskCache* {
+    const char* cache_dir = std::getenv("NGRAPH_TF_DISK_CACHE_DIR");
+    if (cache_dir == nullptr || string(cache_dir).empty()) {
+      return nullptr;
+    }
+    int64 capacity_in_mb = kDefaultCapacityInMB;
+    const char* capacity_specified =
+        std::getenv("NGRAPH_TF_DISK_CACHE_SIZE_MB");
+    if (capacity_specified != nullptr) {
+      capacity_in_mb = atoll(capacity_specified);
+    }
+    Status status = Env::Default()->RecursivelyCreateDir(cache_dir);
+    if (!status.ok()) {
+      NGRAPH_VLOG(0) << "NGRAPH_TF_DISK_CACHE_DIR: cannot create " << cache_dir
+                     << ", executable disk cache disabled: "
+                     << status.error_message();
+      return nullptr;
+    }
+    NGRAPH_VLOG(1) << "Using executable disk cache " << cache_dir
+                   << " Capacity: " << capacity_in_mb << " MB";
+    return new NGraphExecutableDiskCache(cache_dir,
+                                         capacity_in_mb * 1024 * 1024);
+  }();
+  return global_cache;
+}
+
+string NGraphExecutableDiskCache::GraphFingerprint(const Graph& graph) {
+  GraphDef graph_def;
+  graph.ToGraphDef(&graph_def);
+  string serialized_graph;
+  SerializeToStringDeterministic(graph_def, &serialized_graph);
+  return HashToHex(serialized_graph);
+}
+
+string NGraphExecutableDiskCache::ComputeKey(const string& graph_fingerprint,
+                                             const string& backend_name,
+                                             const string& signature) {
+  return HashToHex(strings::StrCat(graph_fingerprint, "|", backend_name, "|",
+                                   ngraph_lib_version(), "|", signature));
+}
+
+string NGraphExecutableDiskCache::EntryPath(const string& key) const {
+  return io::JoinPath(m_cache_dir, strings::StrCat(key, kEntrySuffix));
+}
+
+bool NGraphExecutableDiskCache::ReadEntry(const string& key, string* blob) {
+  string contents;
+  if (!ReadFileToString(Env::Default(), EntryPath(key), &contents).ok()) {
+    return false;
+  }
+  // Guard against entries that do not belong to this key
+  string header = strings::StrCat(kEntryHeader, key, "\n");
+  if (!str_util::StartsWith(contents, header)) {
+    NGRAPH_VLOG(1) << "Executable disk cache: ignoring malformed entry "
+                   << EntryPath(key);
+    return false;
+  }
+  *blob = contents.substr(header.size());
+  return true;
+}
+
+Status NGraphExecutableDiskCache::WriteEntry(const string& key,
+                                             const string& blob) {
+  // Write to a process unique file first and rename it into place, renames
+  // are atomic so concurrent readers never see a partially written entry
+  string tmp_path = strings::StrCat(EntryPath(key), ".tmp.", getpid(), ".",
+                                    m_tmp_file_count++);
+  TF_RETURN_IF_ERROR(
+      WriteStringToFile(Env::Default(), tmp_path,
+                        strings::StrCat(kEntryHeader, key, "\n", blob)));
+  Status status = Env::Default()->RenameFile(tmp_path, EntryPath(key));
+  if (!status.ok()) {
+    Env::Default()->DeleteFile(tmp_path).IgnoreError();
+  }
+  return status;
+}
+
+std::shared_ptr<ng::runtime::Executable> NGraphExecutableDiskCache::Load(
+    const string& key, ng::runtime::Backend* op_backend) {
+  std::shared_ptr<ng::runtime::Executable> ng_exec;
+  string blob;
+  if (ReadEntry(key, &blob)) {
+    try {
+      stringstream serialized_exec_read(blob);
+      ng_exec = op_backend->load(serialized_exec_read);
+    } catch (const std::exception& exp) {
+      NGRAPH_VLOG(1) << "Executable disk cache: failed to load " << key << ": "
+                     << exp.what();
+      ng_exec = nullptr;
+    } catch (...) {
+      NGRAPH_VLOG(1) << "Executable disk cache: failed to load " << key;
+      ng_exec = nullptr;
+    }
+    if (ng_exec == nullptr) {
+      // Stale entry (for e.g. written by an incompatible backend), drop it
+      Env::Default()->DeleteFile(EntryPath(key)).IgnoreError();
+    } else {
+      // Refresh the modification time, it orders the entries for eviction
+      utime(EntryPath(key).c_str(), nullptr);
+    }
+  }
+
+  if (ng_exec != nullptr) {
+    m_hits++;
+  } else {
+    m_misses++;
+  }
+  NGRAPH_VLOG(1) << "NGRAPH_TF_DISK_CACHE_PROFILE: Key: " << key
+                 << " Hit: " << (ng_exec != nullptr) << " Hits: " << m_hits
+                 << " Misses: " << m_misses << " Stores: " << m_stores
+                 << " Evictions: " << m_evictions;
+  return ng_exec;
+}
+
+Status NGraphExecutableDiskCache::Store(
+    const string& key,
+    const std::shared_ptr<ng::runtime::Executable>& ng_exec) {
+  stringstream serialized_exec;
+  try {
+    ng_exec->save(serialized_exec);
+  } catch (const std::exception& exp) {
+    NGRAPH_VLOG(1) << "Executable disk cache: backend cannot save executable "
+                   << key << ": " << exp.what();
+    return Status::OK();
+  } catch (...) {
+    NGRAPH_VLOG(1) << "Executable disk cache: backend cannot save executable "
+                   << key;
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(WriteEntry(key, serialized_exec.str()));
+  m_stores++;
+  return EvictIfNeeded();
+}
+
+Status NGraphExecutableDiskCache::EvictIfNeeded() {
+  std::lock_guard<std::mutex> lock(m_evict_mutex);
+  std::vector<string> children;
+  TF_RETURN_IF_ERROR(Env::Default()->GetChildren(m_cache_dir, &children));
+
+  // (modification time, size, path) of every entry
+  std::vector<std::tuple<int64, int64, string>> entries;
+  int64 total_bytes = 0;
+  for (const auto& child : children) {
+    if (!str_util::EndsWith(child, kEntrySuffix)) {
+      continue;
+    }
+    string path = io::JoinPath(m_cache_dir, child);
+    FileStatistics stat;
+    // Another process might have evicted it in the meantime
+    if (!Env::Default()->Stat(path, &stat).ok()) {
+      continue;
+    }
+    entries.push_back(std::make_tuple(stat.mtime_nsec, stat.length, path));
+    total_bytes += stat.length;
+  }
+  if (total_bytes <= m_capacity_in_bytes) {
+    return Status::OK();
+  }
+
+  // Oldest first
+  std::sort(entries.begin(), entries.end());
+  for (const auto& entry : entries) {
+    if (total_bytes <= m_capacity_in_bytes) {
+      break;
+    }
+    if (Env::Default()->DeleteFile(std::get<2>(entry)).ok()) {
+      m_evictions++;
+      NGRAPH_VLOG(1) << "Executable disk cache: evicted " << std::get<2>(entry);
+    }
+    total_bytes -= std::get<1>(entry);
+  }
+  return Status::OK();
+}
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
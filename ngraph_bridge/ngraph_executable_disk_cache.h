@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#ifndef NGRAPH_TF_EXECUTABLE_DISK_CACHE_H_
+#define NGRAPH_TF_EXECUTABLE_DISK_CACHE_H_
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+#include "ngraph/ngraph.hpp"
+#include "ngraph/runtime/backend.hpp"
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+//
+// A persistent, content addressed cache of compiled nGraph executables.
+//
+// Each entry is the blob produced by Executable::save() for one
+// (encapsulated graph, backend, input signature) triple and is reloaded with
+// Backend::load(), i.e. the same path used for AOT executables. The entry key
+// is a 128 bit hash of the serialized cluster GraphDef, the backend name, the
+// nGraph library version and the text signature of the inputs (see
+// ComputeTextSignature).
+//
+// The cache is enabled by pointing NGRAPH_TF_DISK_CACHE_DIR to a directory.
+// NGRAPH_TF_DISK_CACHE_SIZE_MB caps the total size of the entries in that
+// directory (default 2048 MB); when the cap is exceeded the least recently
+// used entries (by file modification time, which is refreshed on every hit)
+// are removed.
+//
+// Several processes can share the directory: entries are written to a
+// process unique temporary file and then renamed into place, so a reader
+// either sees a complete entry or no entry at all. If two processes compile
+// the same entry concurrently the last rename wins, and both blobs are
+// equivalent.
+//
+// General usage:
+//
+//   auto disk_cache = NGraphExecutableDiskCache::Global();  // may be nullptr
+//   string key = NGraphExecutableDiskCache::ComputeKey(
+//       NGraphExecutableDiskCache::GraphFingerprint(graph), backend_name,
+//       signature);
+//   std::shared_ptr<ngraph::runtime::Executable> ng_exec =
+//       disk_cache->Load(key, op_backend);
+//   if (ng_exec == nullptr) {
+//     ng_exec = op_backend->compile(ng_function);
+//     disk_cache->Store(key, ng_exec);
+//   }
+//
+class NGraphExecutableDiskCache {
+ public:
+  NGraphExecutableDiskCache(const string& cache_dir, int64 capacity_in_bytes);
+
+  // Returns the process wide cache configured through the environment, or
+  // nullptr if NGRAPH_TF_DISK_CACHE_DIR is not set
+  static NGraphExecutableDiskCache* Global();
+
+  // Returns a hex string identifying the contents of the graph
+  static string GraphFingerprint(const Graph& graph);
+
+  // Returns the hex key of the cache entry for the given graph fingerprint,
+  // backend and input signature
+  static string ComputeKey(const string& graph_fingerprint,
+                           const string& backend_name,
+                           const string& signature);
+
+  // Loads the executable stored under key. Returns nullptr on a miss, or if
+  // the stored blob could not be loaded by the backend (the stale entry is
+  // removed in that case). The caller must hold the backend lock.
+  std::shared_ptr<ngraph::runtime::Executable> Load(
+      const string& key, ngraph::runtime::Backend* op_backend);
+
+  // Saves the executable under key and evicts old entries if the directory
+  // grew over capacity. Backends that cannot save executables are not an
+  // error, the entry is simply not written.
+  Status Store(const string& key,
+               const std::shared_ptr<ngraph::runtime::Executable>& ng_exec);
+
+  // Lower level access to the raw entries
+  bool ReadEntry(const string& key, string* blob);
+  Status WriteEntry(const string& key, const string& blob);
+
+  // Removes the least recently used entries till the total size of the
+  // entries is within the capacity
+  Status EvictIfNeeded();
+
+  const string& GetCacheDir() const { return m_cache_dir; }
+  int64 GetCapacityInBytes() const { return m_capacity_in_bytes; }
+
+  int64 GetHitCount() const { return m_hits; }
+  int64 GetMissCount() const { return m_misses; }
+  int64 GetStoreCount() const { return m_stores; }
+  int64 GetEvictionCount() const { return m_evictions; }
+
+ private:
+  string EntryPath(const string& key) const;
+
+  const string m_cache_dir;
+  const int64 m_capacity_in_bytes;
+
+  std::atomic<int64> m_hits{0};
+  std::atomic<int64> m_misses{0};
+  std::atomic<int64> m_stores{0};
+  std::atomic<int64> m_evictions{0};
+  std::atomic<int64> m_tmp_file_count{0};
+
+  // Serializes eviction within the process
+  std::mutex m_evict_mutex;
+};
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_EXECUTABLE_DISK_CACHE_H_
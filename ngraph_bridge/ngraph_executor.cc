@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  *******************************************************************************/
+#include <algorithm>
 #include <cstdlib>
 #include <utility>
 
@@ -20,12 +21,15 @@
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/graph_to_functiondef.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/env.h"
 
 #include "ngraph/event_tracing.hpp"
 #include "ngraph/runtime/backend.hpp"
@@ -37,10 +41,13 @@
 #include "logging/ngraph_log.h"
 #include "ngraph_bridge/ngraph_backend_manager.h"
 #include "ngraph_bridge/ngraph_builder.h"
+#include "ngraph_bridge/ngraph_cache_budget.h"
 #include "ngraph_bridge/ngraph_cluster_manager.h"
 #include "ngraph_bridge/ngraph_data_cache.h"
+#include "ngraph_bridge/ngraph_executable_disk_cache.h"
 #include "ngraph_bridge/ngraph_executor.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "ngraph_bridge/ngraph_runtime_config.h"
 #include "ngraph_bridge/ngraph_timer.h"
 #include "ngraph_bridge/ngraph_utils.h"
 #include "ngraph_bridge/ngraph_var.h"
@@ -56,6 +63,9 @@ namespace tensorflow {
 
 namespace ngraph_bridge {
 
+std::atomic<int64> NGraphExecutor::s_compile_queue_depth{0};
+const size_t NGraphExecutor::kMaxFailedSignatures;
+
 //---------------------------------------------------------------------------
 //  NGraphExecutor::ctor
 //---------------------------------------------------------------------------
@@ -69,7 +79,9 @@ NGraphExecutor::NGraphExecutor(int instance_id, int cluster_id, int graph_id,
       m_graph(std::move(graph)),
       m_op_backend_name(backend_name),
       m_node_name(node_name),
-      m_ng_data_cache(cache_depth) {
+      m_ng_data_cache(cache_depth,
+                      std::bind(&NGraphExecutor::ItemCostCallback, this,
+                                std::placeholders::_1, std::placeholders::_2)) {
   // Sanity checks
   if (m_graph == nullptr) {
     throw std::runtime_error("Graph is nullptr!");
@@ -161,12 +173,55 @@ NGraphExecutor::NGraphExecutor(int instance_id, int cluster_id, int graph_id,
   m_tensor_manager = make_shared<NGraphTensorManager>(
       GetNgraphClusterName(), GetNgraphClusterId(), GetGraphId(),
       number_of_inputs, number_of_outputs);
+
+  // The fingerprint identifies this cluster in the executable disk cache
+  if (NGraphExecutableDiskCache::Global() != nullptr) {
+    m_graph_fingerprint = NGraphExecutableDiskCache::GraphFingerprint(*m_graph);
+  }
+
+  // The CPU backend computes in host memory, its outputs can be written
+  // directly to the TF output tensors
+  m_zero_copy_output =
+      BackendManager::GetBackendAttributeValues(
+          m_op_backend_name)["ngraph_backend"] == "CPU" &&
+      std::getenv("NGRAPH_TF_DISABLE_ZERO_COPY_OUTPUTS") == nullptr;
+
+  const char* pipeline_depth_specified =
+      std::getenv("NGRAPH_TF_PIPELINE_DEPTH");
+  if (pipeline_depth_specified != nullptr) {
+    Status status = SetTensorPipelineDepth(atoi(pipeline_depth_specified));
+    if (status != Status::OK()) {
+      throw std::runtime_error(status.error_message());
+    }
+  }
+
+  if (std::getenv("NGRAPH_TF_ASYNC_COMPILE") != nullptr) {
+    if (!CanUseFallback()) {
+      NGRAPH_VLOG(1) << "Not using asynchronous compilation for " << m_node_name
+                     << " since it has variables or prefetched inputs";
+    } else {
+      m_async_compile = true;
+    }
+    const char* retry_ms = std::getenv("NGRAPH_TF_ASYNC_COMPILE_RETRY_MS");
+    if (retry_ms != nullptr) {
+      m_compile_retry_ms = atoll(retry_ms);
+    }
+  }
 }
 
 //---------------------------------------------------------------------------
 //  NGraphExecutor::~NGraphExecutor
 //---------------------------------------------------------------------------
 NGraphExecutor::~NGraphExecutor() {
+  // The background compilations use this executor, wait for them to finish
+  {
+    mutex_lock lock(m_mutex);
+    while (m_pending_compiles > 0) {
+      m_pending_compiles_cv.wait(lock);
+    }
+  }
+
+  LogMemoryReport();
   auto backend = BackendManager::GetBackend(m_op_backend_name);
 
   auto destroy_ng_item_callback = std::bind(
@@ -182,30 +237,19 @@ Status NGraphExecutor::ComputeSignature(
     const std::vector<Tensor>& tf_input_tensors,
     std::vector<TensorShape>& input_shapes,
     std::vector<const Tensor*>& static_input_map,
-    std::stringstream& signature_ss) const {
+    NGraphSignature& signature) const {
   // Use tensorflow input tensors to get input_shapes, static_input_map
   // and compute the signature
-  for (int i = 0; i < tf_input_tensors.size(); i++) {
-    const Tensor& input_tensor = tf_input_tensors[i];
-    input_shapes.push_back(input_tensor.shape());
-    for (const auto& x : input_tensor.shape()) {
-      signature_ss << x.size << ",";
-    }
-    signature_ss << ";";
-  }
-
-  signature_ss << "/";
-
   static_input_map.resize(tf_input_tensors.size());
   for (int i = 0; i < tf_input_tensors.size(); i++) {
     const Tensor& input_tensor = tf_input_tensors[i];
+    input_shapes.push_back(input_tensor.shape());
     if (m_input_is_static[i]) {
       static_input_map[i] = &input_tensor;
-      TF_RETURN_IF_ERROR(TensorToStream(signature_ss, input_tensor));
-      signature_ss << ";";
     }
   }
-  return Status::OK();
+  return NGraphSignature::Compute(tf_input_tensors, m_input_is_static,
+                                  signature);
 }
 
 //---------------------------------------------------------------------------
@@ -214,18 +258,43 @@ Status NGraphExecutor::ComputeSignature(
 Status NGraphExecutor::GetExecutableFunctionAndTensors(
     const std::vector<Tensor>& tf_input_tensors,
     std::shared_ptr<ngraph::runtime::Executable>& ng_exec,
-    std::string& serialized_ng_func, shared_ptr<PipelinedTensorsStore>& pts,
+    NGraphFunctionRef& ng_function_ref, shared_ptr<PipelinedTensorsStore>& pts,
     bool& cache_hit) {
-  std::stringstream signature_ss;
+  NGraphSignature signature;
   std::vector<TensorShape> input_shapes;
   std::vector<const Tensor*> static_input_map;
   TF_RETURN_IF_ERROR(ComputeSignature(tf_input_tensors, input_shapes,
-                                      static_input_map, signature_ss));
-  string signature;
-  signature = signature_ss.str();
+                                      static_input_map, signature));
 
-  NGRAPH_VLOG(5) << "Computed signature: " << signature;
+  NGRAPH_VLOG(5) << "Computed signature: " << signature.ToString();
 
+  Timer lookup_timer;
+  Status status =
+      LookUpOrCreateItem(signature, input_shapes, static_input_map, ng_exec,
+                         ng_function_ref, pts, cache_hit);
+  if (!m_first_lookup_done.exchange(true)) {
+    NGRAPH_VLOG(1) << "NGRAPH_TF_STARTUP_REPORT: Cluster: " << m_node_name
+                   << " First step got its executable in "
+                   << lookup_timer.ElapsedInMS() << " ms"
+                   << " Cache hit: " << cache_hit
+                   << " Warmed up: " << m_warmup_requested;
+  }
+  if (m_shape_bucketing.IsEnabled()) {
+    m_shape_bucketing.RecordLookup(cache_hit, m_node_name);
+  }
+  return status;
+}
+
+//---------------------------------------------------------------------------
+//  NGraphExecutor::LookUpOrCreateItem
+//---------------------------------------------------------------------------
+Status NGraphExecutor::LookUpOrCreateItem(
+    const NGraphSignature& signature,
+    const std::vector<TensorShape>& input_shapes,
+    const std::vector<const Tensor*>& static_input_map,
+    std::shared_ptr<ngraph::runtime::Executable>& ng_exec,
+    NGraphFunctionRef& ng_function_ref, shared_ptr<PipelinedTensorsStore>& pts,
+    bool& cache_hit) {
   NGRAPH_VLOG(4) << "GetNgExecutable: Got backend of type: "
                  << m_op_backend_name;
   // Get the backend. Note that the backend may not be available
@@ -245,97 +314,523 @@ Status NGraphExecutor::GetExecutableFunctionAndTensors(
   auto destroy_ng_items_callback =
       std::bind(&NGraphExecutor::DestroyCallback, this, std::placeholders::_1,
                 op_backend);
-  // Get NgItems i.e. ng_executable, serialized ng_functions from Data Cache
+  // Get NgItems i.e. ng_executable, ng_functions from Data Cache
   auto status_ng_item_pair =
       m_ng_data_cache.LookUpOrCreate(signature, create_ng_items_callback,
                                      destroy_ng_items_callback, cache_hit);
 
   if (status_ng_item_pair.first == Status::OK()) {
-    std::tie(ng_exec, serialized_ng_func, pts) = status_ng_item_pair.second;
+    std::tie(ng_exec, ng_function_ref, pts) = status_ng_item_pair.second;
+    if (!cache_hit) {
+      LogMemoryReport();
+    }
   }
   return status_ng_item_pair.first;
 }
 
+//---------------------------------------------------------------------------
+//  NGraphExecutor::GetMemoryReport
+//---------------------------------------------------------------------------
+NGraphExecutor::MemoryReport NGraphExecutor::GetMemoryReport() {
+  MemoryReport report;
+  report.shared_bytes = m_constant_pool.GetBytes();
+  report.private_bytes = m_ng_data_cache.GetChargedBytes();
+  report.num_executables = m_ng_data_cache.Size();
+  return report;
+}
+
+//---------------------------------------------------------------------------
+//  NGraphExecutor::LogMemoryReport
+//---------------------------------------------------------------------------
+void NGraphExecutor::LogMemoryReport() {
+  MemoryReport report = GetMemoryReport();
+  NGRAPH_VLOG(1) << "NGRAPH_TF_MEMORY_REPORT: Cluster: " << m_node_name
+                 << " Executables: " << report.num_executables
+                 << " Shared constant bytes: " << report.shared_bytes
+                 << " Private bytes: " << report.private_bytes;
+}
+
+//---------------------------------------------------------------------------
+//  NGraphExecutor::GetExecutableFunctionAndTensorsAsync
+//---------------------------------------------------------------------------
+Status NGraphExecutor::GetExecutableFunctionAndTensorsAsync(
+    const std::vector<Tensor>& tf_input_tensors,
+    std::shared_ptr<ngraph::runtime::Executable>& ng_exec,
+    NGraphFunctionRef& ng_function_ref, shared_ptr<PipelinedTensorsStore>& pts,
+    bool& cache_hit) {
+  NGraphSignature signature;
+  std::vector<TensorShape> input_shapes;
+  std::vector<const Tensor*> static_input_map;
+  TF_RETURN_IF_ERROR(ComputeSignature(tf_input_tensors, input_shapes,
+                                      static_input_map, signature));
+  NGRAPH_VLOG(5) << "Computed signature: " << signature.ToString();
+
+  std::tuple<std::shared_ptr<ngraph::runtime::Executable>, NGraphFunctionRef,
+             shared_ptr<PipelinedTensorsStore>>
+      ng_item;
+  cache_hit = m_ng_data_cache.LookUp(signature, ng_item);
+  if (m_shape_bucketing.IsEnabled()) {
+    m_shape_bucketing.RecordLookup(cache_hit, m_node_name);
+  }
+  if (cache_hit) {
+    std::tie(ng_exec, ng_function_ref, pts) = ng_item;
+    return Status::OK();
+  }
+
+  ng_exec = nullptr;
+  {
+    mutex_lock lock(m_mutex);
+    if (m_pending_signatures.count(signature) != 0) {
+      return Status::OK();
+    }
+    auto failed = m_failed_signatures.find(signature);
+    if (failed != m_failed_signatures.end()) {
+      int64 failed_for_us = Env::Default()->NowMicros() - failed->second;
+      if (m_compile_retry_ms < 0 || failed_for_us < m_compile_retry_ms * 1000) {
+        return Status::OK();
+      }
+      NGRAPH_VLOG(1) << "Retrying the background compilation of "
+                     << m_node_name;
+      m_failed_signatures.erase(failed);
+      m_failed_lru.Remove(signature);
+    }
+    m_pending_signatures.insert(signature);
+    m_pending_compiles++;
+  }
+
+  NGRAPH_VLOG(1) << "Compiling " << m_node_name
+                 << " in the background, queued compilations: "
+                 << s_compile_queue_depth;
+  s_compile_queue_depth++;
+  // The input tensors are copied (these are refcounted, not the data), the
+  // static ones are needed for the translation
+  GetCompileThreadPool()->Schedule([this, signature, tf_input_tensors]() {
+    CompileInBackground(signature, tf_input_tensors);
+  });
+  return Status::OK();
+}
+
+//---------------------------------------------------------------------------
+//  NGraphExecutor::CompileInBackground
+//---------------------------------------------------------------------------
+void NGraphExecutor::CompileInBackground(
+    const NGraphSignature& signature,
+    const std::vector<Tensor>& tf_input_tensors) {
+  NGraphSignature input_signature;
+  std::vector<TensorShape> input_shapes;
+  std::vector<const Tensor*> static_input_map;
+  std::shared_ptr<ngraph::runtime::Executable> ng_exec;
+  NGraphFunctionRef ng_function_ref;
+  shared_ptr<PipelinedTensorsStore> pts;
+  bool cache_hit;
+  Status status = ComputeSignature(tf_input_tensors, input_shapes,
+                                   static_input_map, input_signature);
+  if (status == Status::OK()) {
+    status = LookUpOrCreateItem(signature, input_shapes, static_input_map,
+                                ng_exec, ng_function_ref, pts, cache_hit);
+  }
+  s_compile_queue_depth--;
+
+  mutex_lock lock(m_mutex);
+  m_pending_signatures.erase(signature);
+  if (status != Status::OK()) {
+    NGRAPH_VLOG(0) << "Background compilation of " << m_node_name
+                   << " failed, the cluster keeps running in TensorFlow for "
+                      "these inputs for now: "
+                   << status.error_message();
+    if (m_failed_lru.Size() >= kMaxFailedSignatures) {
+      NGraphSignature oldest = m_failed_lru.LeastRecent();
+      m_failed_signatures.erase(oldest);
+      m_failed_lru.Remove(oldest);
+    }
+    m_failed_signatures[signature] = Env::Default()->NowMicros();
+    m_failed_lru.Touch(signature);
+  }
+  m_pending_compiles--;
+  m_pending_compiles_cv.notify_all();
+}
+
+//---------------------------------------------------------------------------
+//  NGraphExecutor::WarmUp
+//---------------------------------------------------------------------------
+Status NGraphExecutor::WarmUp(const std::vector<TensorShape>& input_shapes) {
+  if (input_shapes.size() != m_input_is_static.size()) {
+    return errors::InvalidArgument("Got ", input_shapes.size(),
+                                   " warm-up shapes for the ",
+                                   m_input_is_static.size(), " inputs of ",
+                                   m_node_name);
+  }
+  for (bool is_static : m_input_is_static) {
+    if (is_static) {
+      NGRAPH_VLOG(1) << "Not warming up " << m_node_name
+                     << " since it has static inputs";
+      return Status::OK();
+    }
+  }
+
+  std::vector<DataType> dtypes(input_shapes.size(), DT_INVALID);
+  for (auto node : m_graph->op_nodes()) {
+    if (node->type_string() == "_Arg") {
+      int index;
+      TF_RETURN_IF_ERROR(GetNodeAttr(node->attrs(), "index", &index));
+      TF_RETURN_IF_ERROR(GetNodeAttr(node->attrs(), "T", &dtypes[index]));
+    }
+  }
+  NGraphSignature signature;
+  TF_RETURN_IF_ERROR(NGraphSignature::Compute(dtypes, input_shapes, signature));
+
+  {
+    mutex_lock lock(m_mutex);
+    if (m_pending_signatures.count(signature) != 0) {
+      return Status::OK();
+    }
+    m_pending_signatures.insert(signature);
+    m_pending_compiles++;
+  }
+  m_warmup_requested = true;
+  s_compile_queue_depth++;
+
+  Timer queue_timer;
+  GetCompileThreadPool()->Schedule(
+      [this, signature, input_shapes, queue_timer]() mutable {
+        int queued_ms = queue_timer.ElapsedInMS();
+        Timer compile_timer;
+        std::vector<const Tensor*> static_input_map(input_shapes.size(),
+                                                    nullptr);
+        std::shared_ptr<ngraph::runtime::Executable> ng_exec;
+        NGraphFunctionRef ng_function_ref;
+        shared_ptr<PipelinedTensorsStore> pts;
+        bool cache_hit;
+        Status status =
+            LookUpOrCreateItem(signature, input_shapes, static_input_map,
+                               ng_exec, ng_function_ref, pts, cache_hit);
+        s_compile_queue_depth--;
+        NGRAPH_VLOG(1) << "NGRAPH_TF_STARTUP_REPORT: Cluster: " << m_node_name
+                       << " Warm-up queued: " << queued_ms << " ms"
+                       << " Compiled: " << compile_timer.ElapsedInMS() << " ms"
+                       << " Status: " << status.ToString();
+
+        mutex_lock lock(m_mutex);
+        m_pending_signatures.erase(signature);
+        m_pending_compiles--;
+        m_pending_compiles_cv.notify_all();
+      });
+  return Status::OK();
+}
+
+//---------------------------------------------------------------------------
+//  NGraphExecutor::GetCompileThreadPool
+//---------------------------------------------------------------------------
+thread::ThreadPool* NGraphExecutor::GetCompileThreadPool() {
+  static thread::ThreadPool* compile_thread_pool = []() {
+    int num_threads = 2;
+    const char* num_threads_specified =
+        std::getenv("NGRAPH_TF_ASYNC_COMPILE_THREADS");
+    if (num_threads_specified != nullptr) {
+      num_threads = std::max(1, atoi(num_threads_specified));
+    }
+    NGRAPH_VLOG(1) << "Asynchronous compilation threads: " << num_threads;
+    return new thread::ThreadPool(Env::Default(), "ngraph_compile",
+                                  num_threads);
+  }();
+  return compile_thread_pool;
+}
+
+//---------------------------------------------------------------------------
+//  NGraphExecutor::CanUseFallback
+//---------------------------------------------------------------------------
+bool NGraphExecutor::CanUseFallback() const {
+  return m_tensor_manager->GetInputIndexesFedByVariables().empty() &&
+         m_tensor_manager->GetOutputIndexesAssigningVariables().empty() &&
+         m_tensor_manager->GetPrefetchedInputIndexes().empty();
+}
+
+//---------------------------------------------------------------------------
+//  NGraphExecutor::GetFallbackFunctionDef
+//---------------------------------------------------------------------------
+Status NGraphExecutor::GetFallbackFunctionDef(const string& function_name,
+                                              FunctionDef* fdef) const {
+  return GraphToFunctionDef(*m_graph, function_name, fdef);
+}
+
+//---------------------------------------------------------------------------
+//  NGraphExecutor::GetClusterNodeNames
+//---------------------------------------------------------------------------
+std::vector<string> NGraphExecutor::GetClusterNodeNames() const {
+  std::vector<string> node_names;
+  for (auto node : m_graph->op_nodes()) {
+    if (!node->IsArg() && !node->IsRetval()) {
+      node_names.push_back(node->name());
+    }
+  }
+  return node_names;
+}
+
+//---------------------------------------------------------------------------
+//  NGraphExecutor::SetTensorPipelineDepth
+//---------------------------------------------------------------------------
+Status NGraphExecutor::SetTensorPipelineDepth(int depth) {
+  if (depth < 1 || depth > IndexLibrary::kMaxDepth) {
+    return errors::InvalidArgument("Pipeline depth must be between 1 and ",
+                                   IndexLibrary::kMaxDepth, ", got ", depth,
+                                   " for ", m_node_name);
+  }
+  // One group of tensors is with the prefetcher while another one executes
+  if (depth < 2 && !m_tensor_manager->GetPrefetchedInputIndexes().empty()) {
+    return errors::InvalidArgument(
+        "Pipeline depth must be at least 2 with prefetched inputs, got ",
+        depth, " for ", m_node_name);
+  }
+  NGRAPH_VLOG(1) << "Pipeline depth of " << m_node_name << ": " << depth;
+  m_depth = depth;
+  return Status::OK();
+}
+
+//---------------------------------------------------------------------------
+//  NGraphExecutor::BucketInputTensors
+//---------------------------------------------------------------------------
+Status NGraphExecutor::BucketInputTensors(
+    std::vector<Tensor>& tf_input_tensors,
+    std::vector<BucketedDims>& output_bucketed_dims) {
+  output_bucketed_dims.clear();
+  if (!m_shape_bucketing.IsEnabled()) {
+    return Status::OK();
+  }
+  std::vector<Tensor> padded_input_tensors;
+  BucketedDims bucketed_dims;
+  TF_RETURN_IF_ERROR(m_shape_bucketing.PadInputs(
+      tf_input_tensors, m_input_is_static, padded_input_tensors,
+      bucketed_dims));
+  if (bucketed_dims.empty()) {
+    return Status::OK();
+  }
+  Status status = FindBucketedOutputDims(padded_input_tensors, bucketed_dims,
+                                         output_bucketed_dims);
+  if (errors::IsUnimplemented(status)) {
+    // The padding would change the results, run on the inputs as they are
+    NGRAPH_VLOG(0) << "Disabling shape bucketing of " << m_node_name << ": "
+                   << status.error_message();
+    m_shape_bucketing.Disable();
+    output_bucketed_dims.clear();
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(status);
+  tf_input_tensors.swap(padded_input_tensors);
+  return Status::OK();
+}
+
+//---------------------------------------------------------------------------
+//  NGraphExecutor::FindBucketedOutputDims
+//---------------------------------------------------------------------------
+Status NGraphExecutor::FindBucketedOutputDims(
+    const std::vector<Tensor>& padded_input_tensors,
+    const BucketedDims& bucketed_dims,
+    std::vector<BucketedDims>& output_bucketed_dims) {
+  NGraphSignature signature;
+  TF_RETURN_IF_ERROR(NGraphSignature::Compute(padded_input_tensors,
+                                              m_input_is_static, signature));
+  {
+    mutex_lock lock(m_mutex);
+    auto itr = m_bucketed_output_dims.find(signature);
+    if (itr != m_bucketed_output_dims.end()) {
+      output_bucketed_dims = itr->second;
+      return Status::OK();
+    }
+  }
+
+  std::vector<TensorShape> input_shapes;
+  std::vector<const Tensor*> static_input_map(padded_input_tensors.size(),
+                                              nullptr);
+  for (int i = 0; i < padded_input_tensors.size(); i++) {
+    input_shapes.push_back(padded_input_tensors[i].shape());
+    if (m_input_is_static[i]) {
+      static_input_map[i] = &padded_input_tensors[i];
+    }
+  }
+  std::shared_ptr<ngraph::Function> padded_function;
+  TF_RETURN_IF_ERROR(Builder::TranslateGraph(
+      input_shapes, static_input_map, m_graph.get(), padded_function,
+      &m_constant_pool, &m_translation_plan));
+
+  output_bucketed_dims.assign(padded_function->get_output_size(),
+                              BucketedDims());
+  for (const auto& bucketed_dim : bucketed_dims) {
+    int dim = bucketed_dim.first;
+    int64 bucket_size = bucketed_dim.second.second;
+    std::vector<TensorShape> probe_shapes = input_shapes;
+    for (int i = 0; i < probe_shapes.size(); i++) {
+      if (!m_input_is_static[i] && probe_shapes[i].dims() > dim) {
+        probe_shapes[i].set_dim(dim, bucket_size + 1);
+      }
+    }
+    std::shared_ptr<ngraph::Function> probe_function;
+    Status status = Builder::TranslateGraph(
+        probe_shapes, static_input_map, m_graph.get(), probe_function,
+        &m_constant_pool, &m_translation_plan);
+    if (!status.ok()) {
+      return errors::Unimplemented("Translation fails when dimension ", dim,
+                                   " is not ", bucket_size, ": ",
+                                   status.error_message());
+    }
+
+    std::vector<std::vector<int>> output_dims;
+    TF_RETURN_IF_ERROR(NGraphShapeBucketing::FindOutputDims(
+        padded_function, probe_function, bucket_size, output_dims));
+    for (int i = 0; i < output_dims.size(); i++) {
+      for (int output_dim : output_dims[i]) {
+        if (output_bucketed_dims[i].count(output_dim) != 0) {
+          return errors::Unimplemented("Dimension ", output_dim, " of output ",
+                                       i, " depends on two bucketed ",
+                                       "dimensions");
+        }
+        output_bucketed_dims[i][output_dim] = bucketed_dim.second;
+      }
+    }
+  }
+
+  NGRAPH_VLOG(3) << "Found the bucketed output dimensions of " << m_node_name
+                 << " for signature " << signature.ToString();
+  mutex_lock lock(m_mutex);
+  m_bucketed_output_dims[signature] = output_bucketed_dims;
+  return Status::OK();
+}
+
 //---------------------------------------------------------------------------
 //  NGraphExecutor::CallbackCreateItem
 //---------------------------------------------------------------------------
-std::pair<Status, std::tuple<std::shared_ptr<ngraph::runtime::Executable>,
-                             std::string, shared_ptr<PipelinedTensorsStore>>>
-NGraphExecutor::CreateCallback(const std::string signature,
+std::pair<Status,
+          std::tuple<std::shared_ptr<ngraph::runtime::Executable>,
+                     NGraphFunctionRef, shared_ptr<PipelinedTensorsStore>>>
+NGraphExecutor::CreateCallback(const NGraphSignature signature,
                                std::vector<TensorShape> input_shapes,
                                std::vector<const Tensor*> static_input_map,
                                ng::runtime::Backend*& op_backend) {
-  std::string serialized_ng_func;
+  NGraphFunctionRef ng_function_ref;
   std::shared_ptr<ngraph::runtime::Executable> ng_exec;
   std::shared_ptr<ngraph::Function> ng_function;
   shared_ptr<PipelinedTensorsStore> pts;
   NGRAPH_VLOG(1) << "Compilation cache miss: " << m_node_name;
-  if (!m_do_aot) {
-    auto status = Builder::TranslateGraph(input_shapes, static_input_map,
-                                          m_graph.get(), ng_function);
+
+  // Measure what the executable costs, to weigh it for eviction
+  Timer create_timer;
+
+  // The AOT executables and the disk cache entries are named by the text
+  // signature
+  string text_signature;
+  if (m_do_aot || NGraphExecutableDiskCache::Global() != nullptr) {
+    auto status = ComputeTextSignature(input_shapes, static_input_map,
+                                       text_signature);
     if (status != Status::OK()) {
       return std::make_pair(status,
-                            std::make_tuple(ng_exec, serialized_ng_func, pts));
-    }
-    ng_function->set_friendly_name(m_node_name);
-    int json_indentation = 4;
-    serialized_ng_func = ngraph::serialize(ng_function, json_indentation);
-  } else {
-    auto itr = m_aot_functions.find(signature);
-    if (itr == m_aot_functions.end()) {
-      return std::make_pair(
-          errors::Internal(
-              "Expected to find AOT precompiled ng function of signature: ",
-              signature),
-          std::make_tuple(ng_exec, serialized_ng_func, pts));
+                            std::make_tuple(ng_exec, ng_function_ref, pts));
     }
-    serialized_ng_func = itr->second;
   }
 
-  // Serialize to nGraph if needed
-  if (std::getenv("NGRAPH_ENABLE_SERIALIZE") != nullptr) {
-#if defined NGRAPH_DISTRIBUTED
-    int rank_id;
-    rank_id = ng::get_distributed_interface()->get_rank();
-    auto status = StringToFile(
-        "tf_function_" + m_node_name + "_" + to_string(rank_id) + ".json",
-        serialized_ng_func);
-    if (status != Status::OK()) {
-      return std::make_pair(status,
-                            std::make_tuple(ng_exec, serialized_ng_func, pts));
+  // Look in the persistent executable cache first, a hit there skips both
+  // the translation and the compilation
+  auto disk_cache = NGraphExecutableDiskCache::Global();
+  string disk_cache_key;
+  if (disk_cache != nullptr && !m_do_aot) {
+    disk_cache_key = NGraphExecutableDiskCache::ComputeKey(
+        m_graph_fingerprint, m_op_backend_name, text_signature);
+    BackendManager::LockBackend(m_op_backend_name);
+    ng_exec = disk_cache->Load(disk_cache_key, op_backend);
+    BackendManager::UnlockBackend(m_op_backend_name);
+  }
+
+  if (ng_exec == nullptr) {
+    if (!m_do_aot) {
+      auto status = Builder::TranslateGraph(
+          input_shapes, static_input_map, m_graph.get(), ng_function,
+          &m_constant_pool, &m_translation_plan);
+      if (status != Status::OK()) {
+        return std::make_pair(
+            status, std::make_tuple(ng_exec, ng_function_ref, pts));
+      }
+      ng_function->set_friendly_name(m_node_name);
+      ng_function_ref = NGraphFunctionRef(ng_function);
+    } else {
+      auto itr = m_aot_functions.find(text_signature);
+      if (itr == m_aot_functions.end()) {
+        return std::make_pair(
+            errors::Internal(
+                "Expected to find AOT precompiled ng function of signature: ",
+                text_signature),
+            std::make_tuple(ng_exec, ng_function_ref, pts));
+      }
+      ng_function_ref = NGraphFunctionRef(itr->second);
     }
+
+    // Serialize to nGraph if needed
+    if (NGraphRuntimeConfig::Get().enable_serialize) {
+#if defined NGRAPH_DISTRIBUTED
+      int rank_id;
+      rank_id = ng::get_distributed_interface()->get_rank();
+      auto status = ng_function_ref.ToFile(
+          "tf_function_" + m_node_name + "_" + to_string(rank_id) + ".json");
+      if (status != Status::OK()) {
+        return std::make_pair(
+            status, std::make_tuple(ng_exec, ng_function_ref, pts));
+      }
 #else
-    auto status_ser = StringToFile("tf_function_" + m_node_name + ".json",
-                                   serialized_ng_func);
-    if (status_ser != Status::OK()) {
-      return std::make_pair(status_ser,
-                            std::make_tuple(ng_exec, serialized_ng_func, pts));
-    }
+      auto status_ser =
+          ng_function_ref.ToFile("tf_function_" + m_node_name + ".json");
+      if (status_ser != Status::OK()) {
+        return std::make_pair(
+            status_ser, std::make_tuple(ng_exec, ng_function_ref, pts));
+      }
 #endif
-  }
-  // Get NgExecutable
-  auto status_ng_exec_pair =
-      GetNgExecutable(signature, ng_function, op_backend);
-  // Create PipelinedTensorStore
-  if (status_ng_exec_pair.first == Status::OK()) {
+    }
+    // Get NgExecutable
+    auto status_ng_exec_pair =
+        GetNgExecutable(text_signature, ng_function, op_backend);
+    if (status_ng_exec_pair.first != Status::OK()) {
+      Status st =
+          ng_function_ref.ToFile("tf_function_error_" + m_node_name + ".json");
+      string status_string =
+          "Error in compiling op_backend with error: " +
+          status_ng_exec_pair.first.error_message() +
+          (st.ok() ? "" : (" Also error in dumping serialized function: " +
+                           st.error_message()));
+      return std::make_pair(errors::Internal(status_string),
+                            std::make_tuple(ng_exec, ng_function_ref, pts));
+    }
     ng_exec = status_ng_exec_pair.second;
-    auto status_ng_pts_pair = InitializeIOTensorPipeline(
-        ng_exec, m_tensor_manager->GetPipelinedInputIndexes(),
-        m_tensor_manager->GetPipelinedOutputIndexes());
-    pts = status_ng_pts_pair.second;
-    return std::make_pair(status_ng_pts_pair.first,
-                          std::make_tuple(ng_exec, serialized_ng_func, pts));
+
+    // Persist the freshly compiled executable for the next process
+    if (!disk_cache_key.empty()) {
+      Status status_store = disk_cache->Store(disk_cache_key, ng_exec);
+      if (!status_store.ok()) {
+        NGRAPH_VLOG(0) << "Failed to write executable disk cache entry for "
+                       << m_node_name << ": " << status_store.error_message();
+      }
+    }
+  }
+
+  NGraphCacheItemCost cost;
+  // See executable_bytes. The pooled constants are charged by the pool, for
+  // all the signatures. There is no function to estimate from for an AOT or
+  // disk cache executable.
+  if (ng_function != nullptr) {
+    cost.executable_bytes =
+        EstimateExecutableBytes(ng_function, &m_constant_pool);
   } else {
-    Status st = StringToFile("tf_function_error_" + m_node_name + ".json",
-                             serialized_ng_func);
-    string status_string =
-        "Error in compiling op_backend with error: " +
-        status_ng_exec_pair.first.error_message() +
-        (st.ok() ? "" : (" Also error in dumping serialized function: " +
-                         st.error_message()));
-    return std::make_pair(errors::Internal(status_string),
-                          std::make_tuple(ng_exec, serialized_ng_func, pts));
+    NGRAPH_VLOG(1) << "No function to estimate the executable bytes of "
+                   << m_node_name << " from, charging 0";
+  }
+  cost.compile_time_ms = create_timer.ElapsedInMS();
+
+  // Create PipelinedTensorStore
+  auto status_ng_pts_pair = InitializeIOTensorPipeline(
+      ng_exec, m_tensor_manager->GetPipelinedInputIndexes(),
+      m_tensor_manager->GetPipelinedOutputIndexes());
+  pts = status_ng_pts_pair.second;
+  if (status_ng_pts_pair.first == Status::OK()) {
+    mutex_lock lock(m_mutex);
+    m_create_costs[signature] = cost;
   }
+  return std::make_pair(status_ng_pts_pair.first,
+                        std::make_tuple(ng_exec, ng_function_ref, pts));
 }
 
 //---------------------------------------------------------------------------
@@ -388,8 +883,8 @@ NGraphExecutor::GetNgExecutable(std::string signature,
 //  NGraphExecutor::DestroyCallback
 //---------------------------------------------------------------------------
 void NGraphExecutor::DestroyCallback(
-    std::tuple<std::shared_ptr<ngraph::runtime::Executable>, std::string,
-               shared_ptr<PipelinedTensorsStore>>
+    std::tuple<std::shared_ptr<ngraph::runtime::Executable>,
+               NGraphFunctionRef, shared_ptr<PipelinedTensorsStore>>
         evicted_ng_item,
     ng::runtime::Backend*& op_backend) {
   std::shared_ptr<ngraph::runtime::Executable> evicted_ng_exec;
@@ -399,6 +894,41 @@ void NGraphExecutor::DestroyCallback(
   evicted_ng_exec.reset();
 }
 
+//---------------------------------------------------------------------------
+//  NGraphExecutor::ItemCostCallback
+//---------------------------------------------------------------------------
+NGraphCacheItemCost NGraphExecutor::ItemCostCallback(
+    NGraphSignature signature,
+    std::tuple<std::shared_ptr<ngraph::runtime::Executable>,
+               NGraphFunctionRef, shared_ptr<PipelinedTensorsStore>>
+        ng_item) {
+  NGraphCacheItemCost cost;
+  {
+    mutex_lock lock(m_mutex);
+    auto itr = m_create_costs.find(signature);
+    if (itr != m_create_costs.end()) {
+      cost = itr->second;
+      m_create_costs.erase(itr);
+    }
+  }
+  shared_ptr<PipelinedTensorsStore> pts;
+  std::tie(std::ignore, std::ignore, pts) = ng_item;
+  if (pts != nullptr) {
+    cost.tensor_bytes = pts->get_size_in_bytes();
+  }
+  NGRAPH_VLOG(1) << "NGRAPH_TF_CACHE_PROFILE: OP_ID: " << m_instance_id
+                 << " Cluster: " << m_node_name
+                 << " Estimated executable bytes: " << cost.executable_bytes
+                 << " Tensor bytes: " << cost.tensor_bytes
+                 << " Compile time: " << cost.compile_time_ms << " ms"
+                 << " Shared constant bytes: " << m_constant_pool.GetBytes()
+                 << " Total cached bytes: "
+                 << NGraphCacheBudget::GetChargedBytes()
+                 << " Total shared bytes: "
+                 << NGraphCacheBudget::GetSharedBytes();
+  return cost;
+}
+
 //---------------------------------------------------------------------------
 //  ParseNodeAttributes
 //---------------------------------------------------------------------------
@@ -445,6 +975,32 @@ Status NGraphExecutor::ParseNodeAttributes(
               "attribute named: ",
               itx.first);
         }
+      } else if (attr_name == "_ngraph_pipeline_depth") {
+        // Handled by the bridge, not passed on to the backend
+        int depth;
+        if (!strings::safe_strto32(attr_value, &depth)) {
+          return errors::InvalidArgument("Invalid pipeline depth ", attr_value,
+                                         " for ", m_node_name);
+        }
+        TF_RETURN_IF_ERROR(SetTensorPipelineDepth(depth));
+      } else if (attr_name == "_ngraph_warmup_shapes") {
+        // Handled by the encapsulate op, see WarmUp()
+        continue;
+      } else if (attr_name == "_ngraph_shape_buckets") {
+        // Handled by the bridge, not passed on to the backend
+        TF_RETURN_IF_ERROR(m_shape_bucketing.Initialize(attr_value));
+        if (!m_tensor_manager->GetPrefetchedInputIndexes().empty() ||
+            m_tensor_manager->GetOutputIndexesThatNeedCopy().size() !=
+                m_tensor_manager->GetNumberOfOutputs()) {
+          NGRAPH_VLOG(0) << "Shape bucketing is not supported for "
+                         << m_node_name
+                         << " since it has prefetched inputs or variable "
+                            "outputs, ignoring _ngraph_shape_buckets";
+          TF_RETURN_IF_ERROR(m_shape_bucketing.Initialize(""));
+        } else {
+          NGRAPH_VLOG(1) << "Using shape buckets " << attr_value << " for "
+                         << m_node_name;
+        }
       } else {
         NGRAPH_VLOG(4) << "Attribute: " << attr_name.substr(strlen("_ngraph_"))
                        << " Value: " << attr_value;
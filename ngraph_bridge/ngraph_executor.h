@@ -18,20 +18,31 @@
 #define NGRAPH_EXECUTOR_H_
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <ostream>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 
 #include "ngraph/ngraph.hpp"
 
 #include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_builder.h"
+#include "ngraph_bridge/ngraph_cache_lru.h"
+#include "ngraph_bridge/ngraph_constant_pool.h"
 #include "ngraph_bridge/ngraph_data_cache.h"
 #include "ngraph_bridge/ngraph_freshness_tracker.h"
 #include "ngraph_bridge/ngraph_pipelined_tensors.h"
+#include "ngraph_bridge/ngraph_shape_bucketing.h"
+#include "ngraph_bridge/ngraph_signature.h"
 #include "ngraph_bridge/ngraph_tensor_manager.h"
+#include "ngraph_bridge/ngraph_utils.h"
 
 namespace tensorflow {
 
@@ -53,30 +64,93 @@ class NGraphExecutor {
   Status GetExecutableFunctionAndTensors(
       const std::vector<Tensor>& tf_input_tensors,
       std::shared_ptr<ngraph::runtime::Executable>& ng_exec,
-      std::string& serialized_ng_function,
+      NGraphFunctionRef& ng_function_ref,
       shared_ptr<PipelinedTensorsStore>& pts, bool& cache_hit);
 
+  // Same as GetExecutableFunctionAndTensors(), but does not block on a cache
+  // miss. The executable is compiled on a background thread instead and
+  // ng_exec is set to nullptr; the caller is expected to run the step with
+  // the TensorFlow kernels of the cluster (see GetFallbackFunctionDef())
+  Status GetExecutableFunctionAndTensorsAsync(
+      const std::vector<Tensor>& tf_input_tensors,
+      std::shared_ptr<ngraph::runtime::Executable>& ng_exec,
+      NGraphFunctionRef& ng_function_ref,
+      shared_ptr<PipelinedTensorsStore>& pts, bool& cache_hit);
+
+  // Whether a step of the cluster can run with its TensorFlow kernels (see
+  // GetFallbackFunctionDef()) instead of its executable. Not if the cluster
+  // reads or assigns variables or has prefetched inputs, the fallback cannot
+  // see those.
+  bool CanUseFallback() const;
+
+  // Asynchronous compilation is requested with NGRAPH_TF_ASYNC_COMPILE and is
+  // used only for clusters that CanUseFallback()
+  bool IsAsyncCompileEnabled() const { return m_async_compile; }
+
+  // Compiles the executable for inputs of the given shapes on the compile
+  // thread pool, ahead of the first step. The first step then finds it in
+  // the cache, or waits for the compilation in flight. Clusters with static
+  // inputs are not warmed up, their executables depend on input values.
+  Status WarmUp(const std::vector<TensorShape>& input_shapes);
+
+  // Returns the encapsulated graph as a function named function_name, to be
+  // run by TensorFlow while its executable is being compiled
+  Status GetFallbackFunctionDef(const string& function_name,
+                                FunctionDef* fdef) const;
+
+  // Names of the nodes of the encapsulated graph, other than its _Arg and
+  // _Retval nodes
+  std::vector<string> GetClusterNodeNames() const;
+
+  // Number of steps run with the fallback, for this executor
+  int64 GetFallbackStepCount() const { return m_fallback_steps; }
+  void RecordFallbackStep() { m_fallback_steps++; }
+
+  // Number of compilations queued or running, for all the executors
+  static int64 GetCompileQueueDepth() { return s_compile_queue_depth; }
+
   // TODO Rename this to DecodeAttributes
   Status ParseNodeAttributes(
       const google::protobuf::Map<string, AttrValue>& additional_attributes,
       std::unordered_map<std::string, std::string>* additional_attribute_map);
 
   // Callback function called from NgraphDataCache's LookUpOrCreateItem() method
-  // Creates ng_executable, serialized_ng_function, and initializes I/O
+  // Creates ng_executable, ng_function reference, and initializes I/O
   // TensorPipeline
-  std::pair<Status, std::tuple<std::shared_ptr<ngraph::runtime::Executable>,
-                               std::string, shared_ptr<PipelinedTensorsStore>>>
-  CreateCallback(std::string signature, std::vector<TensorShape> input_shapes,
+  std::pair<Status,
+            std::tuple<std::shared_ptr<ngraph::runtime::Executable>,
+                       NGraphFunctionRef, shared_ptr<PipelinedTensorsStore>>>
+  CreateCallback(NGraphSignature signature,
+                 std::vector<TensorShape> input_shapes,
                  std::vector<const Tensor*> static_input_map,
                  ng::runtime::Backend*& op_backend);
 
   const int& GetNgraphClusterId() { return m_ngraph_cluster_id; }
 
   void DestroyCallback(
-      std::tuple<std::shared_ptr<ngraph::runtime::Executable>, std::string,
-                 shared_ptr<PipelinedTensorsStore>>
+      std::tuple<std::shared_ptr<ngraph::runtime::Executable>,
+                 NGraphFunctionRef, shared_ptr<PipelinedTensorsStore>>
           evicted_ng_item,
       ng::runtime::Backend*& op_backend);
+
+  // Callback function called from NgraphDataCache when an item is inserted,
+  // returns the memory it holds and the time it took to create it
+  NGraphCacheItemCost ItemCostCallback(
+      NGraphSignature signature,
+      std::tuple<std::shared_ptr<ngraph::runtime::Executable>,
+                 NGraphFunctionRef, shared_ptr<PipelinedTensorsStore>>
+          ng_item);
+  // Memory held by the cluster: the constants shared by the executables of
+  // all its signatures, and what the cached executables hold privately
+  // (executable and I/O tensor memory)
+  struct MemoryReport {
+    int64 shared_bytes = 0;
+    int64 private_bytes = 0;
+    int num_executables = 0;
+  };
+  MemoryReport GetMemoryReport();
+  void LogMemoryReport();
+
   const string& GetNgraphClusterName() { return m_node_name; }
 
   int GetGraphId() { return m_graph_id; }
@@ -89,10 +163,27 @@ class NGraphExecutor {
     return m_executable_can_create_tensor ? m_depth : 1;
   }
 
+  // Sets the number of groups of pipelined I/O tensors created for each
+  // executable, i.e. the number of steps that can be in flight at once. Set
+  // from NGRAPH_TF_PIPELINE_DEPTH or the _ngraph_pipeline_depth attribute, it
+  // must be set before the first executable is created.
+  Status SetTensorPipelineDepth(int depth);
+
   const shared_ptr<NGraphTensorManager>& GetTensorManager() {
     return m_tensor_manager;
   }
 
+  // True if the outputs can be computed in place in the TF output tensors,
+  // skipping the copy from the pipelined output tensors
+  bool IsZeroCopyOutputEnabled() const { return m_zero_copy_output; }
+
+  // Pads the input tensors up to their shape buckets, if shape bucketing is
+  // requested. output_bucketed_dims gets, for every output, the dimensions
+  // to slice back, or is left empty if the inputs were not padded (see
+  // NGraphShapeBucketing)
+  Status BucketInputTensors(std::vector<Tensor>& tf_input_tensors,
+                            std::vector<BucketedDims>& output_bucketed_dims);
+
  private:
   // This method is called from CreateCallback(), It compiles ngraph
   // Or load ng_executable from backend in case of AOT
@@ -113,7 +204,32 @@ class NGraphExecutor {
   Status ComputeSignature(const std::vector<Tensor>& tf_input_tensors,
                           std::vector<TensorShape>& input_shapes,
                           std::vector<const Tensor*>& static_input_map,
-                          std::stringstream& signature_ss) const;
+                          NGraphSignature& signature) const;
+
+  // Looks up the item for signature in m_ng_data_cache, creating it on a miss
+  Status LookUpOrCreateItem(
+      const NGraphSignature& signature,
+      const std::vector<TensorShape>& input_shapes,
+      const std::vector<const Tensor*>& static_input_map,
+      std::shared_ptr<ngraph::runtime::Executable>& ng_exec,
+      NGraphFunctionRef& ng_function_ref,
+      shared_ptr<PipelinedTensorsStore>& pts, bool& cache_hit);
+
+  // Compiles the executable for signature and inserts it into
+  // m_ng_data_cache. Runs on the compile thread pool.
+  void CompileInBackground(const NGraphSignature& signature,
+                           const std::vector<Tensor>& tf_input_tensors);
+
+  // Finds the dimensions of the outputs that carry the bucketed_dims of the
+  // padded inputs, by translating m_graph for them and for each of the
+  // dimensions one larger. Cached in m_bucketed_output_dims.
+  Status FindBucketedOutputDims(
+      const std::vector<Tensor>& padded_input_tensors,
+      const BucketedDims& bucketed_dims,
+      std::vector<BucketedDims>& output_bucketed_dims);
+
+  // Thread pool shared by all the executors for asynchronous compilation
+  static thread::ThreadPool* GetCompileThreadPool();
 
  private:
   const int m_instance_id;
@@ -124,22 +240,60 @@ class NGraphExecutor {
   const string m_op_backend_name;
   string m_node_name;
   std::vector<bool> m_input_is_static;
-  std::list<std::string> m_lru;
   bool m_do_aot = false;
   map<string, string> m_aot_functions;
   map<string, string> m_aot_execs;
+  // Hash of the encapsulated graph, used to key the executable disk cache
+  string m_graph_fingerprint;
+  NGraphShapeBucketing m_shape_bucketing;
+  // Values of the Const nodes of m_graph, shared by the functions of all the
+  // signatures
+  NGraphConstantPool m_constant_pool;
+  // Order and handlers of the ops of m_graph, shared by the translations of
+  // all the signatures
+  Builder::TranslationPlan m_translation_plan;
 
   // NgraphDataCache<Key, Value> where key is signature, and value is a tuple
-  // of ng_executable, serialized_ng_function and PipelinedTensorsStore
-  NgraphDataCache<std::string,
+  // of ng_executable, ng_function reference and PipelinedTensorsStore
+  NgraphDataCache<NGraphSignature,
                   std::tuple<std::shared_ptr<ngraph::runtime::Executable>,
-                             std::string, shared_ptr<PipelinedTensorsStore>>>
+                             NGraphFunctionRef,
+                             shared_ptr<PipelinedTensorsStore>>>
       m_ng_data_cache;
 
   bool m_executable_can_create_tensor;
+  bool m_zero_copy_output = false;
 
   mutex m_mutex;
-  int m_depth{2};  // TODO make this settable
+  // Executable memory and compile time of the items created by
+  // CreateCallback, till they are handed over to m_ng_data_cache
+  std::unordered_map<NGraphSignature, NGraphCacheItemCost> m_create_costs;
+  // Signature of padded inputs -> dimensions of the outputs to slice, guarded
+  // by m_mutex
+  std::unordered_map<NGraphSignature, std::vector<BucketedDims>>
+      m_bucketed_output_dims;
+  int m_depth{2};
+
+  // Asynchronous compilation state. The signatures being compiled and the
+  // ones that failed to compile are guarded by m_mutex. A failed signature
+  // keeps using the fallback till m_compile_retry_ms have passed, since it
+  // may have failed for a transient reason (e.g. out of memory). At most
+  // kMaxFailedSignatures failures are kept, the oldest are dropped first.
+  static const size_t kMaxFailedSignatures = 256;
+  bool m_async_compile = false;
+  int64 m_compile_retry_ms = 60000;
+  std::unordered_set<NGraphSignature> m_pending_signatures;
+  // Failed signature -> time of the failure, in microseconds
+  std::unordered_map<NGraphSignature, uint64> m_failed_signatures;
+  NGraphLRU<NGraphSignature> m_failed_lru;
+  int m_pending_compiles = 0;
+  condition_variable m_pending_compiles_cv;
+  std::atomic<int64> m_fallback_steps{0};
+  // For the startup report: whether a warm-up was requested, and whether the
+  // first step has got its executable
+  std::atomic<bool> m_warmup_requested{false};
+  std::atomic<bool> m_first_lookup_done{false};
+  static std::atomic<int64> s_compile_queue_depth;
 
   // NGraphTensorManager
   shared_ptr<NGraphTensorManager> m_tensor_manager;
@@ -55,7 +55,8 @@ Node* FindPrefetch(Node* makeiterator_node) {
   return prefetch_node;
 }
 
-Status ReplacePrefetch(Graph* graph, Node* prefetch_node) {
+Status ReplacePrefetch(Graph* graph, Node* prefetch_node,
+                       const string& iterator_name) {
   NodeBuilder::NodeOut input_dataset;
   NodeBuilder::NodeOut buffer_size;
 
@@ -86,6 +87,7 @@ Status ReplacePrefetch(Graph* graph, Node* prefetch_node) {
                          .Attr("output_types", output_types)
                          .Attr("output_shapes", output_shapes)
                          .Attr("slack_period", slack_period)
+                         .Attr("iterator", iterator_name)
                          .Device(prefetch_node->assigned_device_name())
                          .Finalize(graph, &replacement));
   replacement->set_assigned_device_name(prefetch_node->assigned_device_name());
@@ -133,6 +135,28 @@ Status ReplacePrefetch(Graph* graph, Node* prefetch_node) {
   return Status::OK();
 }
 
+Status ReplacePrefetches(Graph* graph,
+                         const std::vector<Node*>& make_iterator_nodes) {
+  for (auto make_iterator_node : make_iterator_nodes) {
+    // We expect the MakeIterator to have 1 input thats
+    // an iterator and the other one can be either a
+    // PrefetchDataset node or a ModelDataset node
+    // Other cases are not handled at the moment.
+    Node* prefetch_node = FindPrefetch(make_iterator_node);
+    if (prefetch_node == nullptr) {
+      return errors::Internal(
+          "Did not find PrefetchDataset or "
+          "ModelDataset+OptimizeDataset+PrefetchDataset as MakeIterator "
+          "nodes' inputs. Only those 2 cases are handled for now.");
+    }
+    const Edge* iterator_edge;
+    TF_RETURN_IF_ERROR(make_iterator_node->input_edge(1, &iterator_edge));
+    TF_RETURN_IF_ERROR(
+        ReplacePrefetch(graph, prefetch_node, iterator_edge->src()->name()));
+  }
+  return Status::OK();
+}
+
 }  // namespace ngraph_bridge
 
 }  // namespace tensorflow
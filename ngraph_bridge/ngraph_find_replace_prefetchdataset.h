@@ -32,7 +32,15 @@ namespace ngraph_bridge {
 
 Node* FindPrefetch(Node* makeiterator_node);
 
-Status ReplacePrefetch(Graph* graph, Node* prefetch_node);
+// Replaces prefetch_node with an NGraphPrefetchDataset that copies the
+// inputs of the encapsulates fed by iterator_name (the name of the iterator
+// node MakeIterator initializes) to their device tensors
+Status ReplacePrefetch(Graph* graph, Node* prefetch_node,
+                       const string& iterator_name);
+
+// Replaces the PrefetchDataset initializing each of the MakeIterator nodes
+Status ReplacePrefetches(Graph* graph,
+                         const std::vector<Node*>& make_iterator_nodes);
 
 }  // namespace ngraph_bridge
 
@@ -15,12 +15,15 @@
  *******************************************************************************/
 
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
 
 #include "ngraph/runtime/backend.hpp"
 #include "ngraph/runtime/backend_manager.hpp"
 #include "ngraph_bridge/ngraph_api.h"
 #include "ngraph_bridge/ngraph_backend_manager.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "ngraph_bridge/ngraph_timer.h"
 #include "ngraph_bridge/ngraph_utils.h"
 #include "ngraph_bridge/ngraph_version_utils.h"
 
@@ -75,10 +78,14 @@ static Status CheckIfOutputNode(const Node* node,
 
 // Checks if the node's inputs meet all the type constraints
 static Status TypeConstraintOk(Node* node,
-                               TypeConstraintMap& type_constraint_map,
+                               const TypeConstraintMap& type_constraint_map,
                                bool& type_constraints_ok) {
   type_constraints_ok = true;
-  for (auto& name_and_set : type_constraint_map[node->type_string()]) {
+  auto constraints = type_constraint_map.find(node->type_string());
+  if (constraints == type_constraint_map.end()) {
+    return Status::OK();
+  }
+  for (auto& name_and_set : constraints->second) {
     auto& type_attr_name = name_and_set.first;
     auto& allowed_types = name_and_set.second;
 
@@ -97,7 +104,8 @@ static Status TypeConstraintOk(Node* node,
 // Checks if the node meets the confirmation constraints
 static Status ConfirmationOk(
     Node* node,
-    std::map<std::string, ConfirmationFunction>& confirmation_function_map,
+    const std::map<std::string, ConfirmationFunction>&
+        confirmation_function_map,
     bool& confirmation_ok) {
   auto it = confirmation_function_map.find(node->type_string());
   if (it != confirmation_function_map.end()) {
@@ -163,11 +171,151 @@ Status IsSupportedByBackend(
   return Status::OK();
 }
 
+// Outcome of the checks of a node that do not involve the backend
+enum class NodeCheck {
+  kVariable,
+  kSkipped,
+  kNotSupported,
+  kFailedConfirmation,
+  kFailedTypeConstraint,
+  kPassed
+};
+
+// Runs the checks of node that do not involve the backend. They only read
+// the node and the maps, so they can run on several nodes at once.
+static Status CheckNode(
+    Node* node, const std::set<string>& skip_these_nodes,
+    const std::map<std::string, ConfirmationFunction>&
+        confirmation_function_map,
+    const TypeConstraintMap& type_constraint_map, NodeCheck& check) {
+  if (IsNGVariableType(node->type_string())) {
+    check = NodeCheck::kVariable;
+    return Status::OK();
+  }
+
+  // check if output node
+  bool skip_it = false;
+  TF_RETURN_IF_ERROR(CheckIfOutputNode(node, skip_these_nodes, skip_it));
+  if (skip_it) {
+    NGRAPH_VLOG(5) << "NGTF_OPTIMIZER: Found Output Node: " << node->name()
+                   << " - skip marking it for clustering";
+    check = NodeCheck::kSkipped;
+    return Status::OK();
+  }
+
+  // check placement
+  bool placement_ok = false;
+  TF_RETURN_IF_ERROR(NGraphPlacementRequested(node, placement_ok));
+  if (!placement_ok) {
+    NGRAPH_VLOG(5) << "Placement not requested: " << node->name();
+    check = NodeCheck::kSkipped;
+    return Status::OK();
+  }
+
+  // check node's confirmation constraints
+  bool confirmation_constraint_ok = false;
+  TF_RETURN_IF_ERROR(ConfirmationOk(node, confirmation_function_map,
+                                    confirmation_constraint_ok));
+  if (!confirmation_constraint_ok) {
+    NGRAPH_VLOG(5) << "Node does not meet confirmation constraints: "
+                   << node->name();
+    if (confirmation_function_map.find(node->type_string()) ==
+        confirmation_function_map.end()) {
+      // not found
+      check = NodeCheck::kNotSupported;
+    } else {
+      // found
+      check = NodeCheck::kFailedConfirmation;
+    }
+    return Status::OK();
+  }
+
+  // check input type constraints
+  bool type_constraint_ok = false;
+  TF_RETURN_IF_ERROR(
+      TypeConstraintOk(node, type_constraint_map, type_constraint_ok));
+  if (!type_constraint_ok) {
+    NGRAPH_VLOG(5) << "Inputs do not meet type constraints: " << node->name();
+    check = NodeCheck::kFailedTypeConstraint;
+    return Status::OK();
+  }
+
+  check = NodeCheck::kPassed;
+  return Status::OK();
+}
+
+// The backend support check only depends on the backend, the op type and the
+// types of the attributes the type constraints look at. Its outcome is
+// cached by these across nodes and calls of MarkForClustering, and the cache
+// is dropped when another backend is set.
+static mutex s_support_cache_mutex;
+static string s_support_cache_backend;
+static std::unordered_map<string, bool> s_support_cache;
+static int64 s_support_cache_hits = 0;
+static int64 s_support_cache_misses = 0;
+
+// Key of the cached checks of node: its op type and the types of its
+// constrained attributes
+static string BackendSupportKey(const Node* node,
+                                const TypeConstraintMap& type_constraint_map) {
+  string key = node->type_string();
+  auto constraints = type_constraint_map.find(node->type_string());
+  if (constraints == type_constraint_map.end()) {
+    return key;
+  }
+  for (auto& name_and_set : constraints->second) {
+    DataType dt;
+    if (GetNodeAttr(node->attrs(), name_and_set.first, &dt) == Status::OK()) {
+      strings::StrAppend(&key, ",", name_and_set.first, "=", dt);
+    } else {
+      strings::StrAppend(&key, ",", name_and_set.first, "=?");
+    }
+  }
+  return key;
+}
+
+static bool LookUpBackendSupport(const string& backend, const string& key,
+                                 bool& is_supported) {
+  mutex_lock l(s_support_cache_mutex);
+  if (s_support_cache_backend != backend) {
+    NGRAPH_VLOG(5) << "Backend changed to " << backend
+                   << ", dropping the cached support of "
+                   << s_support_cache.size() << " op types";
+    s_support_cache.clear();
+    s_support_cache_backend = backend;
+  }
+  auto itr = s_support_cache.find(key);
+  if (itr == s_support_cache.end()) {
+    s_support_cache_misses++;
+    return false;
+  }
+  s_support_cache_hits++;
+  is_supported = itr->second;
+  return true;
+}
+
+static void CacheBackendSupport(const string& backend, const string& key,
+                                bool is_supported) {
+  mutex_lock l(s_support_cache_mutex);
+  // Another backend may have been set meanwhile
+  if (s_support_cache_backend == backend) {
+    s_support_cache[key] = is_supported;
+  }
+}
+
+void GetBackendSupportCacheStats(int64& hits, int64& misses) {
+  mutex_lock l(s_support_cache_mutex);
+  hits = s_support_cache_hits;
+  misses = s_support_cache_misses;
+}
+
 //
 // Main entry point for the marking pass.
 //
 Status MarkForClustering(Graph* graph, const std::set<string> skip_these_nodes,
                          const string& current_backend) {
+  Timer marking_timer;
+
   //
   // A map of op types (e.g. "Add") to type constraint maps. For (fake)
   // example:
@@ -1089,83 +1237,80 @@ Status MarkForClustering(Graph* graph, const std::set<string> skip_these_nodes,
   vector<Node*> nodes_marked_for_clustering;
   vector<Node*> variable_type_nodes;
   string ng_backend_type;
-  // Create nGraph backend
   BackendManager::GetCurrentlySetBackendName(&ng_backend_type);
-  // Create backend to query is_supported
-  TF_RETURN_IF_ERROR(BackendManager::CreateBackend(ng_backend_type));
-  ng::runtime::Backend* op_backend =
-      BackendManager::GetBackend(ng_backend_type);
+  // The backend to query is_supported, only created if some check is not
+  // cached
+  ng::runtime::Backend* op_backend = nullptr;
+  int support_checks_cached = 0;
+  int support_checks_done = 0;
 
+  // The checks that do not involve the backend run on the nodes in parallel,
+  // their outcomes are then gathered in the order of the nodes.
+  std::vector<Node*> op_nodes;
   for (auto node : graph->op_nodes()) {
-    bool mark_for_clustering = false;
+    op_nodes.push_back(node);
+  }
+  std::vector<NodeCheck> node_checks(op_nodes.size());
+  TF_RETURN_IF_ERROR(ParallelForEach(
+      op_nodes.size(), /*cost_per_unit=*/10000,
+      [&op_nodes, &skip_these_nodes, &node_checks](int64 i) {
+        return CheckNode(op_nodes[i], skip_these_nodes,
+                         confirmation_function_map, type_constraint_map,
+                         node_checks[i]);
+      }));
 
-    if (IsNGVariableType(node->type_string())) {
-      variable_type_nodes.push_back(node);
-      continue;
-    }
+  for (size_t i = 0; i < op_nodes.size(); i++) {
+    Node* node = op_nodes[i];
+    bool mark_for_clustering = false;
 
-    do {
-      // check if output node
-      bool skip_it = false;
-      TF_RETURN_IF_ERROR(CheckIfOutputNode(node, skip_these_nodes, skip_it));
-      if (skip_it) {
-        NGRAPH_VLOG(5) << "NGTF_OPTIMIZER: Found Output Node: " << node->name()
-                       << " - skip marking it for clustering";
+    switch (node_checks[i]) {
+      case NodeCheck::kVariable:
+        variable_type_nodes.push_back(node);
+        continue;
+      case NodeCheck::kSkipped:
         break;
-      }
-
-      // check placement
-      bool placement_ok = false;
-      TF_RETURN_IF_ERROR(NGraphPlacementRequested(node, placement_ok));
-      if (!placement_ok) {
-        NGRAPH_VLOG(5) << "Placement not requested: " << node->name();
+      case NodeCheck::kNotSupported:
+        no_support_histogram[node->type_string()]++;
         break;
-      }
-
-      // check node's confirmation constraints
-      bool confirmation_constraint_ok = false;
-      TF_RETURN_IF_ERROR(ConfirmationOk(node, confirmation_function_map,
-                                        confirmation_constraint_ok));
-      if (!confirmation_constraint_ok) {
-        NGRAPH_VLOG(5) << "Node does not meet confirmation constraints: "
-                       << node->name();
-        if (confirmation_function_map.find(node->type_string()) ==
-            confirmation_function_map.end()) {
-          // not found
-          no_support_histogram[node->type_string()]++;
-        } else {
-          // found
-          fail_confirmation_histogram[node->type_string()]++;
-        }
+      case NodeCheck::kFailedConfirmation:
+        fail_confirmation_histogram[node->type_string()]++;
         break;
-      }
-
-      // check input type constraints
-      bool type_constraint_ok = false;
-      TF_RETURN_IF_ERROR(
-          TypeConstraintOk(node, type_constraint_map, type_constraint_ok));
-      if (!type_constraint_ok) {
-        NGRAPH_VLOG(5) << "Inputs do not meet type constraints: "
-                       << node->name();
+      case NodeCheck::kFailedTypeConstraint:
         fail_constraint_histogram[node->type_string()]++;
         break;
-      }
+      case NodeCheck::kPassed: {
+        // Check if op is supported by backend, unless already done for the
+        // same op type and types
+        string support_key = BackendSupportKey(node, type_constraint_map);
+        bool is_supported = false;
+        if (LookUpBackendSupport(ng_backend_type, support_key,
+                                 is_supported)) {
+          support_checks_cached++;
+        } else {
+          support_checks_done++;
+          if (op_backend == nullptr) {
+            // Create backend to query is_supported
+            TF_RETURN_IF_ERROR(BackendManager::CreateBackend(ng_backend_type));
+            op_backend = BackendManager::GetBackend(ng_backend_type);
+          }
+          TF_RETURN_IF_ERROR(IsSupportedByBackend(
+              node, op_backend, TFtoNgraphOpMap, is_supported));
+          CacheBackendSupport(ng_backend_type, support_key, is_supported);
+        }
 
-      // Check if op is supported by backend
-      bool is_supported = false;
-      TF_RETURN_IF_ERROR(IsSupportedByBackend(node, op_backend, TFtoNgraphOpMap,
-                                              is_supported));
+        if (!is_supported) {
+          NGRAPH_VLOG(5) << "TF Op " << node->name() << " of type "
+                         << node->type_string()
+                         << " is not supported by backend: "
+                         << ng_backend_type;
+          break;
+        }
 
-      if (!is_supported) {
-        NGRAPH_VLOG(5) << "TF Op " << node->name() << " of type "
-                       << node->type_string()
-                       << " is not supported by backend: " << ng_backend_type;
+        // if all constraints are met, mark for clustering
+        mark_for_clustering = true;
         break;
       }
-
-      // if all constraints are met, mark for clustering
-      mark_for_clustering = true;
-    } while (false);
+    }
 
     // Set the _ngraph_marked_for_clustering attribute if all constraints
     // are satisfied
@@ -1180,10 +1325,22 @@ Status MarkForClustering(Graph* graph, const std::set<string> skip_these_nodes,
   }
 
   // Release backend created to query is_supported
-  BackendManager::ReleaseBackend(ng_backend_type);
+  if (op_backend != nullptr) {
+    BackendManager::ReleaseBackend(ng_backend_type);
+  }
+
+  int marking_us = marking_timer.ElapsedInMicroSec();
+  NGRAPH_VLOG(1) << "NGTF_OPTIMIZER: Marked "
+                 << nodes_marked_for_clustering.size() << " nodes in "
+                 << marking_us << " us, backend support checks: "
+                 << support_checks_cached << " cached, " << support_checks_done
+                 << " done";
 
   if (config::IsLoggingPlacement()) {
     std::cout << "\n=============New sub-graph logs=============\n";
+    std::cout << "NGTF_SUMMARY: Marking time: " << marking_us
+              << " us, backend support checks: " << support_checks_cached
+              << " cached, " << support_checks_done << " done\n";
     // print summary for nodes failed to be marked
     std::cout << "NGTF_SUMMARY: Op_not_supported: ";
     print_node_histogram(no_support_histogram);
@@ -33,6 +33,9 @@ Status IsSupportedByBackend(
     std::map<std::string, std::set<std::shared_ptr<ngraph::Node>>>&
         TFtoNgraphOpMap,
     bool& is_supported);
+// Number of nodes whose type constraint and backend support checks
+// MarkForClustering took from its cache (hits) or had to do (misses)
+void GetBackendSupportCacheStats(int64& hits, int64& misses);
 bool NodeIsMarkedForClustering(const Node* node);
 void GetStaticInputs(const Node* node, std::vector<int32>* inputs);
 bool InputIsStatic(const Node* node, int index);
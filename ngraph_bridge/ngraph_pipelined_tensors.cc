@@ -14,6 +14,8 @@
  * limitations under the License.
  *******************************************************************************/
 
+#include <chrono>
+
 #include "ngraph_bridge/ngraph_pipelined_tensors.h"
 
 using namespace std;
@@ -23,9 +25,21 @@ namespace tensorflow {
 
 namespace ngraph_bridge {
 
+const size_t IndexLibrary::kMaxDepth;
+const size_t IndexLibrary::kNumWaitBuckets;
+const int IndexLibrary::kTimedOut;
+const int IndexLibrary::kCancelled;
+
 IndexLibrary::IndexLibrary(size_t depth) : m_depth(depth) {
-  for (size_t i = 0; i < depth; i++) {
-    m_free_depth_indexes.insert(i);
+  if (depth > kMaxDepth) {
+    throw std::runtime_error("Depth = " + to_string(depth) +
+                             " but IndexLibrary supports a depth of at most " +
+                             to_string(kMaxDepth));
+  }
+  m_free_depth_indexes = depth == kMaxDepth ? ~uint64_t{0}
+                                            : (uint64_t{1} << depth) - 1;
+  for (auto& count : m_wait_histogram) {
+    count = 0;
   }
 }
 
@@ -39,54 +53,138 @@ void IndexLibrary::return_index(size_t id) {
                              " but passed an index to return ( = " +
                              to_string(id) + "), which is too large");
   }
-  if (is_free(id)) {
+  uint64_t bit = uint64_t{1} << id;
+  if (m_free_depth_indexes.fetch_or(bit) & bit) {
     throw std::runtime_error(
         "Attempted to return index " + to_string(id) +
         " but it is already present in the free indices set");
   }
 
-  insert_to_free_set(id);
+  // A waiter registers itself before it looks at the free indices, so either
+  // it sees this index or it is counted here
+  if (m_num_waiters > 0) {
+    std::lock_guard<std::mutex> lock(m_wait_mtx);
+    m_wait_cv.notify_all();
+  }
 }
 
 int IndexLibrary::get_index() {
+  uint64_t free_indexes = m_free_depth_indexes;
+  while (free_indexes != 0) {
+    // Take the smallest free integer
+    int min_idx = __builtin_ctzll(free_indexes);
+    if (m_free_depth_indexes.compare_exchange_weak(
+            free_indexes, free_indexes & ~(uint64_t{1} << min_idx))) {
+      return min_idx;
+    }
+  }
+  return -1;
+}
+
+int IndexLibrary::get_index(int64 timeout_ms,
+                            CancellationManager* cancellation_manager) {
+  // Fast path, if nobody is queued ahead of us
+  int idx;
+  if (m_num_waiters == 0 && (idx = get_index()) >= 0) {
+    record_wait(0);
+    return idx;
+  }
   if (m_depth == 0) {
     return -1;
-  } else {
-    std::lock_guard<std::mutex> lock(m_mtx);
-    if (m_free_depth_indexes.size() == 0) {
-      return -1;
-    } else {
-      // Find and return the smallest free integer
-      int min_idx = m_depth;  // nothing can be >= m_depth
-      for (auto i : m_free_depth_indexes) {
-        if (i < min_idx) {
-          min_idx = i;
-        }
-      }
-      if (min_idx >= m_depth || min_idx < 0) {
-        throw std::runtime_error(
-            "get_index can only return values between 0 to depth-1 from here, "
-            "but attempted to return " +
-            to_string(min_idx));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + std::chrono::milliseconds(timeout_ms);
+  std::unique_lock<std::mutex> lock(m_wait_mtx);
+  int64 me = m_next_waiter++;
+  m_waiters.push_back(me);
+  m_num_waiters++;
+
+  // The manager reports IsCancelled() only once all the callbacks have run,
+  // so the callback sets a flag for this waiter to see when it wakes up.
+  // The callback is deregistered before returning, which waits for it if it
+  // is running.
+  CancellationToken token;
+  bool cancelled = false;
+  bool registered = false;
+  if (cancellation_manager != nullptr) {
+    token = cancellation_manager->get_cancellation_token();
+    registered =
+        cancellation_manager->RegisterCallback(token, [this, &cancelled]() {
+          std::lock_guard<std::mutex> lock(m_wait_mtx);
+          cancelled = true;
+          m_wait_cv.notify_all();
+        });
+    cancelled = !registered;
+  }
+
+  idx = -1;
+  while (!cancelled) {
+    if (m_waiters.front() == me && (idx = get_index()) >= 0) {
+      break;
+    }
+    if (timeout_ms < 0) {
+      m_wait_cv.wait(lock);
+    } else if (m_wait_cv.wait_until(lock, deadline) ==
+               std::cv_status::timeout) {
+      if (m_waiters.front() == me) {
+        idx = get_index();
       }
-      m_free_depth_indexes.erase(min_idx);
-      return min_idx;
+      break;
     }
   }
+  if (idx < 0 && cancelled) {
+    idx = kCancelled;
+  }
+
+  m_waiters.remove(me);
+  m_num_waiters--;
+  // The next waiter may be at the front now
+  m_wait_cv.notify_all();
+  lock.unlock();
+  if (registered) {
+    cancellation_manager->DeregisterCallback(token);
+  }
+
+  if (idx >= 0) {
+    record_wait(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count());
+  }
+  return idx;
 }
 
-void IndexLibrary::insert_to_free_set(size_t id) {
-  std::lock_guard<std::mutex> lock(m_mtx);
-  m_free_depth_indexes.insert(id);
+void IndexLibrary::record_wait(int64 wait_us) {
+  size_t bucket = 0;
+  while (wait_us > 0 && bucket < kNumWaitBuckets - 1) {
+    wait_us >>= 1;
+    bucket++;
+  }
+  m_wait_histogram[bucket]++;
 }
 
-bool IndexLibrary::is_free(size_t id) {
-  std::lock_guard<std::mutex> lock(m_mtx);
-  if (id > m_depth - 1) {
-    throw std::runtime_error("Asked to check if id=" + to_string(id) +
-                             " is free, but depth=" + to_string(m_depth));
+std::vector<int64> IndexLibrary::get_wait_histogram() const {
+  std::vector<int64> histogram;
+  for (const auto& count : m_wait_histogram) {
+    histogram.push_back(count);
   }
-  return m_free_depth_indexes.find(id) != m_free_depth_indexes.end();
+  return histogram;
+}
+
+string IndexLibrary::get_wait_histogram_string() const {
+  string histogram;
+  for (size_t bucket = 0; bucket < kNumWaitBuckets; bucket++) {
+    int64 count = m_wait_histogram[bucket];
+    if (count == 0) {
+      continue;
+    }
+    string upper_bound = bucket == kNumWaitBuckets - 1
+                             ? "inf"
+                             : to_string(int64{1} << bucket);
+    histogram += (histogram.empty() ? "" : " ") + upper_bound + ":" +
+                 to_string(count);
+  }
+  return histogram;
 }
 
 PipelinedTensorsStore::PipelinedTensorsStore(PipelinedTensorMatrix in,
@@ -114,10 +212,32 @@ PipelinedTensorsStore::get_tensors() {
                     (i < 0 ? PipelinedTensorVector{} : get_group(false, i)));
 }
 
+tuple<int, PipelinedTensorVector, PipelinedTensorVector>
+PipelinedTensorsStore::get_tensors(int64 timeout_ms,
+                                   CancellationManager* cancellation_manager) {
+  int i = idx_lib->get_index(timeout_ms, cancellation_manager);
+  return make_tuple(i, (i < 0 ? PipelinedTensorVector{} : get_group(true, i)),
+                    (i < 0 ? PipelinedTensorVector{} : get_group(false, i)));
+}
+
 void PipelinedTensorsStore::return_tensors(size_t id) {
   idx_lib->return_index(id);
 }
 
+size_t PipelinedTensorsStore::get_size_in_bytes() const {
+  size_t size_in_bytes = 0;
+  for (const auto& tensor_matrix : {m_in_tensors, m_out_tensors}) {
+    for (const auto& tensor_group : tensor_matrix) {
+      for (const auto& tensor : tensor_group) {
+        if (tensor != nullptr) {
+          size_in_bytes += tensor->get_size_in_bytes();
+        }
+      }
+    }
+  }
+  return size_in_bytes;
+}
+
 PipelinedTensorVector PipelinedTensorsStore::get_group(bool is_input,
                                                        size_t i) {
   if (is_input) {
@@ -18,6 +18,14 @@
 #define NGRAPH_TF_BRIDGE_PIPELINED_TENSORS_H_
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+
+#include "tensorflow/core/framework/cancellation.h"
+
 #include "ngraph/event_tracing.hpp"
 #include "ngraph/runtime/backend.hpp"
 
@@ -26,7 +34,8 @@
 // of the pipeline for output j.
 
 // Simplifying assumptions about pipeline depths: for all 0 <= i < a, 0 <= j <
-// b, d_input[i] ==  d_output[i] == d. Most likely, d = 2
+// b, d_input[i] ==  d_output[i] == d. d is 2 by default, see
+// NGraphExecutor::SetTensorPipelineDepth
 
 // Pipelined tensors Matrix: When the executable is used to create tensors, it
 // will
@@ -64,10 +73,11 @@
 // IndexLibrary manages a set of integers: 0,1,...depth-1
 // It supports 2 functions get_index and return_index
 // get_index returns the smallest int from the set of free indices
-// (it returns -1 if none are available)
+// (it returns -1 if none are available, or waits for one to be returned)
 // return_index accepts back a number that was checkedout earlier
 // IndexLibrary can be used safely in a multithreaded scenario since
-// the underlying store of free indices is locked by a mutex
+// the free indices are kept in an atomic bitmask. Only the callers that wait
+// for an index take a lock.
 
 using namespace std;
 namespace ng = ngraph;
@@ -85,6 +95,16 @@ typedef vector<PipelinedTensorVector> PipelinedTensorMatrix;
 // See sample usage in test/test_index_library.cpp
 class IndexLibrary {
  public:
+  // The free indices are bits of a 64 bit mask
+  static const size_t kMaxDepth = 64;
+  // Wait times are counted in buckets of powers of 2 microseconds: bucket 0
+  // counts the calls that did not wait, bucket b > 0 the waits in
+  // [2^(b-1), 2^b) us, and the last bucket all the longer ones
+  static const size_t kNumWaitBuckets = 24;
+  // What the blocking get_index returns when it gets no integer
+  static const int kTimedOut = -1;
+  static const int kCancelled = -2;
+
   IndexLibrary(size_t depth);
 
   // If available return the smallest free integer (0<=i<depth-1)
@@ -92,10 +112,21 @@ class IndexLibrary {
   // An integer once checked out will never be returned by get_index again,
   // till it is returned using return_index
   int get_index();
+  // Same as above, but if nothing is free waits for an integer to be
+  // returned, for up to timeout_ms (forever if negative). The callers that
+  // wait are served in the order they arrive. Returns kTimedOut on timeout,
+  // or kCancelled if cancellation_manager (when not null) is cancelled.
+  int get_index(int64 timeout_ms, CancellationManager* cancellation_manager);
   // the user returns a checked out (using get_index) integer,
   // so its available again for reuse when get_index is called again
   void return_index(size_t id);
 
+  // Counts of the waits of the blocking get_index, see kNumWaitBuckets
+  std::vector<int64> get_wait_histogram() const;
+  // The histogram as "<upper bound in us>:<count>" pairs of the non empty
+  // buckets
+  string get_wait_histogram_string() const;
+
   // TODO: if needed implement get_depth() and get_num_free_idxs()
   // Implementing get_depth() might make some sense because if one receives an
   // IndexLibrary object that only gives return_index()==-1 then one might want
@@ -104,14 +135,21 @@ class IndexLibrary {
   // throw an error or take appropriate steps if its 0
 
  private:
-  set<int> m_free_depth_indexes;
+  // Bit i is set if integer i is free
+  std::atomic<uint64_t> m_free_depth_indexes;
   size_t m_depth;
-  std::mutex m_mtx;  // protects m_free_depth_indexes
 
-  // insert id in m_free_depth_indexes
-  void insert_to_free_set(size_t id);
-  // check if id already exists in m_free_depth_indexes
-  bool is_free(size_t id);
+  // Callers waiting in the blocking get_index, in order of arrival. Only the
+  // one at the front takes a free integer.
+  std::mutex m_wait_mtx;  // protects m_waiters
+  std::condition_variable m_wait_cv;
+  std::list<int64> m_waiters;
+  int64 m_next_waiter{0};
+  std::atomic<int> m_num_waiters{0};
+
+  std::array<std::atomic<int64>, kNumWaitBuckets> m_wait_histogram;
+
+  void record_wait(int64 wait_us);
 };
 
 class PipelinedTensorsStore {
@@ -122,12 +160,23 @@ class PipelinedTensorsStore {
   // groups). If the idx is negative, then its an invalid group (because
   // pipeline is filled right now)
   tuple<int, PipelinedTensorVector, PipelinedTensorVector> get_tensors();
+  // Waits for a free group, see IndexLibrary::get_index. The index is
+  // IndexLibrary::kTimedOut or kCancelled if there is none
+  tuple<int, PipelinedTensorVector, PipelinedTensorVector> get_tensors(
+      int64 timeout_ms, CancellationManager* cancellation_manager);
 
   // Return an integer that was checked out by get_tensors.
   // This indicates that the tensors corresponding to depth=id in the pipeline
   // are ready for reuse and can be returned when get_tensors is called again
   void return_tensors(size_t id);
 
+  // Total size of the input and output tensors of all the pipeline depths
+  size_t get_size_in_bytes() const;
+
+  size_t get_depth() const { return m_depth; }
+
+  const shared_ptr<IndexLibrary>& get_index_library() const { return idx_lib; }
+
  private:
   PipelinedTensorMatrix m_in_tensors;
   PipelinedTensorMatrix m_out_tensors;
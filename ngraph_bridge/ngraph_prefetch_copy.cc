@@ -0,0 +1,195 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+
+#include "ngraph/runtime/host_tensor.hpp"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_prefetch_copy.h"
+
+using namespace std;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+static thread::ThreadPool* GetCopyThreadPool() {
+  static thread::ThreadPool* copy_thread_pool = []() {
+    int num_threads = 4;
+    const char* num_threads_specified =
+        std::getenv("NGRAPH_TF_PREFETCH_COPY_THREADS");
+    if (num_threads_specified != nullptr) {
+      num_threads = std::max(1, atoi(num_threads_specified));
+    }
+    NGRAPH_VLOG(1) << "Prefetch copy threads: " << num_threads;
+    return new thread::ThreadPool(Env::Default(), "ngraph_prefetch_copy",
+                                  num_threads);
+  }();
+  return copy_thread_pool;
+}
+
+size_t NGraphPrefetchCopier::GetChunkBytes() {
+  static const size_t chunk_bytes = [] {
+    int64 chunk_kb = 1024;
+    const char* chunk_kb_specified =
+        std::getenv("NGRAPH_TF_PREFETCH_COPY_CHUNK_KB");
+    if (chunk_kb_specified != nullptr) {
+      chunk_kb = std::max(1, atoi(chunk_kb_specified));
+    }
+    return static_cast<size_t>(chunk_kb) * 1024;
+  }();
+  return chunk_bytes;
+}
+
+namespace {
+
+// A part of a copy run by one task. host_tensor is set if the part is a
+// chunk copied straight into the buffer of a host tensor.
+struct CopyTask {
+  int copy_index;
+  size_t offset;
+  size_t bytes;
+  ng::runtime::HostTensor* host_tensor;
+};
+
+// State shared by the tasks of a CopyAsync call
+struct CopyState {
+  CopyState(std::vector<NGraphPrefetchCopy>* copies,
+            std::function<void(Status)> done, int64 num_tasks)
+      : copies(copies),
+        done(std::move(done)),
+        chunks_left(copies->size()),
+        tasks_left(num_tasks),
+        start_us(Env::Default()->NowMicros()) {}
+
+  std::vector<NGraphPrefetchCopy>* copies;
+  std::function<void(Status)> done;
+  // Per copy
+  std::vector<std::atomic<int>> chunks_left;
+  std::atomic<int64> tasks_left;
+  const int64 start_us;
+  mutex mu;
+  Status status GUARDED_BY(mu);
+};
+
+}  // namespace
+
+static Status RunCopyTask(const NGraphPrefetchCopy& copy,
+                          const CopyTask& task) {
+  const char* src = static_cast<const char*>(copy.src) + task.offset;
+  if (task.host_tensor != nullptr) {
+    char* dst = static_cast<char*>(task.host_tensor->get_data_ptr());
+    std::memcpy(dst + task.offset, src, task.bytes);
+    return Status::OK();
+  }
+  try {
+    copy.dst->write(src, task.bytes);
+  } catch (const std::exception& exp) {
+    return errors::Internal("Error copying TF tensor to device tensor: ",
+                            exp.what());
+  } catch (...) {
+    return errors::Internal("Error copying TF tensor to device tensor");
+  }
+  return Status::OK();
+}
+
+void NGraphPrefetchCopier::CopyAsync(std::vector<NGraphPrefetchCopy>* copies,
+                                     std::function<void(Status)> done) {
+  thread::ThreadPool* pool = GetCopyThreadPool();
+  const size_t chunk_bytes = GetChunkBytes();
+
+  std::vector<CopyTask> tasks;
+  std::vector<int> num_chunks(copies->size(), 1);
+  for (size_t i = 0; i < copies->size(); i++) {
+    const NGraphPrefetchCopy& copy = (*copies)[i];
+    if (copy.bytes != copy.dst->get_size_in_bytes()) {
+      done(errors::InvalidArgument(
+          "Prefetched input of ", copy.bytes,
+          " bytes does not match its device tensor of ",
+          copy.dst->get_size_in_bytes(), " bytes"));
+      return;
+    }
+    auto host_tensor =
+        std::dynamic_pointer_cast<ng::runtime::HostTensor>(copy.dst);
+    if (host_tensor == nullptr || pool->NumThreads() <= 1 ||
+        copy.bytes < 2 * chunk_bytes) {
+      tasks.push_back({static_cast<int>(i), 0, copy.bytes, nullptr});
+      continue;
+    }
+    num_chunks[i] = 0;
+    for (size_t offset = 0; offset < copy.bytes; offset += chunk_bytes) {
+      tasks.push_back({static_cast<int>(i), offset,
+                       std::min(chunk_bytes, copy.bytes - offset),
+                       host_tensor.get()});
+      num_chunks[i]++;
+    }
+  }
+  if (tasks.empty()) {
+    done(Status::OK());
+    return;
+  }
+
+  auto state = std::make_shared<CopyState>(copies, std::move(done),
+                                           static_cast<int64>(tasks.size()));
+  for (size_t i = 0; i < copies->size(); i++) {
+    state->chunks_left[i] = num_chunks[i];
+  }
+  for (const CopyTask& task : tasks) {
+    pool->Schedule([state, task]() {
+      NGraphPrefetchCopy& copy = (*state->copies)[task.copy_index];
+      Status status = RunCopyTask(copy, task);
+      if (!status.ok()) {
+        mutex_lock l(state->mu);
+        state->status.Update(status);
+      }
+      if (--state->chunks_left[task.copy_index] == 0) {
+        copy.elapsed_us = Env::Default()->NowMicros() - state->start_us;
+      }
+      if (--state->tasks_left == 0) {
+        Status final_status;
+        {
+          mutex_lock l(state->mu);
+          final_status = state->status;
+        }
+        state->done(final_status);
+      }
+    });
+  }
+}
+
+Status NGraphPrefetchCopier::Copy(std::vector<NGraphPrefetchCopy>* copies) {
+  BlockingCounter counter(1);
+  Status status;
+  CopyAsync(copies, [&counter, &status](Status s) {
+    status = s;
+    counter.DecrementCount();
+  });
+  counter.Wait();
+  return status;
+}
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
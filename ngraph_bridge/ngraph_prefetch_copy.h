@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#ifndef NGRAPH_TF_PREFETCH_COPY_H_
+#define NGRAPH_TF_PREFETCH_COPY_H_
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+
+#include "ngraph/runtime/tensor.hpp"
+
+namespace ng = ngraph;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+// A copy of a prefetched input into its nGraph tensor
+struct NGraphPrefetchCopy {
+  const void* src = nullptr;
+  // Size of src, which must be the size of dst
+  size_t bytes = 0;
+  std::shared_ptr<ng::runtime::Tensor> dst;
+  // Set once the copy is complete: the time from the start of the copies to
+  // the end of this one
+  int64 elapsed_us = 0;
+};
+
+//
+// NGraphPrefetchCopier writes the inputs of a prefetched element into their
+// nGraph tensors on a small thread pool (NGRAPH_TF_PREFETCH_COPY_THREADS,
+// default 4), so that the inputs are copied concurrently. Host tensors (the
+// tensors of the backends that keep them in host memory, like INTERPRETER)
+// of at least NGRAPH_TF_PREFETCH_COPY_CHUNK_KB (default 1024) are also split
+// into chunks copied in parallel. The tensors of the other backends can
+// only be written whole by their write().
+//
+class NGraphPrefetchCopier {
+ public:
+  // Starts the copies and returns. done is called with the first error, or
+  // OK, once all of them are complete. copies must outlive the call of done.
+  static void CopyAsync(std::vector<NGraphPrefetchCopy>* copies,
+                        std::function<void(Status)> done);
+  // Copies and waits for the copies to complete
+  static Status Copy(std::vector<NGraphPrefetchCopy>* copies);
+
+  // Host tensors of at least this size are split into chunks of this size
+  static size_t GetChunkBytes();
+};
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_PREFETCH_COPY_H_
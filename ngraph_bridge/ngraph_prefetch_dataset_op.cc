@@ -39,6 +39,8 @@ File: tensorflow/core/kernels/data/prefetch_dataset_op.cc
 
 #include "ngraph_bridge/ngraph_prefetch_dataset_op.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <deque>
 
 #include "tensorflow/core/common_runtime/metrics.h"
@@ -52,6 +54,8 @@ File: tensorflow/core/kernels/data/prefetch_dataset_op.cc
 
 #include "ngraph/event_tracing.hpp"
 
+#include "ngraph_bridge/ngraph_catalog.h"
+#include "ngraph_bridge/ngraph_prefetch_copy.h"
 #include "ngraph_bridge/ngraph_prefetch_shared_data.h"
 #include "ngraph_bridge/ngraph_utils.h"
 #include "ngraph_bridge/stats_utils.h"
@@ -66,14 +70,30 @@ namespace data {
 constexpr double kSleepFactor = 0.2;
 constexpr char kDatasetName[] = "NGraphPrefetch";
 
+// Bytes an autotuned pipeline may hold, the device slots of the encaps and
+// the host tensors of the buffer, 0 for no bound
+static int64 GetMemoryBudgetBytes() {
+  static const int64 budget_bytes = [] {
+    int64 budget_mb = 0;
+    const char* budget_mb_specified =
+        std::getenv("NGRAPH_TF_PREFETCH_MEMORY_BUDGET_MB");
+    if (budget_mb_specified != nullptr) {
+      budget_mb = std::max(0, atoi(budget_mb_specified));
+    }
+    return budget_mb * 1024 * 1024;
+  }();
+  return budget_bytes;
+}
+
 class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
  public:
   Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
-          int64 slack_period)
+          int64 slack_period, const string& iterator)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         buffer_size_(buffer_size),
-        slack_period_(slack_period) {
+        slack_period_(slack_period),
+        iterator_(iterator) {
     input_->Ref();
     m_resource_mgr = ctx->resource_manager();
   }
@@ -111,9 +131,13 @@ class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(buffer_size_, &buffer_size));
     AttrValue slack_period_attr;
     b->BuildAttrValue(slack_period_, &slack_period_attr);
-    TF_RETURN_IF_ERROR(b->AddDataset(
-        this, {input_graph_node, buffer_size},
-        {std::make_pair("slack_period", slack_period_attr)}, output));
+    AttrValue iterator_attr;
+    b->BuildAttrValue(iterator_, &iterator_attr);
+    TF_RETURN_IF_ERROR(
+        b->AddDataset(this, {input_graph_node, buffer_size},
+                      {std::make_pair("slack_period", slack_period_attr),
+                       std::make_pair("iterator", iterator_attr)},
+                      output));
     return Status::OK();
   }
 
@@ -122,7 +146,7 @@ class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
    public:
     explicit Iterator(const Params& params, ResourceMgr* rm)
         : DatasetIterator<Dataset>(params),
-          auto_tuner_(params.dataset->buffer_size_),
+          auto_tuner_(params.dataset->buffer_size_, GetMemoryBudgetBytes()),
           m_resource_mgr(rm),
           m_buffer_size(params.dataset->buffer_size_) {
       slack_us_ = 0;
@@ -170,7 +194,10 @@ class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
                auto_tuner_.buffer_limit() != 0) {
           auto_tuner_.RecordEmpty();
           RecordStop(ctx);
+          int64 wait_start_us = ctx->env()->NowMicros();
           cond_var_.wait(l);
+          auto_tuner_.RecordConsumerWait(ctx->env()->NowMicros() -
+                                         wait_start_us);
           RecordStart(ctx);
         }
 
@@ -214,9 +241,11 @@ class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
 
     Status SaveInternal(IteratorStateWriter* writer) override {
       // Acquire both locks to ensure that the prefetch thread and
-      // all GetNext threads are blocked.
+      // all GetNext threads are blocked, once the elements already read are
+      // in the buffer.
       mutex_lock parent_l(parent_mu_);
       mutex_lock l(mu_);
+      WaitForElementsInFlight(l);
       TF_RETURN_IF_ERROR(SaveInput(writer, input_impl_));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(full_name("buffer_size"), buffer_.size()));
@@ -241,6 +270,7 @@ class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
                            IteratorStateReader* reader) override {
       mutex_lock parent_l(parent_mu_);
       mutex_lock l(mu_);
+      WaitForElementsInFlight(l);
       buffer_.clear();
       TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
       size_t buffer_size;
@@ -301,6 +331,21 @@ class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
         stats_aggregator->AddScalar(
             stats_utils::BufferCapacityScalarName(dataset()->node_name()),
             static_cast<float>(auto_tuner_.buffer_limit()), num_elements());
+        stats_aggregator->AddScalar(
+            stats_utils::ConsumerWaitTimeScalarName(dataset()->node_name()),
+            static_cast<float>(auto_tuner_.window_consumer_wait_us()),
+            num_elements());
+        stats_aggregator->AddScalar(
+            stats_utils::ProducerIdleTimeScalarName(dataset()->node_name()),
+            static_cast<float>(auto_tuner_.window_producer_idle_us()),
+            num_elements());
+        stats_aggregator->AddScalar(
+            stats_utils::ElementBytesScalarName(dataset()->node_name()),
+            static_cast<float>(auto_tuner_.element_bytes()), num_elements());
+        stats_aggregator->AddScalar(
+            stats_utils::AutotuneDecisionScalarName(dataset()->node_name()),
+            static_cast<float>(static_cast<int>(auto_tuner_.last_decision())),
+            num_elements());
       }
       // A new element is available. Forward the status from computing it, and
       // (if we successfully got an element) the output values.
@@ -327,7 +372,16 @@ class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
         }
         RecordBufferDequeue(ctx, *out_tensors);
       }
+      int64 buffer_limit = auto_tuner_.buffer_limit();
       auto_tuner_.RecordConsumption(buffer_.size());
+      if (auto_tuner_.buffer_limit() != buffer_limit) {
+        NGRAPH_VLOG(1) << "[PREFETCH] " << dataset()->node_name()
+                       << " buffer limit " << buffer_limit << " -> "
+                       << auto_tuner_.buffer_limit() << " ("
+                       << PrefetchAutotuner::DecisionName(
+                              auto_tuner_.last_decision())
+                       << ")";
+      }
       buffer_.pop_front();
       *end_of_sequence = false;
 
@@ -355,6 +409,201 @@ class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
       return Status::OK();
     }
 
+    // Waits until no element is being copied to the device
+    void WaitForCopy(mutex_lock& l) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      while (copy_in_flight_) {
+        cond_var_.wait(l);
+      }
+    }
+
+    // Waits until the elements read from the input are in the buffer
+    void WaitForElementsInFlight(mutex_lock& l) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      while (elements_in_flight_ > 0) {
+        cond_var_.wait(l);
+      }
+    }
+
+    // Adds an element read from the input to the buffer
+    void AddToBuffer(IteratorContext* ctx, BufferElement buffer_element)
+        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      // The device copies are in the pipeline slots, not in the buffer
+      int64 element_bytes = 0;
+      for (const auto& tensor : buffer_element.value) {
+        element_bytes += tensor.TotalBytes();
+      }
+      auto_tuner_.RecordElementBytes(element_bytes);
+      RecordBufferEnqueue(ctx, buffer_element.value);
+      buffer_element.created_us = ctx->env()->NowMicros();
+      buffer_.push_back(std::move(buffer_element));
+      elements_in_flight_--;
+      cond_var_.notify_all();
+    }
+
+    // The shared data of the encapsulates fed by the iterator this dataset
+    // is made for, for the encapsulates that have created it. Only the
+    // encapsulates of the graph the iterator prefetches for are fed, the
+    // copies wait for each of them to take an element.
+    std::vector<ngraph_bridge::NGraphPrefetchSharedResouce*>
+    LookUpSharedData() {
+      std::vector<ngraph_bridge::NGraphPrefetchSharedResouce*> shared_data;
+      if (dataset()->iterator_.empty()) {
+        return shared_data;
+      }
+      int graph_id = ngraph_bridge::NGraphCatalog::GetPrefetchIteratorGraph(
+          dataset()->iterator_);
+      if (graph_id < 0) {
+        return shared_data;
+      }
+      for (int cluster_id :
+           ngraph_bridge::NGraphCatalog::GetEncapsFedByIterator(
+               graph_id, dataset()->iterator_)) {
+        ngraph_bridge::NGraphPrefetchSharedResouce* encap_shared_data =
+            nullptr;
+        Status s = m_resource_mgr->Lookup(
+            ngraph_bridge::NGraphPrefetchSharedResouce::CONTAINER_NAME,
+            ngraph_bridge::NGraphPrefetchSharedResouce::ResourceName(
+                graph_id, cluster_id, dataset()->iterator_),
+            &encap_shared_data);
+        if (s.ok()) {
+          shared_data.push_back(encap_shared_data);
+        }
+      }
+      return shared_data;
+    }
+
+    // Copies the prefetched inputs of buffer_element into the next nGraph
+    // tensors of each of the encapsulates of shared_data on the copy threads,
+    // then adds the element to the buffer and hands the tensors to the
+    // encapsulates. Returns once the copy has started. The copy of the
+    // previous element completes first, so the elements and the tensors stay
+    // in order. Takes over the references to shared_data. An element without
+    // an input an encapsulate prefetches is added to the buffer with an
+    // error, and nothing is copied.
+    void StartDeviceCopy(
+        const std::shared_ptr<IteratorContext>& ctx,
+        const std::vector<ngraph_bridge::NGraphPrefetchSharedResouce*>&
+            shared_data,
+        BufferElement buffer_element) {
+      // Check the element before taking tensors from the encapsulates
+      int number_of_buffer_elements = buffer_element.value.size();
+      for (auto encap_shared_data : shared_data) {
+        for (auto itr : encap_shared_data->GetPrefetchInputIndexesMap()) {
+          int tf_index = itr.second;
+          if (tf_index < number_of_buffer_elements) {
+            continue;
+          }
+          buffer_element.status = errors::Internal(
+              "Prefetch buffer elements size ", number_of_buffer_elements,
+              " does not have the input ", tf_index, " expected by encap ",
+              encap_shared_data->GetName());
+          NGRAPH_VLOG(0) << "[PREFETCH] "
+                         << buffer_element.status.error_message();
+          for (auto data : shared_data) {
+            data->Unref();
+          }
+          mutex_lock l(mu_);
+          WaitForCopy(l);
+          AddToBuffer(ctx.get(), std::move(buffer_element));
+          return;
+        }
+      }
+
+      // The element and the tensors, until the copy is complete
+      struct DeviceCopy {
+        BufferElement buffer_element;
+        std::vector<ngraph_bridge::NGraphPrefetchSharedResouce*> shared_data;
+        std::vector<ngraph_bridge::NGraphPrefetchSharedResouce::IOTensorBundle>
+            bundles;
+        std::vector<ngraph_bridge::NGraphPrefetchCopy> copies;
+        std::vector<int> tf_indexes;
+        // Bytes of the prefetched inputs in all the pipeline slots
+        int64 slot_bytes = 0;
+        std::unique_ptr<ngraph::Event> event;
+      };
+      auto device_copy = std::make_shared<DeviceCopy>();
+      device_copy->buffer_element = std::move(buffer_element);
+      device_copy->shared_data = shared_data;
+
+      string event_name = "Prf Dev Copy: Pipe_Ind";
+      for (auto encap_shared_data : shared_data) {
+        encap_shared_data->SetBufferDepth(m_buffer_size);
+        device_copy->bundles.push_back(
+            encap_shared_data->GetNextIOTensorBundleForDeviceTransfer());
+        const auto& bundle = device_copy->bundles.back();
+        event_name += "_" + to_string(bundle.Id);
+
+        // Write to these tensors
+        for (auto itr : encap_shared_data->GetPrefetchInputIndexesMap()) {
+          int ng_index = itr.first;
+          int tf_index = itr.second;
+          const Tensor& tf_tensor = device_copy->buffer_element.value[tf_index];
+
+          NGRAPH_VLOG(2)
+              << "[PREFETCH] INPUT tensor being written by Prefetch: "
+              << " Value: " << tf_tensor.DebugString();
+          ngraph_bridge::NGraphPrefetchCopy copy;
+          copy.src = DMAHelper::base(&tf_tensor);
+          copy.dst = bundle.Inputs[ng_index];
+          // Checked against the size of dst by the copier, an element of
+          // another shape (e.g. a shorter last batch) or type is an error
+          copy.bytes = tf_tensor.TotalBytes();
+          device_copy->slot_bytes +=
+              copy.bytes * encap_shared_data->GetPipelineSlots();
+          device_copy->copies.push_back(copy);
+          device_copy->tf_indexes.push_back(tf_index);
+        }
+      }
+      device_copy->event.reset(new ngraph::Event(event_name, "Copy", ""));
+
+      {
+        mutex_lock l(mu_);
+        WaitForCopy(l);
+        copy_in_flight_ = true;
+      }
+      ngraph_bridge::NGraphPrefetchCopier::CopyAsync(
+          &device_copy->copies,
+          [this, ctx, device_copy](Status status) {
+            device_copy->event->Stop();
+            ngraph::Event::write_trace(*device_copy->event);
+
+            const auto& stats_aggregator = ctx->stats_aggregator();
+            for (size_t i = 0; i < device_copy->copies.size(); i++) {
+              const auto& copy = device_copy->copies[i];
+              // Bytes per microsecond are MB/s
+              float bandwidth = static_cast<float>(copy.bytes) /
+                                std::max<int64>(copy.elapsed_us, 1);
+              NGRAPH_VLOG(2) << "[PREFETCH] Copied input "
+                             << device_copy->tf_indexes[i] << ": "
+                             << copy.bytes << " bytes in " << copy.elapsed_us
+                             << " us";
+              if (stats_aggregator) {
+                stats_aggregator->AddScalar(
+                    stats_utils::CopyBandwidthScalarName(
+                        dataset()->node_name(), device_copy->tf_indexes[i]),
+                    bandwidth, num_elements());
+              }
+            }
+            if (!status.ok()) {
+              NGRAPH_VLOG(0) << "[PREFETCH] " << status.error_message();
+              device_copy->buffer_element.status = status;
+            }
+
+            // Now add them back to the other queues
+            for (size_t i = 0; i < device_copy->shared_data.size(); i++) {
+              device_copy->shared_data[i]
+                  ->AddNextIOTensorBundleReadyForDeviceExecution(
+                      std::move(device_copy->bundles[i]));
+              device_copy->shared_data[i]->Unref();
+            }
+
+            // Signal that the element has been produced.
+            mutex_lock l(mu_);
+            auto_tuner_.RecordSlotBytes(device_copy->slot_bytes);
+            AddToBuffer(ctx.get(), std::move(device_copy->buffer_element));
+            copy_in_flight_ = false;
+          });
+    }
+
     // Prefetches elements of the input, storing results in an internal
     // buffer.
     //
@@ -367,16 +616,23 @@ class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
       while (true) {
         ngraph::Event evt_prefetch("Prefetch_Produce", "Prefetch_Produce", "");
 
-        // 1. Wait for a slot in the buffer.
+        // 1. Wait for a slot in the buffer. The elements not in the buffer
+        // yet take a slot too.
         {
           mutex_lock l(mu_);
-          while (!cancelled_ && buffer_.size() >= auto_tuner_.buffer_limit()) {
+          while (!cancelled_ && buffer_.size() + elements_in_flight_ >=
+                                    auto_tuner_.buffer_limit()) {
             RecordStop(ctx.get());
+            int64 wait_start_us = ctx->env()->NowMicros();
             cond_var_.wait(l);
+            auto_tuner_.RecordProducerIdle(ctx->env()->NowMicros() -
+                                           wait_start_us);
             RecordStart(ctx.get());
           }
 
           if (cancelled_) {
+            // The copy still refers to this iterator
+            WaitForCopy(l);
             return;
           }
         }
@@ -391,101 +647,43 @@ class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
 
         // 2. Read the next element.
         // Acquire the parent lock since we will be reading an element
-        // from the input iterator. Note that we do not wish to release
-        // this lock till we have added the fetched element to the
-        // `buffer_` else there will be local state that may be missed
-        // by SaveInternal.
-        mutex_lock parent_l(parent_mu_);
+        // from the input iterator. The lock is released before the element
+        // is copied to the device, so that the copy overlaps with the
+        // reading of the next element. The element is counted in
+        // `elements_in_flight_` until it is added to `buffer_`, and
+        // SaveInternal waits for it so that it is not missed.
         bool end_of_sequence;
         BufferElement buffer_element;
-        buffer_element.status = input_impl_->GetNext(
-            ctx.get(), &buffer_element.value, &end_of_sequence);
+        {
+          mutex_lock parent_l(parent_mu_);
+          buffer_element.status = input_impl_->GetNext(
+              ctx.get(), &buffer_element.value, &end_of_sequence);
+          mutex_lock l(mu_);
+          elements_in_flight_++;
+        }
         if (buffer_element.status.ok() && end_of_sequence) {
           mutex_lock l(mu_);
+          WaitForCopy(l);
+          elements_in_flight_--;
           prefetch_thread_finished_ = true;
           NGRAPH_VLOG(2) << "[PREFETCH] Prefetch thread finished";
           cond_var_.notify_all();
           return;
         }
 
-        // Check if the shared data exist
-        ngraph_bridge::NGraphPrefetchSharedResouce* shared_data = nullptr;
-        Status s = m_resource_mgr->Lookup(
-            ngraph_bridge::NGraphPrefetchSharedResouce::CONTAINER_NAME,
-            ngraph_bridge::NGraphPrefetchSharedResouce::RESOURCE_NAME,
-            &shared_data);
-        if (s.ok()) {
-          shared_data->SetBufferDepth(m_buffer_size);
-
-          auto ng_input_tensor_bundle =
-              shared_data->GetNextIOTensorBundleForDeviceTransfer();
-          auto ng_prefetch_input_indexes_map =
-              shared_data->GetPrefetchInputIndexesMap();
-          ngraph::Event evt_dev_cp(
-              "Prf Dev Copy: Pipe_Ind_" + to_string(ng_input_tensor_bundle.Id),
-              "Copy", "");
-          int number_of_buffer_elements = buffer_element.value.size();
-          if (number_of_buffer_elements !=
-              ng_prefetch_input_indexes_map.size()) {
-            throw std::runtime_error(
-                "Prefetch buffer elements size " +
-                to_string(number_of_buffer_elements) +
-                " does not match the number of prefetch inputs expected by "
-                "encap " +
-                to_string(ng_prefetch_input_indexes_map.size()));
-          }
-          std::vector<std::unique_ptr<ngraph::Event>>
-              prefetch_input_write_events;
-          // Write to these tensors
-          for (auto itr : ng_prefetch_input_indexes_map) {
-            int ng_index = itr.first;
-            int tf_index = itr.second;
-
-            ng::element::Type ng_element_type;
-            auto status = ngraph_bridge::TFDataTypeToNGraphElementType(
-                buffer_element.value[tf_index].dtype(), &ng_element_type);
-
-            void* current_src_ptr =
-                (void*)DMAHelper::base(&buffer_element.value[tf_index]);
-            std::unique_ptr<ngraph::Event> event_copy_h2d(new ngraph::Event(
-                "H2D_PrefetchInput_" + std::to_string(tf_index), "Copy", ""));
-            try {
-              NGRAPH_VLOG(2)
-                  << "[PREFETCH] INPUT tensor being written by Prefetch: "
-                  << " Value: " << buffer_element.value[tf_index].DebugString();
-              ng_input_tensor_bundle.Inputs[ng_index]->write(
-                  current_src_ptr,
-                  ng_input_tensor_bundle.Inputs[ng_index]->get_element_count() *
-                      ng_element_type.size());
-            } catch (const std::exception& exp) {
-              throw exp;
-            } catch (...) {
-              throw std::runtime_error(
-                  "Error copying TF tensor to device tensor");
-            }
-            event_copy_h2d->Stop();
-            prefetch_input_write_events.push_back(std::move(event_copy_h2d));
-          }
-
-          for (auto& next : prefetch_input_write_events) {
-            ngraph::Event::write_trace(*next.get());
-          }
-
-          // Now add them back to the other queue
-          shared_data->AddNextIOTensorBundleReadyForDeviceExecution(
-              ng_input_tensor_bundle);
-          shared_data->Unref();
-          evt_dev_cp.Stop();
-          ngraph::Event::write_trace(evt_dev_cp);
+        // Check if the shared data of the encapsulates exist
+        std::vector<ngraph_bridge::NGraphPrefetchSharedResouce*> shared_data;
+        if (buffer_element.status.ok()) {
+          shared_data = LookUpSharedData();
         }
-
-        // 3. Signal that the element has been produced.
-        {
+        if (!shared_data.empty()) {
+          StartDeviceCopy(ctx, shared_data, std::move(buffer_element));
+        } else {
+          // 3. Signal that the element has been produced, after the element
+          // being copied.
           mutex_lock l(mu_);
-          RecordBufferEnqueue(ctx.get(), buffer_element.value);
-          buffer_element.created_us = ctx->env()->NowMicros();
-          buffer_.push_back(std::move(buffer_element));
-          cond_var_.notify_all();
+          WaitForCopy(l);
+          AddToBuffer(ctx.get(), std::move(buffer_element));
         }
         ++num_produced;
         evt_prefetch.Stop();
@@ -543,6 +741,11 @@ class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
     std::unique_ptr<Thread> prefetch_thread_ GUARDED_BY(mu_);
     bool cancelled_ GUARDED_BY(mu_) = false;
     bool prefetch_thread_finished_ GUARDED_BY(mu_) = false;
+    // Elements read from the input and not yet added to `buffer_`: the one
+    // being copied to the device and the one being read
+    int elements_in_flight_ GUARDED_BY(mu_) = 0;
+    // Whether an element is being copied to the device
+    bool copy_in_flight_ GUARDED_BY(mu_) = false;
 
     std::atomic<int64> slack_us_;
     ResourceMgr* m_resource_mgr{nullptr};
@@ -555,6 +758,10 @@ class NGraphPrefetchDatasetOp::Dataset : public DatasetBase {
   // execution.
   const int64 slack_period_;
 
+  // Name of the iterator node the dataset is made for. The elements are
+  // copied to the encapsulates this iterator feeds.
+  const string iterator_;
+
   // Store the resource manager
   ResourceMgr* m_resource_mgr{nullptr};
 };
@@ -576,7 +783,7 @@ void NGraphPrefetchDatasetOp::MakeDataset(OpKernelContext* ctx,
     metrics::RecordTFDataAutotune(kDatasetName);
   }
 
-  *output = new Dataset(ctx, input, buffer_size, slack_period_);
+  *output = new Dataset(ctx, input, buffer_size, slack_period_, iterator_);
 }
 
 namespace {
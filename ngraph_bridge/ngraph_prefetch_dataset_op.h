@@ -54,6 +54,9 @@ class NGraphPrefetchDatasetOp : public UnaryDatasetOpKernel {
     if (ctx->HasAttr("slack_period")) {
       OP_REQUIRES_OK(ctx, ctx->GetAttr("slack_period", &slack_period_));
     }
+    if (ctx->HasAttr("iterator")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("iterator", &iterator_));
+    }
   }
 
  protected:
@@ -63,6 +66,8 @@ class NGraphPrefetchDatasetOp : public UnaryDatasetOpKernel {
  private:
   class Dataset;
   int64 slack_period_ = 0;
+  // Name of the iterator node the dataset is made for, empty if unknown
+  string iterator_;
 };
 
 }  // namespace data
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 
 #include "ngraph/runtime/tensor.hpp"
 
@@ -40,11 +41,12 @@ class NGraphPrefetchSharedResouce : public ResourceBase {
  public:
   explicit NGraphPrefetchSharedResouce(
       const std::string& ng_enc_op_name, int cluster_id, int graph_id,
-      const map<int, int>& prefetch_input_index_map)
+      const map<int, int>& prefetch_input_index_map, int pipeline_slots)
       : m_ng_enc_op_name(ng_enc_op_name),
         m_graph_id(graph_id),
         m_cluster_id(cluster_id),
-        m_prefetch_input_index_map(prefetch_input_index_map) {}
+        m_prefetch_input_index_map(prefetch_input_index_map),
+        m_pipeline_slots(pipeline_slots) {}
 
   // Returns a debug string for *this.
   string DebugString() const override { return "NGraphPrefetchSharedResouce"; }
@@ -54,12 +56,23 @@ class NGraphPrefetchSharedResouce : public ResourceBase {
   std::string GetName() const { return m_ng_enc_op_name; }
   int GetGraphId() const { return m_graph_id; }
   int GetClusterId() const { return m_cluster_id; }
+  // Number of IOTensorBundles the prefetched inputs are copied to in turn,
+  // the pipeline depth of the encap
+  int GetPipelineSlots() const { return m_pipeline_slots; }
 
   static constexpr const char* RESOURCE_NAME = "NG_PREFETCH_DATA";
   static constexpr const char* CONTAINER_NAME = "NG_PREFETCH_DATA_CONTAINER";
   static constexpr const char* NGRAPH_TF_USE_PREFETCH =
       "NGRAPH_TF_USE_PREFETCH";
 
+  // Name of the resource shared by the encap of the given graph and cluster
+  // and the NGraphPrefetchDataset made for the iterator feeding it
+  static std::string ResourceName(int graph_id, int cluster_id,
+                                  const std::string& iterator_name) {
+    return strings::StrCat(RESOURCE_NAME, "_", graph_id, "_", cluster_id, "_",
+                           iterator_name);
+  }
+
   struct IOTensorBundle {
     int Id;
     std::vector<shared_ptr<ng::runtime::Tensor>> Inputs;
@@ -130,6 +143,7 @@ class NGraphPrefetchSharedResouce : public ResourceBase {
   // Key : indexes of IOTensorBundle.Inputs that are prefetched
   // Value : corresponding index for TF PrefetchBuffer
   const map<int, int> m_prefetch_input_index_map;
+  const int m_pipeline_slots;
   // We need to maintain two queues as follows:
   // ----------+------------+------------+------------------------------------+
   // Queue     | Writer     | Reader     | Comments                           |
@@ -142,6 +156,8 @@ class NGraphPrefetchSharedResouce : public ResourceBase {
   // The interaction is as follows:
   // Iteration  Action
   // 1          NGEncOp pushes the Input/Output tensors to m_ng_2_tf queue
+  //            (pipeline depth - 1 sets of them, so that the prefetcher can
+  //            run that many iterations ahead)
   // 2
   //            Prefetcher pulls Input/Output tensors out of m_ng_2_tf queue and
   //            and copies TF data to the prefetched inputs
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_prefetch_shared_data.h"
+#include "ngraph_bridge/ngraph_runtime_config.h"
+
+using namespace std;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+// nullptr till the first snapshot is made
+static std::atomic<const NGraphRuntimeConfig*> s_runtime_config{nullptr};
+
+const NGraphRuntimeConfig& NGraphRuntimeConfig::Get() {
+  // An acquire load is a plain load on x86, and makes the fields of a
+  // snapshot published by another thread visible
+  const NGraphRuntimeConfig* config =
+      s_runtime_config.load(std::memory_order_acquire);
+  if (config == nullptr) {
+    Reload();
+    config = s_runtime_config.load(std::memory_order_acquire);
+  }
+  return *config;
+}
+
+void NGraphRuntimeConfig::Reload() {
+  static mutex reload_mutex;
+  mutex_lock lock(reload_mutex);
+  NGraphLogMessage::ReloadMinNGraphVLogLevel();
+  NGraphRuntimeConfig config = FromEnvironment();
+  const NGraphRuntimeConfig* current =
+      s_runtime_config.load(std::memory_order_acquire);
+  if (current != nullptr && *current == config) {
+    return;
+  }
+  // The previous snapshot is leaked on purpose: steps may still read it
+  s_runtime_config.store(new NGraphRuntimeConfig(std::move(config)),
+                         std::memory_order_release);
+  NGRAPH_VLOG(1) << "Reloaded the runtime config";
+}
+
+bool NGraphRuntimeConfig::operator==(const NGraphRuntimeConfig& other) const {
+  return use_prefetch == other.use_prefetch &&
+         enable_serialize == other.enable_serialize &&
+         function_cache_item_depth == other.function_cache_item_depth &&
+         pipeline_wait_timeout_ms == other.pipeline_wait_timeout_ms &&
+         log_tensor_copies == other.log_tensor_copies &&
+         log_tensor_copies_graph_id == other.log_tensor_copies_graph_id &&
+         log_tensor_copies_status == other.log_tensor_copies_status;
+}
+
+NGraphRuntimeConfig NGraphRuntimeConfig::FromEnvironment() {
+  NGraphRuntimeConfig config;
+  config.use_prefetch =
+      std::getenv(NGraphPrefetchSharedResouce::NGRAPH_TF_USE_PREFETCH) !=
+      nullptr;
+  config.enable_serialize = std::getenv("NGRAPH_ENABLE_SERIALIZE") != nullptr;
+
+  const char* cache_depth_specified =
+      std::getenv("NGRAPH_TF_FUNCTION_CACHE_ITEM_DEPTH");
+  if (cache_depth_specified != nullptr) {
+    config.function_cache_item_depth = atoi(cache_depth_specified);
+  }
+
+  const char* timeout_specified =
+      std::getenv("NGRAPH_TF_PIPELINE_WAIT_TIMEOUT_MS");
+  if (timeout_specified != nullptr) {
+    config.pipeline_wait_timeout_ms = atoll(timeout_specified);
+  }
+
+  const char* copy_env_var = std::getenv("NGRAPH_TF_LOG_TENSOR_COPIES");
+  if (copy_env_var != nullptr) {
+    config.log_tensor_copies = true;
+    try {
+      config.log_tensor_copies_graph_id = stoi(string(copy_env_var));
+    } catch (const std::invalid_argument& ia) {
+      config.log_tensor_copies_status = errors::InvalidArgument(
+          "Invalid argument for NGRAPH_TF_LOG_TENSOR_COPIES. Exception: ",
+          ia.what());
+    }
+  }
+  return config;
+}
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#ifndef NGRAPH_TF_RUNTIME_CONFIG_H_
+#define NGRAPH_TF_RUNTIME_CONFIG_H_
+#pragma once
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+//
+// NGraphRuntimeConfig holds the environment settings that the encapsulates
+// read at every step, parsed once instead of with a getenv per step.
+//
+// A snapshot never changes: Reload() publishes a new one if the settings
+// differ from the current snapshot. The bridge reloads when it rewrites a
+// graph, so that the settings changed before a session is created apply to
+// its steps, and ngraph_bridge.reload_runtime_config() does on request.
+// Snapshots are never freed, so a reference returned by Get() stays valid
+// after a reload. Only the changes of the settings cost memory, not the
+// reloads.
+//
+// NGRAPH_TF_VLOG_LEVEL is cached by the logging library, and reloaded along
+// with the snapshot.
+//
+struct NGraphRuntimeConfig {
+  // NGRAPH_TF_USE_PREFETCH is set
+  bool use_prefetch = false;
+  // NGRAPH_ENABLE_SERIALIZE is set
+  bool enable_serialize = false;
+  // NGRAPH_TF_FUNCTION_CACHE_ITEM_DEPTH, negative if not set
+  int function_cache_item_depth = -1;
+  // NGRAPH_TF_PIPELINE_WAIT_TIMEOUT_MS
+  int64 pipeline_wait_timeout_ms = 60000;
+  // NGRAPH_TF_LOG_TENSOR_COPIES is set, to the id of the graph whose copies
+  // are logged (-1 for all of them). The status is the error if it is not a
+  // number.
+  bool log_tensor_copies = false;
+  int log_tensor_copies_graph_id = -1;
+  Status log_tensor_copies_status;
+
+  // The current snapshot, made on first use
+  static const NGraphRuntimeConfig& Get();
+  // Publishes a snapshot of the current environment, and reloads the
+  // NGRAPH_VLOG level
+  static void Reload();
+  // Parses the current environment
+  static NGraphRuntimeConfig FromEnvironment();
+
+  bool operator==(const NGraphRuntimeConfig& other) const;
+  bool operator!=(const NGraphRuntimeConfig& other) const {
+    return !(*this == other);
+  }
+};
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_RUNTIME_CONFIG_H_
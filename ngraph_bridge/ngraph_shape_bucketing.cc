@@ -0,0 +1,297 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_shape_bucketing.h"
+
+using namespace std;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+Status NGraphShapeBucketing::Initialize(const string& spec) {
+  m_buckets.clear();
+  for (const string& dim_spec : str_util::Split(spec, ';')) {
+    if (dim_spec.empty()) {
+      continue;
+    }
+    std::vector<string> dim_and_sizes = str_util::Split(dim_spec, ':');
+    int32 dim;
+    if (dim_and_sizes.size() != 2 ||
+        !strings::safe_strto32(dim_and_sizes[0], &dim) || dim < 0) {
+      return errors::InvalidArgument(
+          "Expected shape buckets as <dim>:<size>,<size>,... but got ",
+          dim_spec);
+    }
+    std::vector<int64>& sizes = m_buckets[dim];
+    for (const string& size_str : str_util::Split(dim_and_sizes[1], ',')) {
+      int64 size;
+      if (!strings::safe_strto64(size_str, &size) || size <= 0) {
+        return errors::InvalidArgument("Invalid shape bucket size ", size_str,
+                                       " for dimension ", dim);
+      }
+      sizes.push_back(size);
+    }
+    if (sizes.empty()) {
+      return errors::InvalidArgument("No shape bucket sizes for dimension ",
+                                     dim);
+    }
+    std::sort(sizes.begin(), sizes.end());
+  }
+  return Status::OK();
+}
+
+int64 NGraphShapeBucketing::BucketSize(int dim, int64 size) const {
+  auto itr = m_buckets.find(dim);
+  if (itr == m_buckets.end()) {
+    return size;
+  }
+  auto bucket = std::lower_bound(itr->second.begin(), itr->second.end(), size);
+  return bucket == itr->second.end() ? size : *bucket;
+}
+
+void NGraphShapeBucketing::FindBucketedDims(
+    const std::vector<Tensor>& inputs, const std::vector<bool>& input_is_static,
+    BucketedDims& bucketed_dims) const {
+  bucketed_dims.clear();
+  for (const auto& dim_buckets : m_buckets) {
+    int dim = dim_buckets.first;
+    int64 actual_size = -1;
+    bool same_size = true;
+    for (int i = 0; i < inputs.size(); i++) {
+      if (input_is_static[i] || inputs[i].dims() <= dim) {
+        continue;
+      }
+      if (actual_size < 0) {
+        actual_size = inputs[i].dim_size(dim);
+      } else if (actual_size != inputs[i].dim_size(dim)) {
+        same_size = false;
+      }
+    }
+    if (actual_size < 0 || !same_size) {
+      continue;
+    }
+    int64 bucket_size = BucketSize(dim, actual_size);
+    if (bucket_size != actual_size) {
+      bucketed_dims[dim] = std::make_pair(actual_size, bucket_size);
+    }
+  }
+}
+
+Status NGraphShapeBucketing::PadInputs(const std::vector<Tensor>& inputs,
+                                       const std::vector<bool>& input_is_static,
+                                       std::vector<Tensor>& padded_inputs,
+                                       BucketedDims& bucketed_dims) {
+  padded_inputs = inputs;
+  FindBucketedDims(inputs, input_is_static, bucketed_dims);
+  if (bucketed_dims.empty()) {
+    return Status::OK();
+  }
+
+  for (int i = 0; i < inputs.size(); i++) {
+    if (!input_is_static[i] && !DataTypeCanUseMemcpy(inputs[i].dtype())) {
+      NGRAPH_VLOG(3) << "Not bucketing input " << i << " of type "
+                     << DataTypeString(inputs[i].dtype());
+      bucketed_dims.clear();
+      return Status::OK();
+    }
+  }
+
+  for (int i = 0; i < inputs.size(); i++) {
+    if (input_is_static[i]) {
+      continue;
+    }
+    TensorShape padded_shape = PaddedShape(inputs[i].shape(), bucketed_dims);
+    if (padded_shape == inputs[i].shape()) {
+      continue;
+    }
+    Tensor padded_input(inputs[i].dtype(), padded_shape);
+    char* dst = static_cast<char*>(DMAHelper::base(&padded_input));
+    std::memset(dst, 0, padded_input.TotalBytes());
+    CopyRegion(static_cast<const char*>(DMAHelper::base(&inputs[i])),
+               inputs[i].shape(), dst, padded_shape,
+               DataTypeSize(inputs[i].dtype()));
+    m_input_bytes += inputs[i].TotalBytes();
+    m_padding_bytes += padded_input.TotalBytes() - inputs[i].TotalBytes();
+    padded_inputs[i] = padded_input;
+  }
+  m_padded_calls++;
+  return Status::OK();
+}
+
+TensorShape NGraphShapeBucketing::PaddedShape(
+    const TensorShape& shape, const BucketedDims& bucketed_dims) {
+  TensorShape padded_shape = shape;
+  for (const auto& bucketed_dim : bucketed_dims) {
+    if (padded_shape.dims() > bucketed_dim.first) {
+      padded_shape.set_dim(bucketed_dim.first, bucketed_dim.second.second);
+    }
+  }
+  return padded_shape;
+}
+
+Status NGraphShapeBucketing::FindOutputDims(
+    const std::shared_ptr<ngraph::Function>& padded_function,
+    const std::shared_ptr<ngraph::Function>& probe_function,
+    int64 bucket_size, std::vector<std::vector<int>>& output_dims) {
+  output_dims.clear();
+
+  // Both are translated from the same graph, so they have the same nodes in
+  // the same order unless a translation depends on the shapes
+  auto padded_ops = padded_function->get_ordered_ops();
+  auto probe_ops = probe_function->get_ordered_ops();
+  if (padded_ops.size() != probe_ops.size()) {
+    return errors::Unimplemented(
+        "The translation depends on the size of a bucketed dimension");
+  }
+  for (auto padded_itr = padded_ops.begin(), probe_itr = probe_ops.begin();
+       padded_itr != padded_ops.end(); ++padded_itr, ++probe_itr) {
+    const auto& padded_node = *padded_itr;
+    const auto& probe_node = *probe_itr;
+    if (padded_node->description() != probe_node->description() ||
+        padded_node->get_input_size() != probe_node->get_input_size() ||
+        padded_node->get_output_size() != probe_node->get_output_size()) {
+      return errors::Unimplemented(
+          "The translation depends on the size of a bucketed dimension");
+    }
+    bool inputs_differ = false;
+    for (size_t i = 0; i < padded_node->get_input_size(); i++) {
+      if (padded_node->get_input_shape(i) != probe_node->get_input_shape(i)) {
+        inputs_differ = true;
+      }
+    }
+    bool outputs_differ = false;
+    for (size_t i = 0; i < padded_node->get_output_size(); i++) {
+      if (padded_node->get_output_shape(i) != probe_node->get_output_shape(i)) {
+        outputs_differ = true;
+      }
+    }
+    if (inputs_differ && !outputs_differ) {
+      return errors::Unimplemented(
+          padded_node->description(), " ", padded_node->get_friendly_name(),
+          " reduces across a bucketed dimension");
+    }
+  }
+
+  for (size_t i = 0; i < padded_function->get_output_size(); i++) {
+    const ngraph::Shape& padded_shape = padded_function->get_output_shape(i);
+    const ngraph::Shape& probe_shape = probe_function->get_output_shape(i);
+    if (padded_shape.size() != probe_shape.size()) {
+      return errors::Unimplemented("The rank of output ", i,
+                                   " depends on a bucketed dimension");
+    }
+    std::vector<int> dims;
+    for (int d = 0; d < padded_shape.size(); d++) {
+      if (padded_shape[d] == probe_shape[d]) {
+        continue;
+      }
+      if (padded_shape[d] != bucket_size ||
+          probe_shape[d] != bucket_size + 1) {
+        return errors::Unimplemented("Dimension ", d, " of output ", i,
+                                     " is not a bucketed dimension but ",
+                                     "depends on one");
+      }
+      dims.push_back(d);
+    }
+    output_dims.push_back(dims);
+  }
+  return Status::OK();
+}
+
+TensorShape NGraphShapeBucketing::UnpaddedShape(
+    const TensorShape& padded_shape, const BucketedDims& bucketed_dims) {
+  TensorShape shape = padded_shape;
+  for (const auto& bucketed_dim : bucketed_dims) {
+    if (shape.dims() > bucketed_dim.first) {
+      shape.set_dim(bucketed_dim.first, bucketed_dim.second.first);
+    }
+  }
+  return shape;
+}
+
+void NGraphShapeBucketing::CopyRegion(const char* src,
+                                      const TensorShape& src_shape, char* dst,
+                                      const TensorShape& dst_shape,
+                                      int64 element_size) {
+  int rank = src_shape.dims();
+  if (rank == 0) {
+    std::memcpy(dst, src, element_size);
+    return;
+  }
+
+  // Extents of the copied region and the strides (in bytes) of both buffers
+  std::vector<int64> region(rank), src_strides(rank), dst_strides(rank);
+  int64 src_stride = element_size;
+  int64 dst_stride = element_size;
+  for (int d = rank - 1; d >= 0; d--) {
+    region[d] = std::min(src_shape.dim_size(d), dst_shape.dim_size(d));
+    if (region[d] == 0) {
+      return;
+    }
+    src_strides[d] = src_stride;
+    dst_strides[d] = dst_stride;
+    src_stride *= src_shape.dim_size(d);
+    dst_stride *= dst_shape.dim_size(d);
+  }
+
+  // Walk over the outer dimensions, the innermost one is copied in one go
+  int64 row_bytes = region[rank - 1] * element_size;
+  std::vector<int64> index(rank - 1, 0);
+  while (true) {
+    int64 src_offset = 0;
+    int64 dst_offset = 0;
+    for (int d = 0; d < rank - 1; d++) {
+      src_offset += index[d] * src_strides[d];
+      dst_offset += index[d] * dst_strides[d];
+    }
+    std::memcpy(dst + dst_offset, src + src_offset, row_bytes);
+
+    int d = rank - 2;
+    while (d >= 0 && ++index[d] == region[d]) {
+      index[d] = 0;
+      d--;
+    }
+    if (d < 0) {
+      break;
+    }
+  }
+}
+
+void NGraphShapeBucketing::RecordLookup(bool cache_hit, const string& name) {
+  m_lookups++;
+  if (cache_hit) {
+    m_cache_hits++;
+  }
+  NGRAPH_VLOG(1) << "NGRAPH_TF_BUCKET_PROFILE: Cluster: " << name
+                 << " Lookups: " << m_lookups
+                 << " Cache hit rate: " << (100 * m_cache_hits / m_lookups)
+                 << "% Padded calls: " << m_padded_calls
+                 << " Padding bytes: " << m_padding_bytes
+                 << " Input bytes: " << m_input_bytes;
+}
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
@@ -0,0 +1,146 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#ifndef NGRAPH_TF_SHAPE_BUCKETING_H_
+#define NGRAPH_TF_SHAPE_BUCKETING_H_
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+#include "ngraph/ngraph.hpp"
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+// dim -> (actual size, bucket size) of the dimensions padded for one call,
+// of the inputs or of one output
+using BucketedDims = std::map<int, std::pair<int64, int64>>;
+
+//
+// Every distinct input shape is a new signature and hence a new executable.
+// NGraphShapeBucketing rounds selected dimensions of the inputs of an
+// encapsulate up to a fixed set of sizes ("buckets"), for e.g. batch sizes
+// 1..64 to 1, 2, 4, ..., 64, so that a handful of executables serve all the
+// shapes. The inputs are padded with zeros up to the bucket size, the
+// bucketed executable is run, and the padding is sliced off the outputs.
+//
+// Bucketing is opt-in, through the _ngraph_shape_buckets attribute of the
+// encapsulate (or the shape_buckets parameter of the RewriterConfig, which
+// becomes that attribute). The format is
+//   <dim>:<size>,<size>,...[;<dim>:<size>,...]
+// for e.g. "0:1,2,4,8,16,32,64".
+//
+// It is only correct for computations that are independent along the
+// bucketed dimensions, for e.g. inference on a batch. A dimension is padded
+// only if all the non static inputs with that dimension agree on its size.
+// Which dimensions of the outputs carry a padded dimension, and hence are
+// sliced, is found by shape inference: the graph is translated again with
+// the dimension one larger than its bucket, and the dimensions that grow
+// with it are the ones carrying it (see FindOutputDims). A node that drops
+// a padded dimension, for e.g. a reduction or a contraction over it, would
+// mix the padding into its result, so such clusters are not bucketed. Ops
+// that combine the elements along a dimension without changing the shapes,
+// for e.g. a softmax over the batch, cannot be seen this way and must not
+// be given a bucketed dimension.
+//
+class NGraphShapeBucketing {
+ public:
+  Status Initialize(const string& spec);
+
+  bool IsEnabled() const { return !m_buckets.empty() && !m_disabled; }
+
+  // Turns bucketing off for good, for e.g. when the cluster turns out to
+  // reduce across a bucketed dimension
+  void Disable() { m_disabled = true; }
+
+  // Returns the smallest bucket of dim that can hold size, or size itself
+  // if no bucket can hold it or dim is not bucketed
+  int64 BucketSize(int dim, int64 size) const;
+
+  // Finds the dimensions of the inputs to pad, and their buckets
+  void FindBucketedDims(const std::vector<Tensor>& inputs,
+                        const std::vector<bool>& input_is_static,
+                        BucketedDims& bucketed_dims) const;
+
+  // Pads the inputs up to their buckets. padded_inputs gets either the input
+  // itself or its padded copy, and bucketed_dims the dimensions that were
+  // padded (empty if none)
+  Status PadInputs(const std::vector<Tensor>& inputs,
+                   const std::vector<bool>& input_is_static,
+                   std::vector<Tensor>& padded_inputs,
+                   BucketedDims& bucketed_dims);
+
+  // Returns shape with the dimensions of bucketed_dims set to their bucket
+  static TensorShape PaddedShape(const TensorShape& shape,
+                                 const BucketedDims& bucketed_dims);
+
+  // Finds the dimensions of the outputs that carry an input dimension padded
+  // to bucket_size. padded_function is translated for the padded inputs and
+  // probe_function for the same inputs with that dimension one larger;
+  // output_dims gets, for every output, the dimensions that differ between
+  // the two. Fails if a node of the function has inputs that differ but
+  // outputs that do not, i.e. drops the padded dimension, or if an output
+  // dimension does not follow it one to one.
+  static Status FindOutputDims(
+      const std::shared_ptr<ngraph::Function>& padded_function,
+      const std::shared_ptr<ngraph::Function>& probe_function,
+      int64 bucket_size, std::vector<std::vector<int>>& output_dims);
+
+  // Returns the shape of an output computed on padded inputs, with the
+  // padding removed. bucketed_dims holds the dimensions of that output that
+  // carry a padded dimension, see FindOutputDims.
+  static TensorShape UnpaddedShape(const TensorShape& padded_shape,
+                                   const BucketedDims& bucketed_dims);
+
+  // Copies the elements common to the src and dst shapes from src to dst,
+  // i.e. pads src into dst when dst is larger and slices src into dst when
+  // dst is smaller. Both are dense, row major buffers of the same rank.
+  static void CopyRegion(const char* src, const TensorShape& src_shape,
+                         char* dst, const TensorShape& dst_shape,
+                         int64 element_size);
+
+  // Cache hit rate and padding waste counters
+  void RecordLookup(bool cache_hit, const string& name);
+  int64 GetLookupCount() const { return m_lookups; }
+  int64 GetCacheHitCount() const { return m_cache_hits; }
+  int64 GetPaddedCallCount() const { return m_padded_calls; }
+  int64 GetInputBytes() const { return m_input_bytes; }
+  int64 GetPaddingBytes() const { return m_padding_bytes; }
+
+ private:
+  // dim -> sorted bucket sizes
+  std::map<int, std::vector<int64>> m_buckets;
+
+  std::atomic<bool> m_disabled{false};
+  std::atomic<int64> m_lookups{0};
+  std::atomic<int64> m_cache_hits{0};
+  std::atomic<int64> m_padded_calls{0};
+  std::atomic<int64> m_input_bytes{0};
+  std::atomic<int64> m_padding_bytes{0};
+};
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_SHAPE_BUCKETING_H_
@@ -0,0 +1,178 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <sstream>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_signature.h"
+#include "ngraph_bridge/ngraph_utils.h"
+
+using namespace std;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+// Two independent 64 bit hashes make up the 128 bit signature
+static const uint64 kHashSeedLow = 0x7369676cULL;
+static const uint64 kHashSeedHigh = 0x73696768ULL;
+
+std::atomic<int64> NGraphSignature::s_collisions{0};
+
+// Mixes the dtype and the dims of an input into the hashes
+template <typename Mix>
+static void MixShape(DataType dtype, const TensorShape& shape, Mix& mix) {
+  int64 header[2] = {dtype, shape.dims()};
+  mix(reinterpret_cast<const char*>(header), sizeof(header));
+  for (const auto& dim : shape) {
+    mix(reinterpret_cast<const char*>(&dim.size), sizeof(dim.size));
+  }
+}
+
+Status NGraphSignature::Compute(const std::vector<Tensor>& inputs,
+                                const std::vector<bool>& input_is_static,
+                                NGraphSignature& signature) {
+  uint64 low = kHashSeedLow;
+  uint64 high = kHashSeedHigh;
+  auto mix = [&low, &high](const char* data, size_t n) {
+    low = Hash64(data, n, low);
+    high = Hash64(data, n, high);
+  };
+
+  auto signature_inputs = std::make_shared<std::vector<Input>>();
+  signature_inputs->reserve(inputs.size());
+  for (int i = 0; i < inputs.size(); i++) {
+    const Tensor& input = inputs[i];
+    bool is_static = input_is_static[i];
+    MixShape(input.dtype(), input.shape(), mix);
+    if (is_static) {
+      if (!DataTypeCanUseMemcpy(input.dtype())) {
+        return errors::Internal("Signature got unsupported static input type ",
+                                DataType_Name(input.dtype()));
+      }
+      StringPiece data = input.tensor_data();
+      mix(data.data(), data.size());
+    }
+    signature_inputs->push_back(
+        {input.dtype(), input.shape(), is_static,
+         is_static ? input : Tensor()});
+  }
+
+  signature.m_low = low;
+  signature.m_high = high;
+  signature.m_inputs = std::move(signature_inputs);
+  return Status::OK();
+}
+
+Status NGraphSignature::Compute(const std::vector<DataType>& dtypes,
+                                const std::vector<TensorShape>& shapes,
+                                NGraphSignature& signature) {
+  if (dtypes.size() != shapes.size()) {
+    return errors::InvalidArgument("Signature got ", dtypes.size(),
+                                   " dtypes for ", shapes.size(), " shapes");
+  }
+  uint64 low = kHashSeedLow;
+  uint64 high = kHashSeedHigh;
+  auto mix = [&low, &high](const char* data, size_t n) {
+    low = Hash64(data, n, low);
+    high = Hash64(data, n, high);
+  };
+
+  auto signature_inputs = std::make_shared<std::vector<Input>>();
+  signature_inputs->reserve(shapes.size());
+  for (int i = 0; i < shapes.size(); i++) {
+    MixShape(dtypes[i], shapes[i], mix);
+    signature_inputs->push_back({dtypes[i], shapes[i], false, Tensor()});
+  }
+
+  signature.m_low = low;
+  signature.m_high = high;
+  signature.m_inputs = std::move(signature_inputs);
+  return Status::OK();
+}
+
+string NGraphSignature::ToString() const {
+  return strings::StrCat(strings::Hex(m_high, strings::kZeroPad16),
+                         strings::Hex(m_low, strings::kZeroPad16));
+}
+
+bool NGraphSignature::operator==(const NGraphSignature& other) const {
+  if (m_low != other.m_low || m_high != other.m_high) {
+    return false;
+  }
+  if (m_inputs == other.m_inputs || m_inputs == nullptr ||
+      other.m_inputs == nullptr) {
+    return true;
+  }
+  if (SameInputs(other)) {
+    return true;
+  }
+  s_collisions++;
+  NGRAPH_VLOG(0) << "Signature collision on " << ToString()
+                 << ", collisions so far: " << s_collisions;
+  return false;
+}
+
+bool NGraphSignature::SameInputs(const NGraphSignature& other) const {
+  const std::vector<Input>& inputs = *m_inputs;
+  const std::vector<Input>& other_inputs = *other.m_inputs;
+  if (inputs.size() != other_inputs.size()) {
+    return false;
+  }
+  for (int i = 0; i < inputs.size(); i++) {
+    if (inputs[i].dtype != other_inputs[i].dtype ||
+        inputs[i].shape != other_inputs[i].shape ||
+        inputs[i].is_static != other_inputs[i].is_static) {
+      return false;
+    }
+    if (inputs[i].is_static && inputs[i].value.tensor_data() !=
+                                   other_inputs[i].value.tensor_data()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Status ComputeTextSignature(const std::vector<TensorShape>& input_shapes,
+                            const std::vector<const Tensor*>& static_input_map,
+                            string& signature) {
+  std::stringstream signature_ss;
+  for (const auto& input_shape : input_shapes) {
+    for (const auto& x : input_shape) {
+      signature_ss << x.size << ",";
+    }
+    signature_ss << ";";
+  }
+
+  signature_ss << "/";
+
+  for (const Tensor* static_input : static_input_map) {
+    if (static_input != nullptr) {
+      TF_RETURN_IF_ERROR(TensorToStream(signature_ss, *static_input));
+      signature_ss << ";";
+    }
+  }
+  signature = signature_ss.str();
+  return Status::OK();
+}
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
@@ -0,0 +1,128 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#ifndef NGRAPH_TF_SIGNATURE_H_
+#define NGRAPH_TF_SIGNATURE_H_
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+// Forward declaration for friend class
+namespace testing {
+class NGraphSignatureTest_Collision_Test;
+}
+
+//
+// NGraphSignature is the key of the executable caches of an encapsulate. It
+// is a 128 bit hash of the dtypes and shapes of all the inputs and of the
+// contents of the static inputs, computed on every step without formatting
+// anything or allocating per element.
+//
+// Different inputs could hash to the same value, so a signature also keeps
+// what it was computed from and operator== compares that in full when the
+// hashes are equal. A collision is then a cache miss (and is counted), never
+// the wrong executable. The signature holds a reference to the static input
+// tensors, not to the other inputs.
+//
+class NGraphSignature {
+ public:
+  NGraphSignature() = default;
+
+  // Computes the signature of the inputs, input_is_static tells which ones
+  // are static
+  static Status Compute(const std::vector<Tensor>& inputs,
+                        const std::vector<bool>& input_is_static,
+                        NGraphSignature& signature);
+
+  // Computes the signature of inputs of the given dtypes and shapes, none of
+  // them static. Equal to the signature of tensors of these dtypes and
+  // shapes, without having to allocate them.
+  static Status Compute(const std::vector<DataType>& dtypes,
+                        const std::vector<TensorShape>& shapes,
+                        NGraphSignature& signature);
+
+  uint64 High() const { return m_high; }
+  uint64 Low() const { return m_low; }
+
+  // The hash as 32 hex digits
+  std::string ToString() const;
+
+  bool operator==(const NGraphSignature& other) const;
+  bool operator!=(const NGraphSignature& other) const {
+    return !(*this == other);
+  }
+
+  // Number of equal hashes of different inputs seen by operator==
+  static int64 GetCollisionCount() { return s_collisions; }
+
+ private:
+  // What the signature was computed from, value is only set for the static
+  // inputs
+  struct Input {
+    DataType dtype;
+    TensorShape shape;
+    bool is_static;
+    Tensor value;
+  };
+
+  // Compares the inputs in full
+  bool SameInputs(const NGraphSignature& other) const;
+
+  uint64 m_high = 0;
+  uint64 m_low = 0;
+  std::shared_ptr<const std::vector<Input>> m_inputs;
+
+  static std::atomic<int64> s_collisions;
+
+  friend class tensorflow::ngraph_bridge::testing::
+      NGraphSignatureTest_Collision_Test;
+};
+
+// The text signature of the inputs: the dims of every input, then the
+// contents of the static inputs. The executables are not cached by it, but
+// it names them outside the process, in the AOT attributes and the
+// executable disk cache keys, so it is only computed on a cache miss.
+Status ComputeTextSignature(const std::vector<TensorShape>& input_shapes,
+                            const std::vector<const Tensor*>& static_input_map,
+                            std::string& signature);
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
+
+namespace std {
+template <>
+struct hash<tensorflow::ngraph_bridge::NGraphSignature> {
+  size_t operator()(
+      const tensorflow::ngraph_bridge::NGraphSignature& signature) const {
+    return static_cast<size_t>(signature.Low());
+  }
+};
+}  // namespace std
+
+#endif  // NGRAPH_TF_SIGNATURE_H_
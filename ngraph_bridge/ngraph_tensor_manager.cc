@@ -140,6 +140,24 @@ void NGraphTensorManager::Initialize() {
       m_prefetch_iterator_encap_index_map.insert(
           {prefetch_index_wrt_pipeline, corres_iterator_index});
     }
+
+    if (NGraphCatalog::ExistsInPrefetchedInputIteratorMap(
+            m_ng_encap_graph_id, m_ng_encap_node_name)) {
+      string iterator =
+          NGraphCatalog::GetIteratorFromPrefetchedInputIteratorMap(
+              m_ng_encap_graph_id, m_ng_encap_node_name);
+      // The first graph created with encaps fed by the iterator gets its
+      // elements prefetched
+      if (NGraphCatalog::ClaimPrefetchIterator(m_ng_encap_graph_id,
+                                               iterator)) {
+        m_prefetch_iterator = iterator;
+      } else {
+        NGRAPH_VLOG(1) << "Not prefetching the inputs of "
+                       << m_ng_encap_node_name << ": " << iterator
+                       << " prefetches for graph "
+                       << NGraphCatalog::GetPrefetchIteratorGraph(iterator);
+      }
+    }
   }  // if prefetch input found in catalog
 
   // complements
@@ -97,6 +97,11 @@ class NGraphTensorManager {
     return m_prefetch_iterator_encap_index_map;
   }
 
+  // name of the iterator node feeding the prefetched inputs, empty if
+  // unknown or if the iterator prefetches for another graph (see
+  // NGraphCatalog::ClaimPrefetchIterator)
+  const string& GetPrefetchIterator() { return m_prefetch_iterator; }
+
   // input ng-variable shared name
   Status GetInputVariableSharedName(const int& input_index,
                                     string* input_var_shared_name);
@@ -146,6 +151,8 @@ class NGraphTensorManager {
   // value: index of the IteratorGetNext feeding into this input of NGEncap Op
   // Used to create prefetch shared data by NGEncap Op
   map<int, int> m_prefetch_iterator_encap_index_map;
+  // The iterator node read by that IteratorGetNext
+  string m_prefetch_iterator;
 
   // Book-keeping for weights-on-device optimizations
   unordered_map<int, string> input_variable_shared_name_map;
@@ -14,6 +14,7 @@
  * limitations under the License.
  *******************************************************************************/
 
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -25,14 +26,18 @@
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/default/logging.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/protobuf.h"
 
 #if defined NGRAPH_DISTRIBUTED
 #include "ngraph/distributed.hpp"
 #endif
 
+#include "ngraph_bridge/ngraph_runtime_config.h"
 #include "ngraph_bridge/ngraph_utils.h"
 #include "ngraph_bridge/version.h"
 
@@ -79,19 +84,13 @@ int FindNumberOfNodes(const Graph* graph, const string op_type) {
 
 Status IsNgraphTFLogTensorCopiesEnabled(int graph_id,
                                         bool& is_copy_log_enabled) {
-  const char* copy_env_var = std::getenv("NGRAPH_TF_LOG_TENSOR_COPIES");
-  if (copy_env_var == nullptr) {
+  const NGraphRuntimeConfig& runtime_config = NGraphRuntimeConfig::Get();
+  if (!runtime_config.log_tensor_copies) {
     is_copy_log_enabled = false;
     return Status::OK();
   }
-  int test_graph_id;
-  try {
-    test_graph_id = stoi(string(copy_env_var));
-  } catch (const std::invalid_argument& ia) {
-    return errors::InvalidArgument(
-        "Invalid argument for NGRAPH_TF_LOG_TENSOR_COPIES. Exception: ",
-        ia.what());
-  }
+  TF_RETURN_IF_ERROR(runtime_config.log_tensor_copies_status);
+  int test_graph_id = runtime_config.log_tensor_copies_graph_id;
   // if -1 copies are logged for all graphs
   is_copy_log_enabled = (test_graph_id == -1 || test_graph_id == graph_id);
   return Status::OK();
@@ -388,6 +387,38 @@ Status NgraphSerialize(const std::string& file_name,
   return StringToFile(file_name, serialized, true);
 }
 
+NGraphFunctionRef::NGraphFunctionRef(
+    const std::shared_ptr<ngraph::Function>& ng_function)
+    : m_ng_function(ng_function) {}
+
+NGraphFunctionRef::NGraphFunctionRef(const std::string& serialized)
+    : m_serialized(std::make_shared<const std::string>(serialized)) {}
+
+Status NGraphFunctionRef::Serialize(std::string& serialized) const {
+  if (m_serialized != nullptr) {
+    serialized = *m_serialized;
+    return Status::OK();
+  }
+  std::shared_ptr<ngraph::Function> ng_function = m_ng_function.lock();
+  if (ng_function == nullptr) {
+    return errors::Unavailable(
+        "The nGraph function is no longer held, it cannot be serialized");
+  }
+  int json_indentation = 4;
+  try {
+    serialized = ngraph::serialize(ng_function, json_indentation);
+  } catch (...) {
+    return errors::Internal("Failed to serialize ngraph function");
+  }
+  return Status::OK();
+}
+
+Status NGraphFunctionRef::ToFile(const std::string& file_name) const {
+  string serialized;
+  TF_RETURN_IF_ERROR(Serialize(serialized));
+  return StringToFile(file_name, serialized);
+}
+
 string SanitizeFileName(const string file_name) {
   // Sanitizing file name to take care of '/' that might be present in TF node
   // names
@@ -445,6 +476,27 @@ void MemoryProfile(long& vm_usage, long& resident_set) {
   }
 }
 
+int64 EstimateExecutableBytes(
+    const std::shared_ptr<ngraph::Function>& ng_function,
+    NGraphConstantPool* constant_pool) {
+  int64 bytes = 0;
+  for (const auto& node : ng_function->get_ordered_ops()) {
+    if (node->is_parameter() || node->is_output()) {
+      continue;
+    }
+    auto ng_constant = std::dynamic_pointer_cast<ng::op::Constant>(node);
+    if (ng_constant != nullptr && constant_pool != nullptr &&
+        constant_pool->Holds(ng_constant->get_data_ptr())) {
+      continue;
+    }
+    for (size_t i = 0; i < node->get_output_size(); i++) {
+      bytes += ng::shape_size(node->get_output_shape(i)) *
+               node->get_output_element_type(i).size();
+    }
+  }
+  return bytes;
+}
+
 std::string DotFilename(std::string kind, int idx) {
   return GraphFilenamePrefix(kind, idx) + ".dot";
 }
@@ -564,6 +616,43 @@ bool DumpCatalogedGraphs() {
          std::getenv("NGRAPH_TF_DUMP_CATALOGED_GRAPHS") != nullptr;
 }
 
+static thread::ThreadPool* GetRewriteThreadPool() {
+  static thread::ThreadPool* rewrite_thread_pool = []() {
+    int num_threads = std::max(1, std::min(8, port::NumSchedulableCPUs()));
+    const char* num_threads_specified =
+        std::getenv("NGRAPH_TF_REWRITE_THREADS");
+    if (num_threads_specified != nullptr) {
+      num_threads = std::max(1, atoi(num_threads_specified));
+    }
+    NGRAPH_VLOG(1) << "Graph rewrite threads: " << num_threads;
+    return new thread::ThreadPool(Env::Default(), "ngraph_rewrite",
+                                  num_threads);
+  }();
+  return rewrite_thread_pool;
+}
+
+Status ParallelForEach(int64 n, int64 cost_per_unit,
+                       const std::function<Status(int64)>& fn) {
+  std::vector<Status> statuses(n);
+  thread::ThreadPool* pool = GetRewriteThreadPool();
+  if (n <= 1 || pool->NumThreads() <= 1) {
+    for (int64 i = 0; i < n; i++) {
+      statuses[i] = fn(i);
+    }
+  } else {
+    pool->ParallelFor(n, cost_per_unit,
+                      [&fn, &statuses](int64 start, int64 limit) {
+                        for (int64 i = start; i < limit; i++) {
+                          statuses[i] = fn(i);
+                        }
+                      });
+  }
+  for (const auto& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return Status::OK();
+}
+
 #if defined(NGRAPH_DISTRIBUTED)
 void OpControlOrder(const std::shared_ptr<ngraph::Function>& ng_function,
                     const std::string& op_name) {
@@ -17,6 +17,7 @@
 #define NGRAPH_TF_BRIDGE_UTILS_H_
 
 #include <fstream>
+#include <functional>
 #include <ostream>
 #include <sstream>
 
@@ -33,6 +34,7 @@
 
 #include "logging/ngraph_log.h"
 #include "logging/tf_graph_writer.h"
+#include "ngraph_bridge/ngraph_constant_pool.h"
 
 namespace ng = ngraph;
 using namespace std;
@@ -326,6 +328,30 @@ Status CheckAxisDimInRange(std::vector<int64> axes, size_t rank);
 Status NgraphSerialize(const std::string&,
                        const std::shared_ptr<ngraph::Function>&);
 
+// The nGraph function an executable was compiled from, kept only to write
+// it out as JSON when that is asked for (an error dump, or
+// NGRAPH_ENABLE_SERIALIZE). The function is serialized on demand rather than
+// on every compilation, and it is held through a weak reference: it can be
+// serialized for as long as something else (the executable, typically) keeps
+// it alive. A function that comes in serialized (AOT) keeps its JSON.
+class NGraphFunctionRef {
+ public:
+  NGraphFunctionRef() = default;
+  explicit NGraphFunctionRef(
+      const std::shared_ptr<ngraph::Function>& ng_function);
+  explicit NGraphFunctionRef(const std::string& serialized);
+
+  // Serializes the function to (indented) JSON
+  Status Serialize(std::string& serialized) const;
+
+  // Serializes the function into a file
+  Status ToFile(const std::string& file_name) const;
+
+ private:
+  std::weak_ptr<ngraph::Function> m_ng_function;
+  std::shared_ptr<const std::string> m_serialized;
+};
+
 // Dump given string to file
 Status StringToFile(const std::string&, const std::string&,
                     bool sanitize_name = true);
@@ -336,6 +362,17 @@ string SanitizeFileName(const string file_name);
 // Collect the total memory usage through /proc/self/stat
 void MemoryProfile(long&, long&);
 
+// Estimated memory taken by an executable compiled from ng_function: the
+// bytes of the values its ops compute and of its Constants, except those
+// held by constant_pool (the pool is charged for them). The inputs and
+// outputs are not counted, they are held as I/O tensors. An upper bound,
+// nGraph reuses the memory of values that are not live at the same time,
+// but unlike the growth of the resident memory it does not count what other
+// threads allocate during the compilation.
+int64 EstimateExecutableBytes(
+    const std::shared_ptr<ngraph::Function>& ng_function,
+    NGraphConstantPool* constant_pool);
+
 std::string DotFilename(std::string, int);
 
 std::string DotFilename(std::string kind, int idx, int sub_idx);
@@ -371,6 +408,14 @@ bool DumpTrackedGraphs();
 
 bool DumpCatalogedGraphs();
 
+// Runs fn(i) for every i in [0, n) on the threads of the graph rewrite
+// passes (NGRAPH_TF_REWRITE_THREADS, default the number of cores up to 8).
+// cost_per_unit is the estimated cost of a call in cycles. Returns the
+// error of the lowest i that failed, so the outcome does not depend on the
+// scheduling.
+Status ParallelForEach(int64 n, int64 cost_per_unit,
+                       const std::function<Status(int64)>& fn);
+
 #if defined(NGRAPH_DISTRIBUTED)
 // Insert constrol dependency for AllReduce ops to ensure execution order
 void OpControlOrder(const std::shared_ptr<ngraph::Function>&,
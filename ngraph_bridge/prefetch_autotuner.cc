@@ -15,11 +15,15 @@ limitations under the License.
 
 #include "ngraph_bridge/prefetch_autotuner.h"
 
+#include <algorithm>
+
 namespace tensorflow {
 namespace data {
 
-PrefetchAutotuner::PrefetchAutotuner(int64 initial_buffer_size)
-    : buffer_limit_(initial_buffer_size) {
+PrefetchAutotuner::PrefetchAutotuner(int64 initial_buffer_size,
+                                     int64 memory_budget_bytes)
+    : buffer_limit_(initial_buffer_size),
+      memory_budget_bytes_(memory_budget_bytes) {
   if (initial_buffer_size == kAutoTune) {
     mode_ = Mode::kUpswing;
     buffer_limit_ = 1;
@@ -38,10 +42,11 @@ void PrefetchAutotuner::RecordConsumption(size_t current_buffer_size) {
     case Mode::kDisabled:
       return;
     case Mode::kUpswing:
-      if (current_buffer_size == buffer_limit_) {
+      // The buffer can hold more than a limit that just shrank
+      if (current_buffer_size >= buffer_limit_) {
         mode_ = Mode::kDownswing;
       }
-      return;
+      break;
     case Mode::kDownswing:
       if (current_buffer_size == 0) {
         if (buffer_limit_ >= kBufferLimitThreshold) {
@@ -49,10 +54,83 @@ void PrefetchAutotuner::RecordConsumption(size_t current_buffer_size) {
         } else {
           buffer_limit_ *= 2;
         }
+        last_decision_ = Decision::kGrow;
         mode_ = Mode::kUpswing;
+        ApplyBudget();
       }
-      return;
+      break;
+  }
+
+  int64 buffer_size = static_cast<int64>(current_buffer_size);
+  if (window_min_buffer_size_ < 0 || buffer_size < window_min_buffer_size_) {
+    window_min_buffer_size_ = buffer_size;
+  }
+  if (++window_consumptions_ == kWindowSize) {
+    EndWindow();
+  }
+}
+
+void PrefetchAutotuner::RecordElementBytes(int64 bytes) {
+  if (mode_ == Mode::kDisabled) {
+    return;
+  }
+  // Moving average, so that a few large elements do not shrink the buffer
+  element_bytes_ =
+      element_bytes_ == 0 ? bytes : (7 * element_bytes_ + bytes) / 8;
+  ApplyBudget();
+}
+
+void PrefetchAutotuner::RecordSlotBytes(int64 bytes) {
+  if (mode_ == Mode::kDisabled || bytes == slot_bytes_) {
+    return;
+  }
+  slot_bytes_ = bytes;
+  ApplyBudget();
+}
+
+void PrefetchAutotuner::ApplyBudget() {
+  if (memory_budget_bytes_ <= 0 || element_bytes_ <= 0) {
+    return;
+  }
+  // The slots are allocated whatever the buffer size
+  int64 buffer_budget_bytes = memory_budget_bytes_ - slot_bytes_;
+  int64 max_limit = std::max<int64>(1, buffer_budget_bytes / element_bytes_);
+  if (buffer_limit_ > max_limit) {
+    buffer_limit_ = max_limit;
+    last_decision_ = Decision::kBudget;
+  }
+}
+
+void PrefetchAutotuner::EndWindow() {
+  // A consumption finds the consumed element in the buffer, the others
+  // were never needed during the window
+  int64 unneeded = window_min_buffer_size_ - 1;
+  if (consumer_wait_us_ == 0 && producer_idle_us_ > 0 && unneeded > 0) {
+    buffer_limit_ = std::max<int64>(1, buffer_limit_ - (unneeded + 1) / 2);
+    last_decision_ = Decision::kShrink;
+    // The smaller buffer has to be filled again before growing
+    mode_ = Mode::kUpswing;
+  }
+  window_consumer_wait_us_ = consumer_wait_us_;
+  window_producer_idle_us_ = producer_idle_us_;
+  window_consumptions_ = 0;
+  window_min_buffer_size_ = -1;
+  consumer_wait_us_ = 0;
+  producer_idle_us_ = 0;
+}
+
+const char* PrefetchAutotuner::DecisionName(Decision decision) {
+  switch (decision) {
+    case Decision::kNone:
+      return "none";
+    case Decision::kGrow:
+      return "grow";
+    case Decision::kShrink:
+      return "shrink";
+    case Decision::kBudget:
+      return "budget";
   }
+  return "unknown";
 }
 
 }  // namespace data
@@ -33,22 +33,70 @@ namespace data {
 // if the prefetching thread is able to successfully fill the buffer at its
 // current size.
 //
-// Note: in the current implementation, we never decrease the buffer_limit().
-// This should change in the future!
+// The buffer_limit is also decreased. Every kWindowSize consumptions, if the
+// downstream iterator never waited and the prefetching thread was idle
+// waiting for a slot, the elements that stayed in the buffer for the whole
+// window were not needed, and half of them are given back.
+//
+// The buffer holds host tensors, so the buffer_limit is bounded by a memory
+// budget in bytes. The device copies go to a fixed number of pipeline slots
+// whatever the buffer size, their bytes are taken off the budget once, and
+// the buffer_limit never exceeds the rest divided by the average bytes of an
+// element.
 //
 // PrefetchAutotuner is NOT thread safe.
 class PrefetchAutotuner {
  public:
   static const int64 kAutoTune = -1;
+  // Consumptions between two decisions to shrink the buffer
+  static const int64 kWindowSize = 64;
+
+  // Why buffer_limit() last changed
+  enum class Decision {
+    kNone,
+    // The buffer was empty when consumed
+    kGrow,
+    // The buffer kept unneeded elements for a window
+    kShrink,
+    // The buffer would exceed the memory budget
+    kBudget,
+  };
 
-  explicit PrefetchAutotuner(int64 initial_buffer_size);
+  // memory_budget_bytes bounds the bytes of the device slots and the
+  // buffered elements when autotuning, 0 for no bound
+  explicit PrefetchAutotuner(int64 initial_buffer_size,
+                             int64 memory_budget_bytes = 0);
 
   int64 buffer_limit() const { return buffer_limit_; }
 
   void RecordConsumption(size_t current_buffer_size);
   void RecordEmpty() { RecordConsumption(0); }
 
+  // Time the downstream iterator waited for an element
+  void RecordConsumerWait(int64 us) { consumer_wait_us_ += us; }
+  // Time the prefetching thread waited for a slot in the buffer
+  void RecordProducerIdle(int64 us) { producer_idle_us_ += us; }
+  // Bytes of the host tensors of a buffered element
+  void RecordElementBytes(int64 bytes);
+  // Bytes of the device pipeline slots the elements are copied to
+  void RecordSlotBytes(int64 bytes);
+
+  Decision last_decision() const { return last_decision_; }
+  static const char* DecisionName(Decision decision);
+
+  // Times of the last complete window
+  int64 window_consumer_wait_us() const { return window_consumer_wait_us_; }
+  int64 window_producer_idle_us() const { return window_producer_idle_us_; }
+  // Average bytes of an element, 0 until an element is recorded
+  int64 element_bytes() const { return element_bytes_; }
+  int64 slot_bytes() const { return slot_bytes_; }
+
  private:
+  // Applies the memory budget to buffer_limit_
+  void ApplyBudget();
+  // Decides to shrink the buffer at the end of a window
+  void EndWindow();
+
   // PrefetchAutotuner operates as a state machine.
   enum class Mode {
     // Disables the autotuning.
@@ -65,6 +113,20 @@ class PrefetchAutotuner {
 
   int64 buffer_limit_;
   Mode mode_ = Mode::kDisabled;
+  Decision last_decision_ = Decision::kNone;
+
+  const int64 memory_budget_bytes_;
+  int64 element_bytes_ = 0;
+  int64 slot_bytes_ = 0;
+
+  // The current window
+  int64 window_consumptions_ = 0;
+  int64 window_min_buffer_size_ = -1;
+  int64 consumer_wait_us_ = 0;
+  int64 producer_idle_us_ = 0;
+  // The last complete window
+  int64 window_consumer_wait_us_ = 0;
+  int64 window_producer_idle_us_ = 0;
 };
 
 }  // namespace data
@@ -57,6 +57,11 @@ ABSL_CONST_INIT const char kDroppedElements[] = "dropped_elements";
 ABSL_CONST_INIT const char kFeaturesCount[] = "features_count";
 ABSL_CONST_INIT const char kFeatureValuesCount[] = "feature_values_count";
 ABSL_CONST_INIT const char kExamplesCount[] = "examples_count";
+ABSL_CONST_INIT const char kCopyBandwidth[] = "copy_bandwidth";
+ABSL_CONST_INIT const char kConsumerWaitTime[] = "consumer_wait_time";
+ABSL_CONST_INIT const char kProducerIdleTime[] = "producer_idle_time";
+ABSL_CONST_INIT const char kElementBytes[] = "element_bytes";
+ABSL_CONST_INIT const char kAutotuneDecision[] = "autotune_decision";
 
 string ExecutionTimeHistogramName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kExecutionTime);
@@ -94,6 +99,27 @@ string FeatureValueHistogramName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kFeatureValuesCount);
 }
 
+string CopyBandwidthScalarName(const string& prefix, int input_index) {
+  return strings::StrCat(prefix, kDelimiter, "input_", input_index,
+                         kDelimiter, kCopyBandwidth);
+}
+
+string ConsumerWaitTimeScalarName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kConsumerWaitTime);
+}
+
+string ProducerIdleTimeScalarName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kProducerIdleTime);
+}
+
+string ElementBytesScalarName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kElementBytes);
+}
+
+string AutotuneDecisionScalarName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kAutotuneDecision);
+}
+
 }  // namespace stats_utils
 }  // namespace data
 }  // namespace tensorflow
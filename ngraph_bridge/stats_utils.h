@@ -57,6 +57,11 @@ extern const char kDroppedElements[];
 extern const char kFeaturesCount[];
 extern const char kFeatureValuesCount[];
 extern const char kExamplesCount[];
+extern const char kCopyBandwidth[];
+extern const char kConsumerWaitTime[];
+extern const char kProducerIdleTime[];
+extern const char kElementBytes[];
+extern const char kAutotuneDecision[];
 
 // Name for tf.data function execution time (in ns) histogram metrics.
 string ExecutionTimeHistogramName(const string& prefix);
@@ -87,6 +92,25 @@ string FeatureHistogramName(const string& prefix);
 // Name for feature-values count histogram metrics.
 string FeatureValueHistogramName(const string& prefix);
 
+// Name for the copy bandwidth (MB/s) of an input to the device scalar
+// metrics.
+string CopyBandwidthScalarName(const string& prefix, int input_index);
+
+// Name for the time (in us) the consumer of a prefetch buffer waited for an
+// element during the last autotuning window scalar metrics.
+string ConsumerWaitTimeScalarName(const string& prefix);
+
+// Name for the time (in us) the producer of a prefetch buffer waited for a
+// slot during the last autotuning window scalar metrics.
+string ProducerIdleTimeScalarName(const string& prefix);
+
+// Name for the average bytes of a prefetched element scalar metrics.
+string ElementBytesScalarName(const string& prefix);
+
+// Name for the last change of a prefetch buffer limit by its autotuner (0
+// none, 1 grow, 2 shrink, 3 memory budget) scalar metrics.
+string AutotuneDecisionScalarName(const string& prefix);
+
 }  // namespace stats_utils
 }  // namespace data
 }  // namespace tensorflow
@@ -48,6 +48,7 @@ __all__ = [
     'is_logging_placement', '__version__', 'cxx11_abi_flag'
     'is_grappler_enabled', 'update_config', 'are_variables_enabled',
     'set_disabled_ops', 'get_disabled_ops', 'is_distributed_enabled',
+    'reload_runtime_config',
 ]
 
 ext = 'dylib' if system() == 'Darwin' else 'so'
@@ -249,6 +250,9 @@ if ngraph_classic_loaded:
     def is_distributed_enabled():
         return ngraph_bridge_lib.ngraph_tf_is_distributed_enabled()
 
+    def reload_runtime_config():
+        ngraph_bridge_lib.ngraph_reload_runtime_config()
+
     __version__ = \
     "nGraph bridge version: " + str(ngraph_bridge_lib.ngraph_tf_version()) + "\n" + \
     "nGraph version used for this build: " + str(ngraph_bridge_lib.ngraph_lib_version()) + "\n" + \
@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * Copyright 2017-2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <chrono>
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+
+#include "ngraph_bridge/ngraph_assign_clusters.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+// Time of AssignClusters on growing synthetic graphs, chains of Adds split
+// into segments of segment_length nodes by an unmarked node (see the
+// AssignClusters.SegmentedChain test)
+TEST(AssignClustersBenchmark, Scaling) {
+  const int segment_length = 50;
+  Tensor t(DT_FLOAT, TensorShape{2, 3});
+  for (int num_nodes : {1000, 4000, 16000}) {
+    Graph g(OpRegistry::Global());
+    std::vector<Node*> nodes(num_nodes);
+    for (int i = 0; i < 2; i++) {
+      ASSERT_OK(NodeBuilder("const" + to_string(i), "Const")
+                    .Attr("dtype", DT_FLOAT)
+                    .Attr("value", t)
+                    .Attr("_ngraph_marked_for_clustering", true)
+                    .Finalize(&g, &nodes[i]));
+    }
+    for (int i = 2; i < num_nodes; i++) {
+      NodeBuilder builder("add" + to_string(i), "Add");
+      builder.Input(nodes[i - 1], 0).Input(nodes[i - 2], 0).Attr("T",
+                                                                  DT_FLOAT);
+      if (i % segment_length != 0) {
+        builder.Attr("_ngraph_marked_for_clustering", true);
+      }
+      ASSERT_OK(builder.Finalize(&g, &nodes[i]));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_OK(AssignClusters(&g));
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    cout << "AssignClusters on " << num_nodes << " nodes, " << g.num_edges()
+         << " edges: " << elapsed.count() << " ms" << endl;
+  }
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * Copyright 2017-2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/graph/graph_constructor.h"
+
+#include "ngraph_bridge/ngraph_backend_manager.h"
+#include "ngraph_bridge/ngraph_executor.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+namespace tf = tensorflow;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+static Status LoadGraphFromPbTxt(const string& pb_file,
+                                 unique_ptr<tf::Graph>& new_graph) {
+  tensorflow::GraphDef graph_def;
+  TF_RETURN_IF_ERROR(ReadTextProto(Env::Default(), pb_file, &graph_def));
+
+  GraphConstructorOptions opts;
+  opts.allow_internal_ops = true;
+  new_graph.reset(new tf::Graph(OpRegistry::Global()));
+  return ConvertGraphDefToGraph(opts, graph_def, new_graph.get());
+}
+
+// Throughput of the pipelined path at pipeline depths 2, 3 and 4, with more
+// threads than pipeline groups. A thread that finds no free group waits for
+// one, so the depth bounds the number of steps in flight.
+TEST(ParallelExecutorBenchmark, PipelineDepthThroughput) {
+  const int num_threads = 4;
+  const int steps_per_thread = 250;
+  tf::ngraph_bridge::BackendManager::CreateBackend("INTERPRETER");
+
+  for (int depth : {2, 3, 4}) {
+    unique_ptr<tf::Graph> input_graph;
+    ASSERT_OK(LoadGraphFromPbTxt("test_axpy_launchop.pbtxt", input_graph));
+    NGraphExecutor executor(100, 500, 600, input_graph, "INTERPRETER",
+                            "xyz_500", 16);
+
+    google::protobuf::Map<string, AttrValue> attrs;
+    attrs["_ngraph_pipeline_depth"].set_s(to_string(depth));
+    std::unordered_map<std::string, std::string> additional_attribute_map;
+    ASSERT_OK(executor.ParseNodeAttributes(attrs, &additional_attribute_map));
+    ASSERT_TRUE(additional_attribute_map.empty());
+    ASSERT_EQ(executor.GetTensorPipelineDepth(), depth);
+
+    Tensor x(DT_FLOAT, TensorShape({2, 3}));
+    Tensor y(DT_FLOAT, TensorShape({2, 3}));
+    AssignInputValues(x, 1.0f);
+    AssignInputValues(y, 1.0f);
+    std::vector<Tensor> tf_input_tensors{x, y};
+    shared_ptr<ngraph::runtime::Executable> ng_exec;
+    shared_ptr<PipelinedTensorsStore> pts;
+    NGraphFunctionRef ng_function_ref;
+    bool cache_hit = false;
+    ASSERT_OK(executor.GetExecutableFunctionAndTensors(
+        tf_input_tensors, ng_exec, ng_function_ref, pts, cache_hit));
+    ASSERT_EQ(pts->get_depth(), depth);
+
+    auto worker = [&]() {
+      for (int step = 0; step < steps_per_thread; step++) {
+        auto io_tensors = pts->get_tensors(-1, nullptr);
+        get<1>(io_tensors)[0]->write(DMAHelper::base(&x), x.TotalBytes());
+        get<1>(io_tensors)[1]->write(DMAHelper::base(&y), y.TotalBytes());
+        ng_exec->call(get<2>(io_tensors), get<1>(io_tensors));
+
+        Tensor tf_output_tensor(DT_FLOAT, TensorShape({2, 3}));
+        get<2>(io_tensors)[0]->read(DMAHelper::base(&tf_output_tensor),
+                                    tf_output_tensor.TotalBytes());
+        pts->return_tensors(get<0>(io_tensors));
+
+        Tensor expected_val(DT_FLOAT, TensorShape({2, 3}));
+        AssignInputValues(expected_val, 6.0f);
+        Compare(tf_output_tensor, expected_val, 0.0f);
+      }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    cout << "Pipeline depth: " << depth
+         << " Steps/sec: " << num_threads * steps_per_thread / elapsed.count()
+         << " Wait histogram (us): "
+         << pts->get_index_library()->get_wait_histogram_string() << endl;
+  }
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
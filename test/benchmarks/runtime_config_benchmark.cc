@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * Copyright 2017-2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+#include "tensorflow/core/platform/env.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_runtime_config.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+static const list<string> kRuntimeEnvVars{
+    "NGRAPH_TF_VLOG_LEVEL",
+    "NGRAPH_TF_USE_PREFETCH",
+    "NGRAPH_ENABLE_SERIALIZE",
+    "NGRAPH_TF_FUNCTION_CACHE_ITEM_DEPTH",
+    "NGRAPH_TF_PIPELINE_WAIT_TIMEOUT_MS",
+    "NGRAPH_TF_LOG_TENSOR_COPIES"};
+
+static void UnsetRuntimeEnv() {
+  for (const auto& env_var : kRuntimeEnvVars) {
+    UnsetEnvVariable(env_var);
+  }
+}
+
+// The settings a step reads, from the environment as they used to be and
+// from the snapshot, and the time per step of each
+TEST(RuntimeConfigBenchmark, PerStepOverhead) {
+  const unordered_map<string, string>& env_map = StoreEnv(kRuntimeEnvVars);
+  UnsetRuntimeEnv();
+  SetEnvVariable("NGRAPH_TF_VLOG_LEVEL", "0");
+  SetEnvVariable("NGRAPH_TF_FUNCTION_CACHE_ITEM_DEPTH", "16");
+  SetEnvVariable("NGRAPH_TF_PIPELINE_WAIT_TIMEOUT_MS", "1000");
+  NGraphRuntimeConfig::Reload();
+
+  // About the number of NGRAPH_VLOG evaluated by a step
+  const int kVLogsPerStep = 20;
+  const int kSteps = 20000;
+
+  int64 getenv_sum = 0;
+  int64 start_us = Env::Default()->NowMicros();
+  for (int step = 0; step < kSteps; step++) {
+    for (int i = 0; i < kVLogsPerStep; i++) {
+      std::istringstream ss(std::getenv("NGRAPH_TF_VLOG_LEVEL"));
+      int64 level;
+      ss >> level;
+      getenv_sum += level;
+    }
+    getenv_sum += std::getenv("NGRAPH_TF_USE_PREFETCH") != nullptr;
+    getenv_sum += std::getenv("NGRAPH_ENABLE_SERIALIZE") != nullptr;
+    getenv_sum += atoi(std::getenv("NGRAPH_TF_FUNCTION_CACHE_ITEM_DEPTH"));
+    getenv_sum += atoll(std::getenv("NGRAPH_TF_PIPELINE_WAIT_TIMEOUT_MS"));
+    getenv_sum += std::getenv("NGRAPH_TF_LOG_TENSOR_COPIES") != nullptr;
+  }
+  int64 getenv_us = Env::Default()->NowMicros() - start_us;
+
+  int64 snapshot_sum = 0;
+  start_us = Env::Default()->NowMicros();
+  for (int step = 0; step < kSteps; step++) {
+    for (int i = 0; i < kVLogsPerStep; i++) {
+      snapshot_sum += NGraphLogMessage::MinNGraphVLogLevel();
+    }
+    const NGraphRuntimeConfig& config = NGraphRuntimeConfig::Get();
+    snapshot_sum += config.use_prefetch;
+    snapshot_sum += config.enable_serialize;
+    snapshot_sum += config.function_cache_item_depth;
+    snapshot_sum += config.pipeline_wait_timeout_ms;
+    snapshot_sum += config.log_tensor_copies;
+  }
+  int64 snapshot_us = Env::Default()->NowMicros() - start_us;
+
+  std::cout << "Per step overhead of the settings: getenv "
+            << double(getenv_us) * 1000 / kSteps << " ns, snapshot "
+            << double(snapshot_us) * 1000 / kSteps << " ns" << std::endl;
+  ASSERT_EQ(getenv_sum, snapshot_sum);
+
+  UnsetRuntimeEnv();
+  RestoreEnv(env_map);
+  NGraphRuntimeConfig::Reload();
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
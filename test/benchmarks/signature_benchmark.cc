@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * Copyright 2017-2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+
+#include "gtest/gtest.h"
+
+#include "ngraph_bridge/ngraph_signature.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+// Per step cost of computing the signature and looking it up in a cache,
+// with the text signature (as the executable caches were keyed before) and
+// with the hashed one
+TEST(NGraphSignatureBenchmark, PerStepOverhead) {
+  const int num_inputs = 16;
+  const int num_steps = 10000;
+  std::vector<Tensor> inputs;
+  std::vector<bool> input_is_static;
+  for (int i = 0; i < num_inputs - 1; i++) {
+    inputs.push_back(Tensor(DT_FLOAT, TensorShape({8, 16, 16, 3})));
+    input_is_static.push_back(false);
+  }
+  Tensor static_input(DT_INT32, TensorShape({1024}));
+  AssignInputValues<int32>(static_input, 7);
+  inputs.push_back(static_input);
+  input_is_static.push_back(true);
+
+  // Before: the text signature keys a map of strings
+  std::unordered_map<string, int> text_cache;
+  auto start = std::chrono::steady_clock::now();
+  for (int step = 0; step < num_steps; step++) {
+    std::vector<TensorShape> input_shapes;
+    std::vector<const Tensor*> static_input_map(inputs.size());
+    for (int i = 0; i < inputs.size(); i++) {
+      input_shapes.push_back(inputs[i].shape());
+      if (input_is_static[i]) {
+        static_input_map[i] = &inputs[i];
+      }
+    }
+    string text_signature;
+    ASSERT_OK(ComputeTextSignature(input_shapes, static_input_map,
+                                   text_signature));
+    text_cache[text_signature]++;
+  }
+  std::chrono::duration<double, std::micro> text_elapsed =
+      std::chrono::steady_clock::now() - start;
+  ASSERT_EQ(text_cache.size(), 1);
+
+  // After: the 128 bit signature keys the map
+  std::unordered_map<NGraphSignature, int> cache;
+  start = std::chrono::steady_clock::now();
+  for (int step = 0; step < num_steps; step++) {
+    NGraphSignature signature;
+    ASSERT_OK(NGraphSignature::Compute(inputs, input_is_static, signature));
+    cache[signature]++;
+  }
+  std::chrono::duration<double, std::micro> hash_elapsed =
+      std::chrono::steady_clock::now() - start;
+  ASSERT_EQ(cache.size(), 1);
+
+  cout << "Signature overhead per step, text: "
+       << text_elapsed.count() / num_steps
+       << " us, hashed: " << hash_elapsed.count() / num_steps << " us" << endl;
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
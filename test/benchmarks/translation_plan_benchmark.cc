@@ -0,0 +1,86 @@
+/*******************************************************************************
+ * Copyright 2017-2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <chrono>
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+
+#include "ngraph_bridge/ngraph_builder.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+namespace ng = ngraph;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+// Translation time of a 2000 node cluster for 10 batch sizes, building the
+// translation from scratch every time and reusing the translation plan
+TEST(TranslationPlanBenchmark, BatchSizes) {
+  const int num_nodes = 2000;
+  const int num_batch_sizes = 10;
+
+  // _Arg -> Abs -> Neg -> Abs -> ... -> _Retval
+  Graph input_graph(OpRegistry::Global());
+  Node* node;
+  ASSERT_OK(NodeBuilder("arg", "_Arg")
+                .Attr("T", DT_FLOAT)
+                .Attr("index", 0)
+                .Finalize(&input_graph, &node));
+  for (int i = 0; i < num_nodes - 2; i++) {
+    ASSERT_OK(NodeBuilder("op" + to_string(i), i % 2 == 0 ? "Abs" : "Neg")
+                  .Input(node, 0)
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(&input_graph, &node));
+  }
+  ASSERT_OK(NodeBuilder("retval", "_Retval")
+                .Input(node, 0)
+                .Attr("T", DT_FLOAT)
+                .Attr("index", 0)
+                .Finalize(&input_graph, &node));
+
+  std::vector<const Tensor*> static_input_map{nullptr};
+  std::chrono::duration<double, std::milli> elapsed{0}, planned_elapsed{0};
+  Builder::TranslationPlan plan;
+  for (int batch_size = 1; batch_size <= num_batch_sizes; batch_size++) {
+    std::vector<TensorShape> input_shapes{TensorShape({batch_size, 64})};
+    shared_ptr<ng::Function> ng_function;
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_OK(Builder::TranslateGraph(input_shapes, static_input_map,
+                                      &input_graph, ng_function));
+    elapsed += std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    ASSERT_OK(Builder::TranslateGraph(input_shapes, static_input_map,
+                                      &input_graph, ng_function, nullptr,
+                                      &plan));
+    planned_elapsed += std::chrono::steady_clock::now() - start;
+  }
+
+  cout << "Translation of " << num_nodes << " nodes for " << num_batch_sizes
+       << " batch sizes, from scratch: " << elapsed.count()
+       << " ms, with the translation plan: " << planned_elapsed.count()
+       << " ms" << endl;
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
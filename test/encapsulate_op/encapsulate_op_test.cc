@@ -64,10 +64,27 @@ TEST(EncapsulateOp, ComputeSignature) {
       static_input_map[i] = &input_tensor;
     }
   }
-  std::stringstream signature_ss;
+  NGraphSignature signature;
+  input_shapes.clear();
   ASSERT_OK(ng_encap_impl.ComputeSignature(input_tensors, input_shapes,
-                                           static_input_map, signature_ss));
-  ASSERT_EQ(signature_ss.str(), "0,;2,;6,10,;10,10,10,;/");
+                                           static_input_map, signature));
+  ASSERT_EQ(input_shapes.size(), 4);
+  ASSERT_EQ(static_input_map.size(), 4);
+
+  // Same inputs, same signature
+  NGraphSignature same_signature;
+  std::vector<tensorflow::TensorShape> same_input_shapes;
+  std::vector<const Tensor*> same_static_input_map;
+  ASSERT_OK(ng_encap_impl.ComputeSignature(input_tensors, same_input_shapes,
+                                           same_static_input_map,
+                                           same_signature));
+  ASSERT_EQ(signature, same_signature);
+  ASSERT_EQ(signature.ToString(), same_signature.ToString());
+
+  string text_signature;
+  ASSERT_OK(ComputeTextSignature(input_shapes, static_input_map,
+                                 text_signature));
+  ASSERT_EQ(text_signature, "0,;2,;6,10,;10,10,10,;/");
 }
 
 // Test: Create backend and get ngraph executable
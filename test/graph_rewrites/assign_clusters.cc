@@ -13,6 +13,8 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  *******************************************************************************/
+#include <set>
+
 #include "gtest/gtest.h"
 
 #include "tensorflow/core/graph/graph.h"
@@ -154,6 +156,53 @@ TEST(AssignClusters, Cone) {
   ASSERT_NE(node2_cluster, node3_cluster);
 }
 
+// A chain of Adds, node i adding nodes i-1 and i-2, where every
+// segment_length-th node is not marked for clustering. The edges skipping
+// over an unmarked node cannot be contracted (the path through it would
+// become a cycle), so the segments between the unmarked nodes are the
+// clusters.
+TEST(AssignClusters, SegmentedChain) {
+  const int segment_length = 50;
+  const int num_nodes = 1000;
+  Tensor t(DT_FLOAT, TensorShape{2, 3});
+  Graph g(OpRegistry::Global());
+  std::vector<Node*> nodes(num_nodes);
+  for (int i = 0; i < 2; i++) {
+    ASSERT_OK(NodeBuilder("const" + to_string(i), "Const")
+                  .Attr("dtype", DT_FLOAT)
+                  .Attr("value", t)
+                  .Attr("_ngraph_marked_for_clustering", true)
+                  .Finalize(&g, &nodes[i]));
+  }
+  for (int i = 2; i < num_nodes; i++) {
+    NodeBuilder builder("add" + to_string(i), "Add");
+    builder.Input(nodes[i - 1], 0).Input(nodes[i - 2], 0).Attr("T", DT_FLOAT);
+    if (i % segment_length != 0) {
+      builder.Attr("_ngraph_marked_for_clustering", true);
+    }
+    ASSERT_OK(builder.Finalize(&g, &nodes[i]));
+  }
+
+  ASSERT_OK(AssignClusters(&g));
+
+  std::set<int> clusters;
+  for (int i = 0; i < num_nodes; i++) {
+    int cluster;
+    if (i % segment_length == 0 && i != 0) {
+      ASSERT_NOT_OK(GetNodeCluster(nodes[i], &cluster));
+      continue;
+    }
+    ASSERT_OK(GetNodeCluster(nodes[i], &cluster));
+    // The first marked node of the segment
+    int first = i < segment_length ? 0 : i - i % segment_length + 1;
+    int first_cluster;
+    ASSERT_OK(GetNodeCluster(nodes[first], &first_cluster));
+    ASSERT_EQ(cluster, first_cluster) << "Node " << i;
+    clusters.insert(cluster);
+  }
+  ASSERT_EQ(clusters.size(), (num_nodes - 1) / segment_length + 1);
+}
+
 }  // namespace testing
 
 }  // namespace ngraph_bridge
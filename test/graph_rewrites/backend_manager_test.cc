@@ -14,6 +14,8 @@
  * limitations under the License.
  *******************************************************************************/
 
+#include <set>
+
 #include "gtest/gtest.h"
 
 #include "tensorflow/cc/client/client_session.h"
@@ -250,6 +252,61 @@ TEST(BackendManager, GetBackendCreationString) {
   ASSERT_EQ(gpu_backend, "GPU:678");
 }
 
+// Test the concurrency of Executable::call() of the backends
+TEST(BackendManager, BackendConcurrency) {
+  list<string> env_vars{"NGRAPH_TF_BACKEND_CONCURRENCY"};
+  const unordered_map<string, string>& env_map = StoreEnv(env_vars);
+
+  // Default for CPU, the device id does not matter
+  ASSERT_OK(BackendManager::CreateBackend("CPU:0"));
+  ASSERT_EQ(BackendManager::GetBackendConcurrency("CPU:0"),
+            BackendConcurrency::kPerExecutable);
+  BackendManager::ReleaseBackend("CPU:0");
+
+  // Overridden from the environment
+  SetEnvVariable("NGRAPH_TF_BACKEND_CONCURRENCY",
+                 "INTERPRETER=global;CPU=reentrant");
+  ASSERT_OK(BackendManager::CreateBackend("CPU:0"));
+  ASSERT_EQ(BackendManager::GetBackendConcurrency("CPU:0"),
+            BackendConcurrency::kReentrant);
+  // Re-entrant calls take no lock
+  BackendManager::LockExecutable("CPU:0", nullptr);
+  BackendManager::LockExecutable("CPU:0", nullptr);
+  BackendManager::UnlockExecutable("CPU:0", nullptr);
+  BackendManager::UnlockExecutable("CPU:0", nullptr);
+
+  // Global calls hold the backend lock
+  BackendManager::SetBackendConcurrency("CPU:0", BackendConcurrency::kGlobal);
+  BackendManager::LockExecutable("CPU:0", nullptr);
+  BackendManager::UnlockExecutable("CPU:0", nullptr);
+  BackendManager::LockBackend("CPU:0");
+  BackendManager::UnlockBackend("CPU:0");
+  BackendManager::ReleaseBackend("CPU:0");
+
+  BackendConcurrency concurrency;
+  ASSERT_OK(
+      BackendManager::ParseBackendConcurrency("per_executable", &concurrency));
+  ASSERT_EQ(concurrency, BackendConcurrency::kPerExecutable);
+  ASSERT_EQ(BackendManager::BackendConcurrencyToString(concurrency),
+            "per_executable");
+  ASSERT_NOT_OK(BackendManager::ParseBackendConcurrency("none", &concurrency));
+
+  UnsetEnvVariable("NGRAPH_TF_BACKEND_CONCURRENCY");
+  RestoreEnv(env_map);
+}
+
+// Executables at nearby, aligned addresses do not share a few stripes
+TEST(BackendManager, ExecutableMutexStripes) {
+  Backend backend;
+  std::set<mutex*> stripes;
+  for (uintptr_t i = 0; i < backend.executable_mutexes.size(); i++) {
+    auto ng_exec =
+        reinterpret_cast<const ng::runtime::Executable*>(0x10000 + 16 * i);
+    stripes.insert(&BackendManager::GetExecutableMutex(&backend, ng_exec));
+  }
+  ASSERT_GT(stripes.size(), backend.executable_mutexes.size() / 4);
+}
+
 }  // namespace testing
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
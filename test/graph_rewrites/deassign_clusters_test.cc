@@ -0,0 +1,261 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <cstdio>
+#include <fstream>
+
+#include "gtest/gtest.h"
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+
+#include "ngraph_bridge/ngraph_assign_clusters.h"
+#include "ngraph_bridge/ngraph_cluster_cost_model.h"
+#include "ngraph_bridge/ngraph_cluster_profile.h"
+#include "ngraph_bridge/ngraph_deassign_clusters.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+namespace ng = ngraph;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+namespace testing {
+
+// Builds x, y (Placeholders of shape {n, n}) -> op1 -> op2 -> out (Identity,
+// not clustered), with op1 and op2 in cluster 0. If with_shapes, op1 and op2
+// have their _output_shapes.
+static void BuildClusteredPair(Graph* g, const string& op1_type,
+                               const string& op2_type, int64 n,
+                               bool with_shapes, Node** op1, Node** op2) {
+  Node* x;
+  ASSERT_OK(NodeBuilder("x", "Placeholder")
+                .Attr("dtype", DT_FLOAT)
+                .Attr("shape", TensorShape({n, n}))
+                .Finalize(g, &x));
+  Node* y;
+  ASSERT_OK(NodeBuilder("y", "Placeholder")
+                .Attr("dtype", DT_FLOAT)
+                .Attr("shape", TensorShape({n, n}))
+                .Finalize(g, &y));
+
+  std::vector<PartialTensorShape> output_shapes{PartialTensorShape({n, n})};
+  NodeBuilder op1_builder("op1", op1_type);
+  op1_builder.Input(x, 0)
+      .Input(y, 0)
+      .Attr("T", DT_FLOAT)
+      .Attr("_ngraph_marked_for_clustering", true)
+      .Attr("_ngraph_cluster", 0);
+  if (with_shapes) {
+    op1_builder.Attr("_output_shapes", output_shapes);
+  }
+  ASSERT_OK(op1_builder.Finalize(g, op1));
+
+  NodeBuilder op2_builder("op2", op2_type);
+  op2_builder.Input(*op1, 0)
+      .Input(y, 0)
+      .Attr("T", DT_FLOAT)
+      .Attr("_ngraph_marked_for_clustering", true)
+      .Attr("_ngraph_cluster", 0);
+  if (with_shapes) {
+    op2_builder.Attr("_output_shapes", output_shapes);
+  }
+  ASSERT_OK(op2_builder.Finalize(g, op2));
+
+  Node* out;
+  ASSERT_OK(NodeBuilder("out", "Identity")
+                .Input(*op2, 0)
+                .Attr("T", DT_FLOAT)
+                .Finalize(g, &out));
+}
+
+TEST(DeassignClusters, CostEstimate) {
+  Graph g(OpRegistry::Global());
+  Node *op1, *op2;
+  BuildClusteredPair(&g, "MatMul", "MatMul", 64, true, &op1, &op2);
+
+  NGraphClusterCost cost;
+  ASSERT_OK(NGraphClusterCostModel::Get().Estimate({op1, op2}, cost));
+  ASSERT_EQ(cost.num_nontrivial_nodes, 2);
+  ASSERT_TRUE(cost.shapes_known);
+  // A multiply-add per output element and inner dimension
+  ASSERT_EQ(cost.flops, 2 * (2 * 64 * 64 * 64));
+  // x and y in, op2 out
+  ASSERT_EQ(cost.transfer_bytes, 3 * 64 * 64 * 4);
+  ASSERT_GT(cost.benefit, 0);
+}
+
+// By default a cluster with known shapes is kept for its number of nodes,
+// even if it only does elementwise ops
+TEST(DeassignClusters, ElementwiseClusterKept) {
+  Graph g(OpRegistry::Global());
+  Node *op1, *op2;
+  BuildClusteredPair(&g, "Add", "Mul", 1024, true, &op1, &op2);
+
+  NGraphClusterCost cost;
+  ASSERT_OK(NGraphClusterCostModel::Get().Estimate({op1, op2}, cost));
+  ASSERT_TRUE(cost.shapes_known);
+  ASSERT_GE(cost.benefit, 0);
+
+  ASSERT_OK(DeassignClusters(&g));
+  int cluster;
+  ASSERT_OK(GetNodeCluster(op1, &cluster));
+  ASSERT_OK(GetNodeCluster(op2, &cluster));
+}
+
+// With a threshold of 1 flop per byte, two elementwise ops on large inputs
+// copy more than they compute
+TEST(DeassignClusters, CheapClusterDeassigned) {
+  Graph g(OpRegistry::Global());
+  Node *op1, *op2;
+  BuildClusteredPair(&g, "Add", "Mul", 1024, true, &op1, &op2);
+
+  NGraphClusterCostModel::Set(
+      std::unique_ptr<NGraphClusterCostModel>(new NGraphClusterCostModel(1)));
+  NGraphClusterCost cost;
+  Status estimate_status =
+      NGraphClusterCostModel::Get().Estimate({op1, op2}, cost);
+  Status status = DeassignClusters(&g);
+  // Restore the default model
+  NGraphClusterCostModel::Set(nullptr);
+  ASSERT_OK(estimate_status);
+  ASSERT_EQ(cost.flops, 2 * 1024 * 1024);
+  ASSERT_LT(cost.benefit, 0);
+  ASSERT_OK(status);
+
+  int cluster;
+  ASSERT_NOT_OK(GetNodeCluster(op1, &cluster));
+  ASSERT_NOT_OK(GetNodeCluster(op2, &cluster));
+}
+
+// The same cluster with matrix products is kept
+TEST(DeassignClusters, ExpensiveClusterKept) {
+  Graph g(OpRegistry::Global());
+  Node *op1, *op2;
+  BuildClusteredPair(&g, "MatMul", "MatMul", 1024, true, &op1, &op2);
+
+  ASSERT_OK(DeassignClusters(&g));
+  int cluster;
+  ASSERT_OK(GetNodeCluster(op1, &cluster));
+  ASSERT_OK(GetNodeCluster(op2, &cluster));
+}
+
+// Without the shapes only the number of non trivial nodes counts
+TEST(DeassignClusters, UnknownShapesKept) {
+  Graph g(OpRegistry::Global());
+  Node *op1, *op2;
+  BuildClusteredPair(&g, "Add", "Mul", 1024, false, &op1, &op2);
+
+  NGraphClusterCost cost;
+  ASSERT_OK(NGraphClusterCostModel::Get().Estimate({op1, op2}, cost));
+  ASSERT_FALSE(cost.shapes_known);
+
+  ASSERT_OK(DeassignClusters(&g));
+  int cluster;
+  ASSERT_OK(GetNodeCluster(op1, &cluster));
+  ASSERT_OK(GetNodeCluster(op2, &cluster));
+}
+
+// A model that keeps every cluster
+class KeepAllCostModel : public NGraphClusterCostModel {
+ public:
+  bool KeepCluster(const NGraphClusterCost& cost) override { return true; }
+};
+
+TEST(DeassignClusters, PluggedCostModel) {
+  Graph g(OpRegistry::Global());
+  Node *op1, *op2;
+  BuildClusteredPair(&g, "Add", "Mul", 1024, true, &op1, &op2);
+
+  NGraphClusterCostModel::Set(
+      std::unique_ptr<NGraphClusterCostModel>(new KeepAllCostModel()));
+  Status status = DeassignClusters(&g);
+  // Restore the default model
+  NGraphClusterCostModel::Set(nullptr);
+  ASSERT_OK(status);
+
+  int cluster;
+  ASSERT_OK(GetNodeCluster(op1, &cluster));
+  ASSERT_OK(GetNodeCluster(op2, &cluster));
+}
+
+TEST(DeassignClusters, ProfileWriteRead) {
+  std::map<string, NGraphClusterTimings> profile;
+  NGraphClusterTimings& timings =
+      profile[NGraphClusterProfile::ClusterKey({"op1", "op2"})];
+  timings.ngraph_steps = 10;
+  timings.compile_us = 1000;
+  timings.copy_in_us = 200;
+  timings.execute_us = 500;
+  timings.copy_out_us = 300;
+  timings.fallback_steps = 2;
+  timings.fallback_us = 100;
+
+  string path = "deassign_clusters_test_profile.txt";
+  ASSERT_OK(NGraphClusterProfile::Write(path, profile));
+  // Written through a temporary file, which is renamed
+  ASSERT_FALSE(std::ifstream(path + ".tmp").good());
+  std::map<string, NGraphClusterTimings> read_profile;
+  ASSERT_OK(NGraphClusterProfile::Read(path, read_profile));
+  std::remove(path.c_str());
+
+  ASSERT_EQ(read_profile.size(), 1);
+  // The key does not depend on the order of the names
+  const NGraphClusterTimings& read_timings =
+      read_profile.at(NGraphClusterProfile::ClusterKey({"op2", "op1"}));
+  ASSERT_EQ(read_timings.ngraph_steps, 10);
+  ASSERT_EQ(read_timings.fallback_us, 100);
+  ASSERT_EQ(read_timings.NGraphStepUs(), 200);
+  ASSERT_EQ(read_timings.TensorFlowStepUs(), 50);
+
+  ASSERT_NOT_OK(NGraphClusterProfile::Read("no_such_profile.txt", profile));
+}
+
+// A cluster the default model keeps is deassigned if it ran slower than
+// TensorFlow
+TEST(DeassignClusters, ProfileGuided) {
+  for (bool ngraph_is_faster : {false, true}) {
+    Graph g(OpRegistry::Global());
+    Node *op1, *op2;
+    BuildClusteredPair(&g, "MatMul", "MatMul", 1024, true, &op1, &op2);
+
+    std::map<string, NGraphClusterTimings> profile;
+    NGraphClusterTimings& timings =
+        profile[NGraphClusterProfile::ClusterKey({"op1", "op2"})];
+    timings.ngraph_steps = 1;
+    timings.execute_us = 1000;
+    timings.fallback_steps = 1;
+    timings.fallback_us = ngraph_is_faster ? 2000 : 500;
+    NGraphProfileCostModel cost_model(profile);
+
+    NGraphClusterCost cost;
+    ASSERT_OK(cost_model.Estimate({op1, op2}, cost));
+    ASSERT_EQ(cost.ngraph_step_us, 1000);
+    ASSERT_EQ(cost.tf_step_us, ngraph_is_faster ? 2000 : 500);
+
+    ASSERT_OK(DeassignClusters(&g, &cost_model));
+    int cluster;
+    ASSERT_EQ(GetNodeCluster(op1, &cluster).ok(), ngraph_is_faster);
+    ASSERT_EQ(GetNodeCluster(op2, &cluster).ok(), ngraph_is_faster);
+  }
+}
+
+}  // namespace testing
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
@@ -117,6 +117,61 @@ TEST(EncapsulateClusters, PopulateLibrary) {
   free(fdeflib_new);
 }
 
+// The cluster graphs and functions are built in parallel, the library still
+// lists the functions in the order of the clusters
+TEST(EncapsulateClusters, PopulateLibraryManyClusters) {
+  NGraphClusterManager::EvictAllClusters();
+  Graph g(OpRegistry::Global());
+
+  Tensor t_input(DT_FLOAT, TensorShape{2, 3});
+  const int num_clusters = 32;
+  std::vector<int> cluster_indices;
+  for (int i = 0; i < num_clusters; i++) {
+    int cluster_idx = NGraphClusterManager::NewCluster();
+    cluster_indices.push_back(cluster_idx);
+
+    Node* node1;
+    ASSERT_OK(NodeBuilder("const_a" + to_string(i), "Const")
+                  .Attr("dtype", DT_FLOAT)
+                  .Attr("value", t_input)
+                  .Attr("_ngraph_marked_for_clustering", true)
+                  .Attr("_ngraph_cluster", cluster_idx)
+                  .Attr("_ngraph_backend", "CPU")
+                  .Finalize(&g, &node1));
+    Node* node2;
+    ASSERT_OK(NodeBuilder("const_b" + to_string(i), "Const")
+                  .Attr("dtype", DT_FLOAT)
+                  .Attr("value", t_input)
+                  .Attr("_ngraph_marked_for_clustering", true)
+                  .Attr("_ngraph_cluster", cluster_idx)
+                  .Attr("_ngraph_backend", "CPU")
+                  .Finalize(&g, &node2));
+    Node* node3;
+    ASSERT_OK(NodeBuilder("add" + to_string(i), "Add")
+                  .Input(node1, 0)
+                  .Input(node2, 0)
+                  .Attr("T", DT_FLOAT)
+                  .Attr("_ngraph_marked_for_clustering", true)
+                  .Attr("_ngraph_cluster", cluster_idx)
+                  .Attr("_ngraph_backend", "CPU")
+                  .Finalize(&g, &node3));
+  }
+
+  FunctionDefLibrary* fdeflib_new = new FunctionDefLibrary();
+  std::unordered_map<std::string, std::string> config_map;
+  config_map["ngraph_device_id"] = "";
+  ASSERT_OK(EncapsulateClusters(&g, 0, fdeflib_new, config_map, {0, {}}));
+
+  ASSERT_EQ(fdeflib_new->function_size(), num_clusters);
+  for (int i = 0; i < num_clusters; i++) {
+    auto func = fdeflib_new->function(i);
+    ASSERT_EQ(func.signature().name(),
+              ("ngraph_cluster_" + to_string(cluster_indices[i])));
+    ASSERT_EQ(func.node_def_size(), 3);
+  }
+  free(fdeflib_new);
+}
+
 //   Placeholder-->Add(0)--->IdN
 //                  ^
 //                  |
@@ -80,6 +80,56 @@ TEST(MarkForClustering, SimpleTest) {
     ASSERT_EQ(backend, expected_backend);
   }
 }
+
+// The backend support checks of the op types already seen are not done again
+TEST(MarkForClustering, BackendSupportCached) {
+  Graph g(OpRegistry::Global());
+
+  Tensor t_input(DT_FLOAT, TensorShape{2, 3});
+  Node* input;
+  ASSERT_OK(NodeBuilder("input", "Const")
+                .Attr("dtype", DT_FLOAT)
+                .Attr("value", t_input)
+                .Finalize(&g, &input));
+
+  // A chain of Adds, which share their support checks
+  Node* prev = input;
+  for (int i = 0; i < 10; i++) {
+    Node* add;
+    ASSERT_OK(NodeBuilder("add" + to_string(i), "Add")
+                  .Input(prev, 0)
+                  .Input(input, 0)
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(&g, &add));
+    prev = add;
+  }
+
+  const char* ng_backend_env_value = std::getenv("NGRAPH_TF_BACKEND");
+  string backend{"CPU"};
+  if (ng_backend_env_value != nullptr) {
+    backend = std::string(ng_backend_env_value);
+  }
+
+  int64 hits_before, misses_before;
+  GetBackendSupportCacheStats(hits_before, misses_before);
+  ASSERT_OK(MarkForClustering(&g, {}, backend));
+  int64 hits, misses;
+  GetBackendSupportCacheStats(hits, misses);
+  // At most the Const and the first Add miss
+  ASSERT_LE(misses - misses_before, 2);
+  ASSERT_GE(hits - hits_before, 9);
+
+  // Nothing misses when marking the graph again
+  ASSERT_OK(MarkForClustering(&g, {}, backend));
+  int64 hits_again, misses_again;
+  GetBackendSupportCacheStats(hits_again, misses_again);
+  ASSERT_EQ(misses_again, misses);
+  ASSERT_EQ(hits_again - hits, 11);
+
+  for (auto node : g.op_nodes()) {
+    ASSERT_TRUE(NodeIsMarkedForClustering(node));
+  }
+}
 }
 }
 }
\ No newline at end of file
@@ -0,0 +1,191 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <unordered_map>
+
+#include "gtest/gtest.h"
+#include "test/test_utilities.h"
+
+#include "ngraph_bridge/ngraph_cache_budget.h"
+#include "ngraph_bridge/ngraph_cache_lru.h"
+#include "ngraph_bridge/ngraph_data_cache.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+TEST(NGraphLRU, TouchAndRemove) {
+  NGraphLRU<string> lru;
+  ASSERT_TRUE(lru.Empty());
+  lru.Touch("a");
+  lru.Touch("b");
+  lru.Touch("c");
+  ASSERT_EQ(lru.Size(), 3);
+  ASSERT_EQ(lru.MostRecent(), "c");
+  ASSERT_EQ(lru.LeastRecent(), "a");
+
+  // Touching an existing key moves it to the front without duplicating it
+  lru.Touch("a");
+  ASSERT_EQ(lru.Size(), 3);
+  ASSERT_EQ(lru.MostRecent(), "a");
+  ASSERT_EQ(lru.LeastRecent(), "b");
+
+  lru.Remove("b");
+  ASSERT_FALSE(lru.Contains("b"));
+  ASSERT_EQ(lru.LeastRecent(), "c");
+  // Removing a missing key is a no-op
+  lru.Remove("b");
+  ASSERT_EQ(lru.Size(), 2);
+
+  lru.Clear();
+  ASSERT_TRUE(lru.Empty());
+}
+
+// Without costs the victim is the least recently used key
+TEST(NGraphLRU, SelectVictimNoCost) {
+  NGraphLRU<string> lru;
+  lru.Touch("a");
+  lru.Touch("b");
+  lru.Touch("c");
+  auto no_cost = [](const string&) { return NGraphCacheItemCost(); };
+  ASSERT_EQ(lru.SelectVictim(no_cost), "a");
+  lru.Touch("a");
+  ASSERT_EQ(lru.SelectVictim(no_cost), "b");
+}
+
+// Among the least recently used keys, the one cheapest to recreate per byte
+// held is evicted first
+TEST(NGraphLRU, SelectVictimByCost) {
+  unordered_map<string, NGraphCacheItemCost> costs;
+  // Large batch, took long to compile
+  costs["large"].executable_bytes = 200 * 1024 * 1024;
+  costs["large"].compile_time_ms = 40000;
+  // Small batch, quick to compile
+  costs["small"].executable_bytes = 10 * 1024 * 1024;
+  costs["small"].compile_time_ms = 500;
+
+  NGraphLRU<string> lru;
+  lru.Touch("large");
+  lru.Touch("small");
+  auto cost_of = [&costs](const string& key) { return costs[key]; };
+  ASSERT_EQ(lru.SelectVictim(cost_of), "small");
+
+  // Keys outside the eviction window are not considered, however cheap
+  for (size_t i = 0; i < NGraphLRU<string>::kEvictionWindow; i++) {
+    lru.Touch("filler" + to_string(i));
+    costs["filler" + to_string(i)] = costs["large"];
+  }
+  lru.Touch("small");
+  ASSERT_EQ(lru.SelectVictim(cost_of), "large");
+}
+
+// The process wide budget evicts items before the item depth is reached
+TEST(NGraphCacheBudget, DataCacheEviction) {
+  int64 saved_budget = NGraphCacheBudget::GetBudgetInBytes();
+  int64 charged_bytes = NGraphCacheBudget::GetChargedBytes();
+  NGraphCacheBudget::SetBudgetInBytes(charged_bytes + 2500);
+  {
+    NgraphDataCache<string, int> data_cache(
+        10, [](string key, int item) {
+          NGraphCacheItemCost cost;
+          cost.tensor_bytes = item;
+          return cost;
+        });
+    int destroy_count = 0;
+    auto destroy_item = [&destroy_count](int) { destroy_count++; };
+    auto create_item = [](string key) {
+      return make_pair(Status::OK(), 1000);
+    };
+    bool cache_hit;
+    ASSERT_OK(data_cache.LookUpOrCreate("a", create_item, destroy_item,
+                                        cache_hit)
+                  .first);
+    ASSERT_OK(data_cache.LookUpOrCreate("b", create_item, destroy_item,
+                                        cache_hit)
+                  .first);
+    ASSERT_EQ(NGraphCacheBudget::GetChargedBytes(), charged_bytes + 2000);
+    ASSERT_EQ(data_cache.Size(), 2);
+    ASSERT_EQ(data_cache.GetChargedBytes(), 2000);
+    ASSERT_EQ(destroy_count, 0);
+
+    // Use "a" so that "b" is the least recently used
+    ASSERT_OK(data_cache.LookUpOrCreate("a", create_item, destroy_item,
+                                        cache_hit)
+                  .first);
+    ASSERT_TRUE(cache_hit);
+    ASSERT_OK(data_cache.LookUpOrCreate("c", create_item, destroy_item,
+                                        cache_hit)
+                  .first);
+    ASSERT_EQ(destroy_count, 1);
+    ASSERT_EQ(NGraphCacheBudget::GetChargedBytes(), charged_bytes + 2000);
+    data_cache.LookUpOrCreate("b", create_item, destroy_item, cache_hit);
+    ASSERT_FALSE(cache_hit);
+
+    ASSERT_OK(data_cache.RemoveAll(destroy_item));
+    ASSERT_EQ(NGraphCacheBudget::GetChargedBytes(), charged_bytes);
+  }
+  NGraphCacheBudget::SetBudgetInBytes(saved_budget);
+}
+
+// A cache does not flush its items when the budget is held by another cache
+TEST(NGraphCacheBudget, OtherCacheOverBudget) {
+  int64 saved_budget = NGraphCacheBudget::GetBudgetInBytes();
+  int64 charged_bytes = NGraphCacheBudget::GetChargedBytes();
+  NGraphCacheBudget::SetBudgetInBytes(charged_bytes + 2500);
+  {
+    auto item_cost = [](string key, int item) {
+      NGraphCacheItemCost cost;
+      cost.tensor_bytes = item;
+      return cost;
+    };
+    NgraphDataCache<string, int> other_cache(10, item_cost);
+    NgraphDataCache<string, int> data_cache(10, item_cost);
+    int destroy_count = 0;
+    auto destroy_item = [&destroy_count](int) { destroy_count++; };
+    auto create_item = [](string key) {
+      return make_pair(Status::OK(), 1000);
+    };
+    bool cache_hit;
+    ASSERT_OK(other_cache.LookUpOrCreate("a", create_item, cache_hit).first);
+    ASSERT_OK(other_cache.LookUpOrCreate("b", create_item, cache_hit).first);
+
+    // Over budget, but evicting "x" would not bring it under
+    ASSERT_OK(data_cache.LookUpOrCreate("x", create_item, destroy_item,
+                                        cache_hit)
+                  .first);
+    ASSERT_OK(data_cache.LookUpOrCreate("y", create_item, destroy_item,
+                                        cache_hit)
+                  .first);
+    ASSERT_EQ(destroy_count, 0);
+    ASSERT_EQ(data_cache.Size(), 2);
+
+    // Once the other cache is empty, this one makes room for the next item
+    ASSERT_OK(other_cache.RemoveAll([](int) {}));
+    ASSERT_OK(data_cache.LookUpOrCreate("z", create_item, destroy_item,
+                                        cache_hit)
+                  .first);
+    ASSERT_EQ(destroy_count, 1);
+    ASSERT_EQ(data_cache.Size(), 2);
+    ASSERT_EQ(NGraphCacheBudget::GetChargedBytes(), charged_bytes + 2000);
+    ASSERT_OK(data_cache.RemoveAll(destroy_item));
+  }
+  NGraphCacheBudget::SetBudgetInBytes(saved_budget);
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
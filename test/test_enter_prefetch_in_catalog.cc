@@ -20,6 +20,7 @@
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/public/session.h"
 
 #include "logging/tf_graph_writer.h"
@@ -32,6 +33,7 @@
 #include "ngraph_bridge/ngraph_encapsulate_clusters.h"
 #include "ngraph_bridge/ngraph_enter_prefetch_in_catalog.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "ngraph_bridge/ngraph_prefetch_shared_data.h"
 #include "ngraph_bridge/ngraph_rewrite_for_tracking.h"
 #include "ngraph_bridge/ngraph_utils.h"
 #include "ngraph_bridge/version.h"
@@ -75,6 +77,20 @@ TEST(PrefetchCatalogTest, SmallGraph1) {
   indexes_map = NGraphCatalog::GetIndexesFromPrefetchedInputIndexMap(
       0, "ngraph_cluster_4");
   ASSERT_EQ(indexes_map, expected);
+  ASSERT_EQ(NGraphCatalog::GetIteratorFromPrefetchedInputIteratorMap(
+                0, "ngraph_cluster_4"),
+            "IteratorV2");
+  set<int> expected_encaps{4};
+  ASSERT_EQ(NGraphCatalog::GetEncapsFedByIterator(0, "IteratorV2"),
+            expected_encaps);
+  ASSERT_TRUE(NGraphCatalog::GetEncapsFedByIterator(1, "IteratorV2").empty());
+
+  // The iterator prefetches for the first graph that claims it only
+  ASSERT_EQ(NGraphCatalog::GetPrefetchIteratorGraph("IteratorV2"), -1);
+  ASSERT_TRUE(NGraphCatalog::ClaimPrefetchIterator(0, "IteratorV2"));
+  ASSERT_FALSE(NGraphCatalog::ClaimPrefetchIterator(1, "IteratorV2"));
+  ASSERT_TRUE(NGraphCatalog::ClaimPrefetchIterator(0, "IteratorV2"));
+  ASSERT_EQ(NGraphCatalog::GetPrefetchIteratorGraph("IteratorV2"), 0);
 
   // Clean up
   NGraphCatalog::ClearCatalog();
@@ -117,6 +133,92 @@ TEST(PrefetchCatalogTest, SmallGraph2) {
   RestoreEnv(env_map);
 }
 
+// Adds an IteratorV2 and its IteratorGetNext of 2 float outputs
+static void AddInputPipeline(Graph* g, const string& iterator_name,
+                             Node** get_next) {
+  DataTypeVector output_types{DT_FLOAT, DT_FLOAT};
+  std::vector<PartialTensorShape> output_shapes(2, PartialTensorShape({2}));
+  Node* iterator;
+  ASSERT_OK(NodeBuilder(iterator_name, "IteratorV2")
+                .Attr("shared_name", "")
+                .Attr("container", "")
+                .Attr("output_types", output_types)
+                .Attr("output_shapes", output_shapes)
+                .Finalize(g, &iterator));
+  ASSERT_OK(NodeBuilder(iterator_name + "/IteratorGetNext", "IteratorGetNext")
+                .Input(iterator)
+                .Attr("output_types", output_types)
+                .Attr("output_shapes", output_shapes)
+                .Finalize(g, get_next));
+}
+
+static void AddEncapsulate(Graph* g, const string& name, int cluster,
+                           const std::vector<NodeBuilder::NodeOut>& inputs) {
+  DataTypeVector input_types(inputs.size(), DT_FLOAT);
+  Node* encap;
+  ASSERT_OK(NodeBuilder(name, "NGraphEncapsulate")
+                .Attr("Targuments", input_types)
+                .Attr("Tresults", DataTypeVector{DT_FLOAT})
+                .Attr("ngraph_cluster", cluster)
+                .Attr("ngraph_graph_id", 0)
+                .Attr("ngraph_backend", "INTERPRETER")
+                .Attr("ngraph_device_id", "")
+                .Input(inputs)
+                .Finalize(g, &encap));
+}
+
+// Two input pipelines, each feeding its encapsulate, and an encapsulate fed
+// by both, which is not prefetched
+TEST(PrefetchCatalogTest, TwoPipelines) {
+  list<string> env_vars{"NGRAPH_TF_USE_PREFETCH"};
+  const unordered_map<string, string>& env_map = StoreEnv(env_vars);
+  SetEnvVariable("NGRAPH_TF_USE_PREFETCH", "1");
+
+  Graph g(OpRegistry::Global());
+  Node* get_next_a;
+  AddInputPipeline(&g, "iterator_a", &get_next_a);
+  Node* get_next_b;
+  AddInputPipeline(&g, "iterator_b", &get_next_b);
+  AddEncapsulate(&g, "encap_a", 1, {{get_next_a, 1}, {get_next_a, 0}});
+  AddEncapsulate(&g, "encap_b", 2, {{get_next_b, 0}});
+  AddEncapsulate(&g, "encap_ab", 3, {{get_next_a, 0}, {get_next_b, 1}});
+
+  ASSERT_OK(EnterPrefetchInCatalog(&g, 0));
+
+  std::map<int, int> expected_a{{0, 1}, {1, 0}};
+  ASSERT_EQ(NGraphCatalog::GetIndexesFromPrefetchedInputIndexMap(0, "encap_a"),
+            expected_a);
+  std::map<int, int> expected_b{{0, 0}};
+  ASSERT_EQ(NGraphCatalog::GetIndexesFromPrefetchedInputIndexMap(0, "encap_b"),
+            expected_b);
+  ASSERT_FALSE(NGraphCatalog::ExistsInPrefetchedInputIndexMap(0, "encap_ab"));
+  ASSERT_FALSE(
+      NGraphCatalog::ExistsInPrefetchedInputIteratorMap(0, "encap_ab"));
+
+  ASSERT_EQ(
+      NGraphCatalog::GetIteratorFromPrefetchedInputIteratorMap(0, "encap_a"),
+      "iterator_a");
+  ASSERT_EQ(
+      NGraphCatalog::GetIteratorFromPrefetchedInputIteratorMap(0, "encap_b"),
+      "iterator_b");
+  set<pair<int, int>> expected_encaps_a{{0, 1}};
+  ASSERT_EQ(NGraphCatalog::GetEncapsFedByIterator("iterator_a"),
+            expected_encaps_a);
+  set<pair<int, int>> expected_encaps_b{{0, 2}};
+  ASSERT_EQ(NGraphCatalog::GetEncapsFedByIterator("iterator_b"),
+            expected_encaps_b);
+  ASSERT_TRUE(NGraphCatalog::GetEncapsFedByIterator("iterator_c").empty());
+
+  // The encapsulates have their own shared resources
+  ASSERT_NE(NGraphPrefetchSharedResouce::ResourceName(0, 1, "iterator_a"),
+            NGraphPrefetchSharedResouce::ResourceName(0, 2, "iterator_b"));
+
+  // Clean up
+  NGraphCatalog::ClearCatalog();
+  UnsetEnvVariable("NGRAPH_TF_USE_PREFETCH");
+  RestoreEnv(env_map);
+}
+
 }  // namespace testing
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
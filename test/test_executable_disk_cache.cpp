@@ -0,0 +1,156 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <utime.h>
+
+#include "gtest/gtest.h"
+#include "test/test_utilities.h"
+
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+
+#include "ngraph_bridge/ngraph_executable_disk_cache.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+class NGraphExecutableDiskCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(Env::Default()->LocalTempFilename(&m_cache_dir));
+    ASSERT_OK(Env::Default()->RecursivelyCreateDir(m_cache_dir));
+  }
+
+  void TearDown() override {
+    int64 undeleted_files, undeleted_dirs;
+    Env::Default()
+        ->DeleteRecursively(m_cache_dir, &undeleted_files, &undeleted_dirs)
+        .IgnoreError();
+  }
+
+  // Sets the modification time of the entry, seconds since epoch
+  void SetEntryTime(const string& key, time_t seconds) {
+    struct utimbuf times;
+    times.actime = seconds;
+    times.modtime = seconds;
+    string path = io::JoinPath(m_cache_dir, key + ".ngexec");
+    ASSERT_EQ(utime(path.c_str(), &times), 0);
+  }
+
+  string m_cache_dir;
+};
+
+// Keys only depend on the inputs, and every input changes the key
+TEST_F(NGraphExecutableDiskCacheTest, ComputeKey) {
+  string key =
+      NGraphExecutableDiskCache::ComputeKey("fingerprint", "CPU", "2,3;");
+  ASSERT_EQ(key.size(), 32);
+  ASSERT_EQ(key, NGraphExecutableDiskCache::ComputeKey("fingerprint", "CPU",
+                                                       "2,3;"));
+  ASSERT_NE(key, NGraphExecutableDiskCache::ComputeKey("fingerprint2", "CPU",
+                                                       "2,3;"));
+  ASSERT_NE(key, NGraphExecutableDiskCache::ComputeKey("fingerprint",
+                                                       "INTERPRETER", "2,3;"));
+  ASSERT_NE(key, NGraphExecutableDiskCache::ComputeKey("fingerprint", "CPU",
+                                                       "2,4;"));
+}
+
+TEST_F(NGraphExecutableDiskCacheTest, GraphFingerprint) {
+  Graph g1(OpRegistry::Global());
+  Graph g2(OpRegistry::Global());
+  ASSERT_EQ(NGraphExecutableDiskCache::GraphFingerprint(g1),
+            NGraphExecutableDiskCache::GraphFingerprint(g2));
+
+  Node* node;
+  ASSERT_OK(NodeBuilder("const", "Const")
+                .Attr("dtype", DT_FLOAT)
+                .Attr("value", Tensor(DT_FLOAT, TensorShape({2})))
+                .Finalize(&g2, &node));
+  ASSERT_NE(NGraphExecutableDiskCache::GraphFingerprint(g1),
+            NGraphExecutableDiskCache::GraphFingerprint(g2));
+}
+
+TEST_F(NGraphExecutableDiskCacheTest, WriteReadEntry) {
+  NGraphExecutableDiskCache disk_cache(m_cache_dir, 1024 * 1024);
+  string blob;
+  ASSERT_FALSE(disk_cache.ReadEntry("abc", &blob));
+
+  ASSERT_OK(disk_cache.WriteEntry("abc", "serialized executable"));
+  ASSERT_TRUE(disk_cache.ReadEntry("abc", &blob));
+  ASSERT_EQ(blob, "serialized executable");
+
+  // Overwriting an entry replaces it
+  ASSERT_OK(disk_cache.WriteEntry("abc", "another executable"));
+  ASSERT_TRUE(disk_cache.ReadEntry("abc", &blob));
+  ASSERT_EQ(blob, "another executable");
+
+  // No temporary files are left behind
+  std::vector<string> children;
+  ASSERT_OK(Env::Default()->GetChildren(m_cache_dir, &children));
+  ASSERT_EQ(children.size(), 1);
+}
+
+// An entry whose header does not match its key is treated as a miss
+TEST_F(NGraphExecutableDiskCacheTest, MalformedEntry) {
+  NGraphExecutableDiskCache disk_cache(m_cache_dir, 1024 * 1024);
+  ASSERT_OK(WriteStringToFile(Env::Default(),
+                              io::JoinPath(m_cache_dir, "abc.ngexec"),
+                              "serialized executable"));
+  string blob;
+  ASSERT_FALSE(disk_cache.ReadEntry("abc", &blob));
+
+  ASSERT_OK(disk_cache.WriteEntry("abc", "serialized executable"));
+  ASSERT_OK(
+      Env::Default()->RenameFile(io::JoinPath(m_cache_dir, "abc.ngexec"),
+                                 io::JoinPath(m_cache_dir, "def.ngexec")));
+  ASSERT_FALSE(disk_cache.ReadEntry("def", &blob));
+
+  // A miss never touches the backend
+  ASSERT_EQ(disk_cache.Load("xyz", nullptr), nullptr);
+  ASSERT_EQ(disk_cache.GetMissCount(), 1);
+  ASSERT_EQ(disk_cache.GetHitCount(), 0);
+}
+
+// The least recently used entries are evicted first
+TEST_F(NGraphExecutableDiskCacheTest, Eviction) {
+  string blob(1000, 'x');
+  // Room for two entries (plus their headers) but not three
+  NGraphExecutableDiskCache disk_cache(m_cache_dir, 2500);
+
+  ASSERT_OK(disk_cache.WriteEntry("entry1", blob));
+  ASSERT_OK(disk_cache.WriteEntry("entry2", blob));
+  ASSERT_OK(disk_cache.EvictIfNeeded());
+  ASSERT_EQ(disk_cache.GetEvictionCount(), 0);
+
+  ASSERT_OK(disk_cache.WriteEntry("entry3", blob));
+  SetEntryTime("entry1", 3000);
+  SetEntryTime("entry2", 1000);
+  SetEntryTime("entry3", 2000);
+  ASSERT_OK(disk_cache.EvictIfNeeded());
+  ASSERT_EQ(disk_cache.GetEvictionCount(), 1);
+
+  string read_blob;
+  ASSERT_TRUE(disk_cache.ReadEntry("entry1", &read_blob));
+  ASSERT_FALSE(disk_cache.ReadEntry("entry2", &read_blob));
+  ASSERT_TRUE(disk_cache.ReadEntry("entry3", &read_blob));
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
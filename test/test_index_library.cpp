@@ -15,8 +15,10 @@
  *******************************************************************************/
 
 #include <stdlib.h>
+#include <atomic>
 #include <chrono>
 #include <random>
+#include <thread>
 
 #include "gtest/gtest.h"
 
@@ -138,6 +140,122 @@ TEST(IndexLibrary, MultiThreadTest) {
   thread0.join();
   thread1.join();
 }
+TEST(IndexLibrary, MaxDepth) {
+  ASSERT_THROW(IndexLibrary{IndexLibrary::kMaxDepth + 1}, std::runtime_error);
+
+  IndexLibrary idx_lib{IndexLibrary::kMaxDepth};
+  for (int i = 0; i < IndexLibrary::kMaxDepth; i++) {
+    ASSERT_EQ(idx_lib.get_index(), i);
+  }
+  ASSERT_EQ(idx_lib.get_index(), -1);
+  idx_lib.return_index(IndexLibrary::kMaxDepth - 1);
+  ASSERT_EQ(idx_lib.get_index(), IndexLibrary::kMaxDepth - 1);
+}
+
+// The blocking get_index returns a free index right away, else waits for one
+// to be returned or times out
+TEST(IndexLibrary, WaitForIndex) {
+  IndexLibrary idx_lib{1};
+  ASSERT_EQ(idx_lib.get_index(100, nullptr), 0);
+
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(idx_lib.get_index(50, nullptr), IndexLibrary::kTimedOut);
+  ASSERT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(50));
+
+  std::thread returner([&idx_lib]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    idx_lib.return_index(0);
+  });
+  ASSERT_EQ(idx_lib.get_index(-1, nullptr), 0);
+  returner.join();
+
+  // One call did not wait, one waited till it timed out (not counted) and
+  // one waited for the index to be returned
+  auto histogram = idx_lib.get_wait_histogram();
+  ASSERT_EQ(histogram.size(), IndexLibrary::kNumWaitBuckets);
+  ASSERT_EQ(histogram[0], 1);
+  int64 total = 0;
+  for (auto count : histogram) {
+    total += count;
+  }
+  ASSERT_EQ(total, 2);
+  ASSERT_NE(idx_lib.get_wait_histogram_string(), "");
+}
+
+TEST(IndexLibrary, CancelWait) {
+  IndexLibrary idx_lib{1};
+  ASSERT_EQ(idx_lib.get_index(), 0);
+
+  CancellationManager cancellation_manager;
+  std::thread canceller([&cancellation_manager]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    cancellation_manager.StartCancel();
+  });
+  ASSERT_EQ(idx_lib.get_index(-1, &cancellation_manager),
+            IndexLibrary::kCancelled);
+  canceller.join();
+
+  // Already cancelled
+  ASSERT_EQ(idx_lib.get_index(-1, &cancellation_manager),
+            IndexLibrary::kCancelled);
+  idx_lib.return_index(0);
+  ASSERT_EQ(idx_lib.get_index(-1, nullptr), 0);
+}
+
+// A wait with a timeout ends on the cancellation, not on the timeout
+TEST(IndexLibrary, CancelTimedWait) {
+  IndexLibrary idx_lib{1};
+  ASSERT_EQ(idx_lib.get_index(), 0);
+
+  CancellationManager cancellation_manager;
+  std::thread canceller([&cancellation_manager]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    cancellation_manager.StartCancel();
+  });
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(idx_lib.get_index(60000, &cancellation_manager),
+            IndexLibrary::kCancelled);
+  ASSERT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::seconds(30));
+  canceller.join();
+}
+
+// The callers that wait for an index get it in the order they arrived
+TEST(IndexLibrary, WaitersServedInOrder) {
+  IndexLibrary idx_lib{1};
+  ASSERT_EQ(idx_lib.get_index(), 0);
+
+  const int num_waiters = 4;
+  std::atomic<int> next_to_arrive{0};
+  std::vector<int> served;
+  std::mutex served_mtx;
+  std::vector<std::thread> waiters;
+  for (int i = 0; i < num_waiters; i++) {
+    // Start the waiters one after the other
+    while (next_to_arrive != i) {
+      std::this_thread::yield();
+    }
+    waiters.emplace_back([&, i]() {
+      next_to_arrive++;
+      int idx = idx_lib.get_index(-1, nullptr);
+      ASSERT_EQ(idx, 0);
+      {
+        std::lock_guard<std::mutex> lock(served_mtx);
+        served.push_back(i);
+      }
+      idx_lib.return_index(idx);
+    });
+    // Give it time to queue up
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+
+  idx_lib.return_index(0);
+  for (auto& waiter : waiters) {
+    waiter.join();
+  }
+  ASSERT_EQ(served, std::vector<int>({0, 1, 2, 3}));
+}
 }
 }
 }
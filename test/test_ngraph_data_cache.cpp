@@ -15,7 +15,8 @@
  *******************************************************************************/
 #include <atomic>
 #include <memory>
-#include "absl/synchronization/barrier.h"
+#include <stdexcept>
+#include <thread>
 #include "gtest/gtest.h"
 #include "test/test_utilities.h"
 
@@ -40,19 +41,35 @@ class NGraphDataCacheTest : public ::testing::Test {
  protected:
   NgraphDataCache<std::string, int> m_ng_data_cache{3};
   int num_threads = 2;
-  absl::Barrier* barrier_ = new absl::Barrier(num_threads);
   std::atomic<int> create_count{0};
   int destroy_count = 0;
   bool item_evicted = false;
 
+  // Blocks till all the other threads wait for this item
+  void WaitForCoalescedWaiters() {
+    while (m_ng_data_cache.GetCoalescedWaiterCount() < num_threads - 1) {
+      std::this_thread::yield();
+    }
+  }
+
   std::pair<Status, int> CreateItem(std::string abc) {
     create_count++;
-    if (barrier_->Block()) {
-      delete barrier_;
-    }
+    WaitForCoalescedWaiters();
     return std::make_pair(Status::OK(), 3);
   }
 
+  std::pair<Status, int> CreateItemReturnErrorAfterWait(std::string abc) {
+    create_count++;
+    WaitForCoalescedWaiters();
+    return std::make_pair(errors::Internal("Failed to create item"), 0);
+  }
+
+  std::pair<Status, int> CreateItemThrowAfterWait(std::string abc) {
+    create_count++;
+    WaitForCoalescedWaiters();
+    throw std::runtime_error("Compile failed");
+  }
+
   std::pair<Status, int> CreateItemNoBarrier(std::string abc) {
     return std::make_pair(Status::OK(), 3);
   }
@@ -95,13 +112,81 @@ TEST_F(NGraphDataCacheTest, SameKeyMultiThread) {
 
   thread0.join();
   thread1.join();
-  // This is ensured by using Barrier inside CreateItem()
-  ASSERT_EQ(create_count, 2);
+  // CreateItem() does not return till the other thread waits for it, so the
+  // item is created only once
+  ASSERT_EQ(create_count, 1);
+  ASSERT_GE(m_ng_data_cache.GetCoalescedWaiterCount(), 1);
   ASSERT_EQ(m_ng_data_cache.m_ng_items_map.size(), 1);
   ASSERT_EQ(m_ng_data_cache.m_ng_items_map.find("def"),
             m_ng_data_cache.m_ng_items_map.end());
 }
 
+// Tests that an error in creating an item is seen by all the threads waiting
+// for it, and that the item is not cached
+TEST_F(NGraphDataCacheTest, SameKeyMultiThreadError) {
+  auto worker = [&](size_t thread_id) {
+    auto create_item_ret_err = std::bind(
+        &NGraphDataCacheTest_SameKeyMultiThreadError_Test::
+            CreateItemReturnErrorAfterWait,
+        this, std::placeholders::_1);
+    bool cache_hit;
+    auto status_item =
+        m_ng_data_cache.LookUpOrCreate("abc", create_item_ret_err, cache_hit);
+    ASSERT_NOT_OK(status_item.first);
+    ASSERT_EQ(status_item.first.error_message(), "Failed to create item");
+    ASSERT_EQ(cache_hit, false);
+  };
+
+  std::thread thread0(worker, 0);
+  std::thread thread1(worker, 1);
+
+  thread0.join();
+  thread1.join();
+  ASSERT_EQ(create_count, 1);
+  ASSERT_EQ(m_ng_data_cache.GetCoalescedWaiterCount(), 1);
+
+  // A failed item is not remembered, the next lookup tries to create it again
+  auto create_item = std::bind(
+      &NGraphDataCacheTest_SameKeyMultiThreadError_Test::CreateItemNoBarrier,
+      this, std::placeholders::_1);
+  bool cache_hit;
+  ASSERT_OK(
+      m_ng_data_cache.LookUpOrCreate("abc", create_item, cache_hit).first);
+  ASSERT_EQ(cache_hit, false);
+}
+
+// An exception thrown by the creation is an error for the waiting threads
+// too, and the key is not left in flight
+TEST_F(NGraphDataCacheTest, SameKeyMultiThreadThrows) {
+  auto worker = [&](size_t thread_id) {
+    auto create_item_throw = std::bind(
+        &NGraphDataCacheTest_SameKeyMultiThreadThrows_Test::
+            CreateItemThrowAfterWait,
+        this, std::placeholders::_1);
+    bool cache_hit;
+    auto status_item =
+        m_ng_data_cache.LookUpOrCreate("abc", create_item_throw, cache_hit);
+    ASSERT_NOT_OK(status_item.first);
+    ASSERT_EQ(cache_hit, false);
+  };
+
+  std::thread thread0(worker, 0);
+  std::thread thread1(worker, 1);
+
+  thread0.join();
+  thread1.join();
+  ASSERT_EQ(create_count, 1);
+  ASSERT_EQ(m_ng_data_cache.GetCoalescedWaiterCount(), 1);
+
+  auto create_item = std::bind(
+      &NGraphDataCacheTest_SameKeyMultiThreadThrows_Test::CreateItemNoBarrier,
+      this, std::placeholders::_1);
+  bool cache_hit;
+  ASSERT_OK(
+      m_ng_data_cache.LookUpOrCreate("abc", create_item, cache_hit).first);
+  ASSERT_EQ(cache_hit, false);
+}
+
 // Testing to ensure destoy called back is called, when cache is full.
 TEST_F(NGraphDataCacheTest, TestItemEviction) {
   auto create_item =
@@ -160,6 +245,22 @@ TEST_F(NGraphDataCacheTest, RemoveItemTest) {
   ASSERT_EQ(destroy_count, 1);
   ASSERT_EQ(m_ng_data_cache.m_ng_items_map.size(), 0);
 }
+
+// LookUp() finds the items created by LookUpOrCreate() but never creates one
+TEST_F(NGraphDataCacheTest, LookUpDoesNotCreate) {
+  auto create_item = std::bind(
+      &NGraphDataCacheTest_LookUpDoesNotCreate_Test::CreateItemNoBarrier, this,
+      std::placeholders::_1);
+  int item = 0;
+  ASSERT_FALSE(m_ng_data_cache.LookUp("abc", item));
+  ASSERT_EQ(m_ng_data_cache.m_ng_items_map.size(), 0);
+  bool cache_hit;
+  ASSERT_OK(
+      m_ng_data_cache.LookUpOrCreate("abc", create_item, cache_hit).first);
+  ASSERT_TRUE(m_ng_data_cache.LookUp("abc", item));
+  ASSERT_EQ(item, 3);
+  ASSERT_FALSE(m_ng_data_cache.LookUp("def", item));
+}
 }
 }
 }
@@ -15,6 +15,7 @@
  *******************************************************************************/
 #include "gtest/gtest.h"
 
+#include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/graph/algorithm.h"
@@ -23,6 +24,7 @@
 #include "tensorflow/core/platform/env.h"
 
 #include "ngraph_bridge/ngraph_builder.h"
+#include "ngraph_bridge/ngraph_cache_budget.h"
 #include "ngraph_bridge/ngraph_pipelined_tensors.h"
 #include "ngraph_bridge/ngraph_utils.h"
 
@@ -55,12 +57,14 @@ class NGraphExecTest : public ::testing::Test {
   // Translates the TFGraph into NGFunction assumes no static inputs
   Status TranslateTFGraphNoStatic(const vector<TensorShape>& tf_input_shapes,
                                   const Graph& input_graph,
-                                  shared_ptr<ngraph::Function>& ng_function) {
+                                  shared_ptr<ngraph::Function>& ng_function,
+                                  NGraphConstantPool* constant_pool = nullptr) {
     // Translate the Graph: Create ng_function
     std::vector<const Tensor*> static_input_map(tf_input_shapes.size(),
                                                 nullptr);
     TF_RETURN_IF_ERROR(ngraph_bridge::Builder::TranslateGraph(
-        tf_input_shapes, static_input_map, &input_graph, ng_function));
+        tf_input_shapes, static_input_map, &input_graph, ng_function,
+        constant_pool));
     return Status::OK();
   }
 
@@ -524,6 +528,127 @@ TEST_F(NGraphExecTest, FindNumberOfNodesUtil2) {
   ASSERT_EQ(number_of_sub, 1);
 }
 
+// The function is serialized on demand, for as long as it is alive
+TEST_F(NGraphExecTest, FunctionRef) {
+  Graph input_graph(OpRegistry::Global());
+  ASSERT_OK(LoadGraph("test_axpy_launchop.pbtxt", &input_graph));
+
+  std::vector<TensorShape> input_shapes{TensorShape({2, 3}),
+                                        TensorShape({2, 3})};
+  shared_ptr<ng::Function> ng_function;
+  ASSERT_OK(TranslateTFGraphNoStatic(input_shapes, input_graph, ng_function));
+
+  NGraphFunctionRef ng_function_ref(ng_function);
+  string serialized;
+  ASSERT_OK(ng_function_ref.Serialize(serialized));
+  ASSERT_EQ(serialized, ngraph::serialize(ng_function, 4));
+
+  // The reference does not keep the function alive
+  ng_function.reset();
+  ASSERT_NOT_OK(ng_function_ref.Serialize(serialized));
+
+  // An already serialized function keeps its JSON
+  NGraphFunctionRef aot_function_ref("{}");
+  ASSERT_OK(aot_function_ref.Serialize(serialized));
+  ASSERT_EQ(serialized, "{}");
+}
+
+// Functions translated on the same pool build their Constants on the
+// values parsed by the first translation
+TEST_F(NGraphExecTest, ConstantPool) {
+  Graph input_graph(OpRegistry::Global());
+  ASSERT_OK(LoadGraph("test_axpy_launchop.pbtxt", &input_graph));
+
+  std::vector<TensorShape> input_shapes{TensorShape({2, 3}),
+                                        TensorShape({2, 3})};
+  int64 charged_bytes = NGraphCacheBudget::GetChargedBytes();
+  int64 shared_bytes = NGraphCacheBudget::GetSharedBytes();
+  auto constant_pool = std::make_shared<NGraphConstantPool>();
+  shared_ptr<ng::Function> ng_function1, ng_function2;
+  ASSERT_OK(TranslateTFGraphNoStatic(input_shapes, input_graph, ng_function1,
+                                     constant_pool.get()));
+  if (!Builder::CanPoolConstants()) {
+    // The Constants would copy the values, the pool is not used
+    ASSERT_EQ(constant_pool->Size(), 0);
+    return;
+  }
+  ASSERT_EQ(constant_pool->Size(), 1);
+  ASSERT_EQ(constant_pool->GetBytes(), 6 * sizeof(float));
+  ASSERT_OK(TranslateTFGraphNoStatic(input_shapes, input_graph, ng_function2,
+                                     constant_pool.get()));
+  ASSERT_EQ(constant_pool->Size(), 1);
+
+  // The pooled bytes are reported once, till the pool goes away, and are
+  // not part of the evictable bytes of the budget
+  ASSERT_EQ(NGraphCacheBudget::GetSharedBytes(),
+            shared_bytes + 6 * sizeof(float));
+  ASSERT_EQ(NGraphCacheBudget::GetChargedBytes(), charged_bytes);
+
+  // The Constants reference the pooled value instead of a copy of it
+  Tensor pooled_value;
+  for (const Node* node : input_graph.op_nodes()) {
+    if (node->IsConstant()) {
+      ASSERT_OK(constant_pool->GetTensor(node, pooled_value));
+    }
+  }
+  for (const auto& ng_function : {ng_function1, ng_function2}) {
+    int num_constants = 0;
+    for (const auto& node : ng_function->get_ops()) {
+      auto ng_constant = std::dynamic_pointer_cast<ng::op::Constant>(node);
+      if (ng_constant == nullptr) {
+        continue;
+      }
+      num_constants++;
+      ASSERT_EQ(ng_constant->get_data_ptr(), DMAHelper::base(&pooled_value));
+      ASSERT_EQ(ng_constant->get_vector<float>(),
+                std::vector<float>(6, 5.0f));
+    }
+    ASSERT_EQ(num_constants, 1);
+    // The executable is not charged for them
+    ASSERT_EQ(EstimateExecutableBytes(ng_function, nullptr) -
+                  EstimateExecutableBytes(ng_function, constant_pool.get()),
+              6 * sizeof(float));
+  }
+
+  // They keep the value alive after the pool goes away
+  constant_pool.reset();
+  ASSERT_EQ(NGraphCacheBudget::GetSharedBytes(), shared_bytes);
+  for (const auto& node : ng_function1->get_ops()) {
+    auto ng_constant = std::dynamic_pointer_cast<ng::op::Constant>(node);
+    if (ng_constant != nullptr) {
+      ASSERT_EQ(ng_constant->get_vector<float>(),
+                std::vector<float>(6, 5.0f));
+    }
+  }
+}
+
+// A translation with a plan builds the same function as one without
+TEST_F(NGraphExecTest, TranslationPlan) {
+  Graph input_graph(OpRegistry::Global());
+  ASSERT_OK(LoadGraph("test_axpy_launchop.pbtxt", &input_graph));
+
+  std::vector<TensorShape> input_shapes{TensorShape({2, 3}),
+                                        TensorShape({2, 3})};
+  std::vector<const Tensor*> static_input_map(input_shapes.size(), nullptr);
+  Builder::TranslationPlan plan;
+  ASSERT_FALSE(plan.IsBuilt());
+
+  shared_ptr<ng::Function> ng_function, ng_function_planned;
+  ASSERT_OK(TranslateTFGraphNoStatic(input_shapes, input_graph, ng_function));
+  for (int i = 0; i < 2; i++) {
+    ASSERT_OK(Builder::TranslateGraph(input_shapes, static_input_map,
+                                      &input_graph, ng_function_planned,
+                                      nullptr, &plan));
+    ASSERT_TRUE(plan.IsBuilt());
+    ASSERT_EQ(ng_function_planned->get_parameters().size(),
+              ng_function->get_parameters().size());
+    ASSERT_EQ(ng_function_planned->get_results().size(),
+              ng_function->get_results().size());
+    ASSERT_EQ(ng_function_planned->get_ops().size(),
+              ng_function->get_ops().size());
+  }
+}
+
 }  // namespace testing
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
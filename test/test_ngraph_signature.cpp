@@ -0,0 +1,125 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <unordered_map>
+
+#include "gtest/gtest.h"
+#include "test/test_utilities.h"
+
+#include "ngraph_bridge/ngraph_signature.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+TEST(NGraphSignatureTest, ShapesAndStaticInputs) {
+  Tensor x(DT_FLOAT, TensorShape({2, 3}));
+  Tensor shape(DT_INT32, TensorShape({2}));
+  AssignInputValues(x, 1.0f);
+  AssignInputValues<int32>(shape, {3, 2});
+  std::vector<bool> input_is_static{false, true};
+
+  NGraphSignature signature;
+  ASSERT_OK(NGraphSignature::Compute({x, shape}, input_is_static, signature));
+  ASSERT_EQ(signature.ToString().size(), 32);
+
+  // The values of the non static inputs are not part of the signature
+  Tensor x2(DT_FLOAT, TensorShape({2, 3}));
+  AssignInputValues(x2, 5.0f);
+  NGraphSignature same_signature;
+  ASSERT_OK(
+      NGraphSignature::Compute({x2, shape}, input_is_static, same_signature));
+  ASSERT_EQ(signature, same_signature);
+  ASSERT_EQ(signature.ToString(), same_signature.ToString());
+
+  // Shapes, dtypes and the values of the static inputs are
+  Tensor x3(DT_FLOAT, TensorShape({3, 2}));
+  NGraphSignature shape_signature;
+  ASSERT_OK(
+      NGraphSignature::Compute({x3, shape}, input_is_static, shape_signature));
+  ASSERT_NE(signature, shape_signature);
+
+  Tensor x4(DT_INT32, TensorShape({2, 3}));
+  NGraphSignature dtype_signature;
+  ASSERT_OK(
+      NGraphSignature::Compute({x4, shape}, input_is_static, dtype_signature));
+  ASSERT_NE(signature, dtype_signature);
+
+  Tensor shape2(DT_INT32, TensorShape({2}));
+  AssignInputValues<int32>(shape2, {6, 1});
+  NGraphSignature static_signature;
+  ASSERT_OK(
+      NGraphSignature::Compute({x, shape2}, input_is_static, static_signature));
+  ASSERT_NE(signature, static_signature);
+}
+
+// The signature of dtypes and shapes is the one of tensors of these
+TEST(NGraphSignatureTest, DtypesAndShapes) {
+  Tensor x(DT_FLOAT, TensorShape({2, 3}));
+  Tensor y(DT_INT32, TensorShape({4}));
+  NGraphSignature signature;
+  ASSERT_OK(NGraphSignature::Compute({x, y}, {false, false}, signature));
+
+  NGraphSignature shape_signature;
+  ASSERT_OK(NGraphSignature::Compute({DT_FLOAT, DT_INT32},
+                                     {x.shape(), y.shape()}, shape_signature));
+  ASSERT_EQ(signature, shape_signature);
+  ASSERT_EQ(signature.ToString(), shape_signature.ToString());
+
+  ASSERT_NOT_OK(
+      NGraphSignature::Compute({DT_FLOAT}, {x.shape(), y.shape()}, signature));
+}
+
+// Equal hashes of different inputs are told apart by the full comparison
+TEST(NGraphSignatureTest, Collision) {
+  Tensor x(DT_FLOAT, TensorShape({2, 3}));
+  Tensor y(DT_FLOAT, TensorShape({4}));
+  std::vector<bool> input_is_static{false};
+
+  NGraphSignature signature_x, signature_y;
+  ASSERT_OK(NGraphSignature::Compute({x}, input_is_static, signature_x));
+  ASSERT_OK(NGraphSignature::Compute({y}, input_is_static, signature_y));
+  signature_y.m_low = signature_x.m_low;
+  signature_y.m_high = signature_x.m_high;
+
+  int64 collisions = NGraphSignature::GetCollisionCount();
+  ASSERT_NE(signature_x, signature_y);
+  ASSERT_EQ(NGraphSignature::GetCollisionCount(), collisions + 1);
+
+  std::unordered_map<NGraphSignature, int> cache;
+  cache[signature_x] = 1;
+  cache[signature_y] = 2;
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_EQ(cache[signature_x], 1);
+  ASSERT_EQ(cache[signature_y], 2);
+}
+
+TEST(NGraphSignatureTest, TextSignature) {
+  Tensor shape(DT_INT32, TensorShape({2}));
+  AssignInputValues<int32>(shape, {3, 2});
+  std::vector<TensorShape> input_shapes{TensorShape({2, 3}), shape.shape()};
+  std::vector<const Tensor*> static_input_map{nullptr, &shape};
+
+  string text_signature;
+  ASSERT_OK(ComputeTextSignature(input_shapes, static_input_map,
+                                 text_signature));
+  ASSERT_EQ(text_signature, "2,3,;2,;/3,2,;");
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
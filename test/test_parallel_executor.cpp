@@ -16,8 +16,10 @@
 #include "gtest/gtest.h"
 
 #include <memory>
+#include <thread>
 
 #include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/public/session.h"
 
@@ -82,6 +84,29 @@ TEST(ParallelExecutor, Construction) {
   // TODO: Create a Test Class and mark that as a friend of the Executor class
   ASSERT_EQ(executor->GetOpBackendName(), "INTERPRETER");
   ASSERT_TRUE(executor->IsTensorPipeliningSupported());
+  ASSERT_FALSE(executor->IsZeroCopyOutputEnabled());
+}
+
+// The outputs are computed in place in the TF tensors on CPU only
+TEST(ParallelExecutor, ZeroCopyOutput) {
+  list<string> env_vars{"NGRAPH_TF_DISABLE_ZERO_COPY_OUTPUTS"};
+  const unordered_map<string, string>& env_map = StoreEnv(env_vars);
+  tf::ngraph_bridge::BackendManager::CreateBackend("CPU");
+
+  unique_ptr<tf::Graph> input_graph;
+  ASSERT_OK(LoadGraphFromPbTxt("test_axpy_launchop.pbtxt", input_graph));
+  NGraphExecutor executor(100, 500, 600, input_graph, "CPU", "xyz_500", 16);
+  ASSERT_TRUE(executor.IsZeroCopyOutputEnabled());
+
+  SetEnvVariable("NGRAPH_TF_DISABLE_ZERO_COPY_OUTPUTS", "1");
+  ASSERT_OK(LoadGraphFromPbTxt("test_axpy_launchop.pbtxt", input_graph));
+  NGraphExecutor executor_with_copy(101, 500, 600, input_graph, "CPU",
+                                    "xyz_500", 16);
+  ASSERT_FALSE(executor_with_copy.IsZeroCopyOutputEnabled());
+
+  UnsetEnvVariable("NGRAPH_TF_DISABLE_ZERO_COPY_OUTPUTS");
+  RestoreEnv(env_map);
+  tf::ngraph_bridge::BackendManager::ReleaseBackend("CPU");
 }
 
 TEST(ParallelExecutor, CompilerTest) {
@@ -113,19 +138,49 @@ TEST(ParallelExecutor, CompilerTest) {
   std::vector<Tensor> tf_input_tensors{x, y};
   shared_ptr<ngraph::runtime::Executable> ng_exec;
   shared_ptr<PipelinedTensorsStore> pts;
-  std::string ser_ng_function;
+  NGraphFunctionRef ng_function_ref;
   // Call the Executor to compile the funcion
   bool cache_hit = false;
   ASSERT_OK(executor.GetExecutableFunctionAndTensors(
-      tf_input_tensors, ng_exec, ser_ng_function, pts, cache_hit));
+      tf_input_tensors, ng_exec, ng_function_ref, pts, cache_hit));
   ASSERT_FALSE(cache_hit);
 
   // Now call again to test that the cache works
   ASSERT_OK(executor.GetExecutableFunctionAndTensors(
-      tf_input_tensors, ng_exec, ser_ng_function, pts, cache_hit));
+      tf_input_tensors, ng_exec, ng_function_ref, pts, cache_hit));
   ASSERT_TRUE(cache_hit);
 }
 
+// The executable compiled by the warm-up is found by the first step
+TEST(ParallelExecutor, WarmUp) {
+  unique_ptr<tf::Graph> input_graph;
+  ASSERT_OK(LoadGraphFromPbTxt("test_axpy_launchop.pbtxt", input_graph));
+
+  tf::ngraph_bridge::BackendManager::CreateBackend("INTERPRETER");
+  NGraphExecutor executor(100, 500, 600, input_graph, "INTERPRETER", "xyz_500",
+                          10);
+
+  ASSERT_NOT_OK(executor.WarmUp({TensorShape({2, 3})}));
+  ASSERT_OK(executor.WarmUp({TensorShape({2, 3}), TensorShape({2, 3})}));
+  while (NGraphExecutor::GetCompileQueueDepth() > 0) {
+    std::this_thread::yield();
+  }
+
+  Tensor x(DT_FLOAT, TensorShape({2, 3}));
+  Tensor y(DT_FLOAT, TensorShape({2, 3}));
+  AssignInputValues(x, 1.0f);
+  AssignInputValues(y, 1.0f);
+  std::vector<Tensor> tf_input_tensors{x, y};
+  shared_ptr<ngraph::runtime::Executable> ng_exec;
+  shared_ptr<PipelinedTensorsStore> pts;
+  NGraphFunctionRef ng_function_ref;
+  bool cache_hit = false;
+  ASSERT_OK(executor.GetExecutableFunctionAndTensors(
+      tf_input_tensors, ng_exec, ng_function_ref, pts, cache_hit));
+  ASSERT_TRUE(cache_hit);
+  ASSERT_NE(ng_exec, nullptr);
+}
+
 TEST(ParallelExecutor, ExecuteOnSingleThread) {
   // Read the graph
   // We are using a graph with _Arg and _Retval
@@ -147,9 +202,9 @@ TEST(ParallelExecutor, ExecuteOnSingleThread) {
   std::tuple<int, PipelinedTensorVector, PipelinedTensorVector> io_tensors;
   // Call the Executor to compile the funcion
   bool cache_hit = false;
-  std::string ser_ng_func;
+  NGraphFunctionRef ng_function_ref;
   ASSERT_OK(executor.GetExecutableFunctionAndTensors(
-      tf_input_tensors, ng_exec, ser_ng_func, pts, cache_hit));
+      tf_input_tensors, ng_exec, ng_function_ref, pts, cache_hit));
   io_tensors = pts.get()->get_tensors();
   ASSERT_FALSE(cache_hit);
 
@@ -230,9 +285,9 @@ TEST(ParallelExecutor, ExecuteOnSingleThread8Bit) {
   std::tuple<int, PipelinedTensorVector, PipelinedTensorVector> io_tensors;
   // Call the Executor to compile the funcion
   bool cache_hit = false;
-  std::string ser_ng_func;
+  NGraphFunctionRef ng_function_ref;
   ASSERT_OK(executor.GetExecutableFunctionAndTensors(
-      tf_input_tensors, ng_exec, ser_ng_func, pts, cache_hit));
+      tf_input_tensors, ng_exec, ng_function_ref, pts, cache_hit));
   io_tensors = pts.get()->get_tensors();
   ASSERT_FALSE(cache_hit);
 
@@ -319,9 +374,9 @@ TEST(ParallelExecutor, ExecuteOnMultipleThreads8Bit) {
   std::tuple<int, PipelinedTensorVector, PipelinedTensorVector> io_tensors;
 
   bool cache_hit = false;
-  std::string ser_ng_func;
+  NGraphFunctionRef ng_function_ref;
   ASSERT_OK(executor.GetExecutableFunctionAndTensors(
-      tf_input_tensors, ng_exec, ser_ng_func, pts, cache_hit));
+      tf_input_tensors, ng_exec, ng_function_ref, pts, cache_hit));
   io_tensors = pts.get()->get_tensors();
   ASSERT_FALSE(cache_hit);
   ;
@@ -401,7 +456,7 @@ TEST(ParallelExecutor, ExecuteOnMultipleThreads) {
   std::tuple<int, PipelinedTensorVector, PipelinedTensorVector> io_tensors;
 
   bool cache_hit = false;
-  std::string ser_ng_func;
+  NGraphFunctionRef ng_function_ref;
 
   // Now Fill in the tensor - X
   auto x_flat = x.flat<float>();
@@ -415,7 +470,7 @@ TEST(ParallelExecutor, ExecuteOnMultipleThreads) {
   auto worker = [&](size_t worker_id) {
 
     ASSERT_OK(executor.GetExecutableFunctionAndTensors(
-        tf_input_tensors, ng_exec, ser_ng_func, pts, cache_hit));
+        tf_input_tensors, ng_exec, ng_function_ref, pts, cache_hit));
     io_tensors = pts.get()->get_tensors();
     ASSERT_FALSE(cache_hit);
 
@@ -528,6 +583,68 @@ TEST(ParallelExecutor, E2E8Bit) {
   session->Close();
 }
 
+// The _ngraph_pipeline_depth attribute sets the number of pipeline groups.
+// With more threads than groups, a thread that finds no free group waits for
+// one, and every step still gets its own tensors.
+TEST(ParallelExecutor, PipelineDepth) {
+  const int num_threads = 4;
+  const int steps_per_thread = 25;
+  const int depth = 3;
+  tf::ngraph_bridge::BackendManager::CreateBackend("INTERPRETER");
+
+  unique_ptr<tf::Graph> input_graph;
+  ASSERT_OK(LoadGraphFromPbTxt("test_axpy_launchop.pbtxt", input_graph));
+  NGraphExecutor executor(100, 500, 600, input_graph, "INTERPRETER",
+                          "xyz_500", 16);
+
+  google::protobuf::Map<string, AttrValue> attrs;
+  attrs["_ngraph_pipeline_depth"].set_s(to_string(depth));
+  std::unordered_map<std::string, std::string> additional_attribute_map;
+  ASSERT_OK(executor.ParseNodeAttributes(attrs, &additional_attribute_map));
+  ASSERT_TRUE(additional_attribute_map.empty());
+  ASSERT_EQ(executor.GetTensorPipelineDepth(), depth);
+
+  Tensor x(DT_FLOAT, TensorShape({2, 3}));
+  Tensor y(DT_FLOAT, TensorShape({2, 3}));
+  AssignInputValues(x, 1.0f);
+  AssignInputValues(y, 1.0f);
+  std::vector<Tensor> tf_input_tensors{x, y};
+  shared_ptr<ngraph::runtime::Executable> ng_exec;
+  shared_ptr<PipelinedTensorsStore> pts;
+  NGraphFunctionRef ng_function_ref;
+  bool cache_hit = false;
+  ASSERT_OK(executor.GetExecutableFunctionAndTensors(
+      tf_input_tensors, ng_exec, ng_function_ref, pts, cache_hit));
+  ASSERT_EQ(pts->get_depth(), depth);
+
+  auto worker = [&]() {
+    for (int step = 0; step < steps_per_thread; step++) {
+      auto io_tensors = pts->get_tensors(10000, nullptr);
+      ASSERT_GE(get<0>(io_tensors), 0) << "No free group after 10 s";
+      get<1>(io_tensors)[0]->write(DMAHelper::base(&x), x.TotalBytes());
+      get<1>(io_tensors)[1]->write(DMAHelper::base(&y), y.TotalBytes());
+      ng_exec->call(get<2>(io_tensors), get<1>(io_tensors));
+
+      Tensor tf_output_tensor(DT_FLOAT, TensorShape({2, 3}));
+      get<2>(io_tensors)[0]->read(DMAHelper::base(&tf_output_tensor),
+                                  tf_output_tensor.TotalBytes());
+      pts->return_tensors(get<0>(io_tensors));
+
+      Tensor expected_val(DT_FLOAT, TensorShape({2, 3}));
+      AssignInputValues(expected_val, 6.0f);
+      Compare(tf_output_tensor, expected_val, 0.0f);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back(worker);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 }  // namespace testing
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
@@ -40,6 +40,37 @@ TEST(PipelinedTensorStoreTest, SimpleTest) {
                std::runtime_error);
 }
 
+// All the depth groups can be checked out at once, and are reused once
+// returned
+TEST(PipelinedTensorStoreTest, DepthN) {
+  for (int depth : {1, 2, 3, 4}) {
+    PipelinedTensorMatrix pipelined_input_tensors(depth);
+    PipelinedTensorMatrix pipelined_output_tensors(depth);
+    PipelinedTensorsStore pts(pipelined_input_tensors,
+                              pipelined_output_tensors);
+    ASSERT_EQ(pts.get_depth(), depth);
+
+    set<int> checked_out;
+    for (int i = 0; i < depth; i++) {
+      int id = get<0>(pts.get_tensors());
+      ASSERT_GE(id, 0);
+      ASSERT_LT(id, depth);
+      ASSERT_TRUE(checked_out.insert(id).second);
+    }
+    ASSERT_EQ(get<0>(pts.get_tensors()), -1);
+
+    pts.return_tensors(depth - 1);
+    ASSERT_EQ(get<0>(pts.get_tensors()), depth - 1);
+    ASSERT_EQ(get<0>(pts.get_tensors()), -1);
+
+    for (int id : checked_out) {
+      pts.return_tensors(id);
+    }
+    ASSERT_THROW(pts.return_tensors(0), std::runtime_error);
+    ASSERT_EQ(get<0>(pts.get_tensors()), 0);
+  }
+}
+
 }  // namespace testing
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
\ No newline at end of file
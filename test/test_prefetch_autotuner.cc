@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include "gtest/gtest.h"
+
+#include "ngraph_bridge/prefetch_autotuner.h"
+
+using namespace std;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+namespace testing {
+
+using data::PrefetchAutotuner;
+
+// Grows an autotuned buffer to 8 elements, and completes the window
+static void GrowToEight(PrefetchAutotuner& tuner) {
+  for (size_t size : {1, 0, 2, 0, 4, 0}) {
+    tuner.RecordConsumption(size);
+  }
+  ASSERT_EQ(tuner.buffer_limit(), 8);
+  ASSERT_EQ(tuner.last_decision(), PrefetchAutotuner::Decision::kGrow);
+  for (int64 i = 6; i < PrefetchAutotuner::kWindowSize; i++) {
+    tuner.RecordConsumption(8);
+  }
+  ASSERT_EQ(tuner.buffer_limit(), 8);
+}
+
+TEST(PrefetchAutotuner, Disabled) {
+  PrefetchAutotuner tuner(5);
+  tuner.RecordElementBytes(1000);
+  tuner.RecordProducerIdle(100);
+  for (int64 i = 0; i < PrefetchAutotuner::kWindowSize; i++) {
+    tuner.RecordConsumption(5);
+    tuner.RecordEmpty();
+  }
+  ASSERT_EQ(tuner.buffer_limit(), 5);
+  ASSERT_EQ(tuner.last_decision(), PrefetchAutotuner::Decision::kNone);
+}
+
+// The elements that stayed in the buffer for a window are given back, when
+// the producer waited for slots and the consumer never waited
+TEST(PrefetchAutotuner, Shrinks) {
+  PrefetchAutotuner tuner(PrefetchAutotuner::kAutoTune);
+  ASSERT_EQ(tuner.buffer_limit(), 1);
+  GrowToEight(tuner);
+
+  tuner.RecordProducerIdle(100);
+  for (int64 i = 0; i < PrefetchAutotuner::kWindowSize; i++) {
+    tuner.RecordConsumption(8);
+  }
+  // 7 elements were never needed, half of them are given back
+  ASSERT_EQ(tuner.buffer_limit(), 4);
+  ASSERT_EQ(tuner.last_decision(), PrefetchAutotuner::Decision::kShrink);
+  ASSERT_EQ(tuner.window_producer_idle_us(), 100);
+  ASSERT_EQ(tuner.window_consumer_wait_us(), 0);
+
+  // The buffer drains to the new limit, then grows again if it empties
+  for (size_t size : {7, 6, 5, 4, 0}) {
+    tuner.RecordConsumption(size);
+  }
+  ASSERT_EQ(tuner.buffer_limit(), 8);
+  ASSERT_EQ(tuner.last_decision(), PrefetchAutotuner::Decision::kGrow);
+}
+
+TEST(PrefetchAutotuner, KeptWhenConsumerWaits) {
+  PrefetchAutotuner tuner(PrefetchAutotuner::kAutoTune);
+  GrowToEight(tuner);
+
+  tuner.RecordProducerIdle(100);
+  tuner.RecordConsumerWait(10);
+  for (int64 i = 0; i < PrefetchAutotuner::kWindowSize; i++) {
+    tuner.RecordConsumption(8);
+  }
+  ASSERT_EQ(tuner.buffer_limit(), 8);
+  ASSERT_EQ(tuner.window_consumer_wait_us(), 10);
+}
+
+TEST(PrefetchAutotuner, MemoryBudget) {
+  PrefetchAutotuner tuner(PrefetchAutotuner::kAutoTune, 1000);
+  tuner.RecordElementBytes(300);
+  ASSERT_EQ(tuner.element_bytes(), 300);
+  for (size_t size : {1, 0, 2, 0}) {
+    tuner.RecordConsumption(size);
+  }
+  // 4 elements would take 1200 bytes
+  ASSERT_EQ(tuner.buffer_limit(), 3);
+  ASSERT_EQ(tuner.last_decision(), PrefetchAutotuner::Decision::kBudget);
+
+  // Larger elements shrink the buffer
+  for (int i = 0; i < 20; i++) {
+    tuner.RecordElementBytes(600);
+  }
+  ASSERT_EQ(tuner.buffer_limit(), 1);
+}
+
+// The device slots are taken off the budget once, not per element
+TEST(PrefetchAutotuner, SlotBytes) {
+  PrefetchAutotuner tuner(PrefetchAutotuner::kAutoTune, 1000);
+  tuner.RecordSlotBytes(400);
+  tuner.RecordElementBytes(100);
+  ASSERT_EQ(tuner.slot_bytes(), 400);
+  for (size_t size : {1, 0, 2, 0, 4, 0}) {
+    tuner.RecordConsumption(size);
+  }
+  // 8 elements would take 800 bytes of the 600 left by the slots
+  ASSERT_EQ(tuner.buffer_limit(), 6);
+  ASSERT_EQ(tuner.last_decision(), PrefetchAutotuner::Decision::kBudget);
+}
+
+}  // namespace testing
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
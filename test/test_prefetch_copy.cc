@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include "gtest/gtest.h"
+
+#include "ngraph/runtime/host_tensor.hpp"
+
+#include "ngraph_bridge/ngraph_prefetch_copy.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+namespace ng = ngraph;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+namespace testing {
+
+// Inputs smaller and larger than a chunk are all copied
+TEST(PrefetchCopy, CopiesInputs) {
+  size_t chunk_elements = NGraphPrefetchCopier::GetChunkBytes() / 4;
+  vector<size_t> sizes{1, 100, chunk_elements, 5 * chunk_elements + 3};
+
+  vector<vector<int32>> inputs;
+  vector<NGraphPrefetchCopy> copies;
+  for (size_t size : sizes) {
+    vector<int32> input(size);
+    for (size_t i = 0; i < size; i++) {
+      input[i] = i * 7 + size;
+    }
+    inputs.push_back(input);
+  }
+  for (const auto& input : inputs) {
+    NGraphPrefetchCopy copy;
+    copy.src = input.data();
+    copy.bytes = input.size() * 4;
+    copy.dst = make_shared<ng::runtime::HostTensor>(ng::element::i32,
+                                                    ng::Shape{input.size()});
+    copies.push_back(copy);
+  }
+
+  ASSERT_OK(NGraphPrefetchCopier::Copy(&copies));
+  for (size_t i = 0; i < copies.size(); i++) {
+    vector<int32> output(inputs[i].size());
+    copies[i].dst->read(output.data(), output.size() * 4);
+    ASSERT_EQ(output, inputs[i]);
+    ASSERT_GE(copies[i].elapsed_us, 0);
+  }
+}
+
+TEST(PrefetchCopy, InputTooLarge) {
+  vector<int32> input(10);
+  vector<NGraphPrefetchCopy> copies(1);
+  copies[0].src = input.data();
+  copies[0].bytes = input.size() * 4;
+  copies[0].dst =
+      make_shared<ng::runtime::HostTensor>(ng::element::i32, ng::Shape{5});
+  ASSERT_NOT_OK(NGraphPrefetchCopier::Copy(&copies));
+}
+
+// A shorter input (e.g. the last batch) would leave the end of the tensor
+// stale, and reading the full tensor size would read past the input
+TEST(PrefetchCopy, InputTooSmall) {
+  vector<int32> input(5);
+  vector<NGraphPrefetchCopy> copies(1);
+  copies[0].src = input.data();
+  copies[0].bytes = input.size() * 4;
+  copies[0].dst =
+      make_shared<ng::runtime::HostTensor>(ng::element::i32, ng::Shape{10});
+  Status status = NGraphPrefetchCopier::Copy(&copies);
+  ASSERT_EQ(status.code(), error::INVALID_ARGUMENT);
+}
+
+TEST(PrefetchCopy, NoInputs) {
+  vector<NGraphPrefetchCopy> copies;
+  ASSERT_OK(NGraphPrefetchCopier::Copy(&copies));
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include "gtest/gtest.h"
+
+#include "tensorflow/core/platform/env.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_runtime_config.h"
+#include "ngraph_bridge/ngraph_utils.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+namespace testing {
+
+static const list<string> kRuntimeEnvVars{
+    "NGRAPH_TF_VLOG_LEVEL",
+    "NGRAPH_TF_USE_PREFETCH",
+    "NGRAPH_ENABLE_SERIALIZE",
+    "NGRAPH_TF_FUNCTION_CACHE_ITEM_DEPTH",
+    "NGRAPH_TF_PIPELINE_WAIT_TIMEOUT_MS",
+    "NGRAPH_TF_LOG_TENSOR_COPIES"};
+
+static void UnsetRuntimeEnv() {
+  for (const auto& env_var : kRuntimeEnvVars) {
+    UnsetEnvVariable(env_var);
+  }
+}
+
+TEST(RuntimeConfig, Reload) {
+  const unordered_map<string, string>& env_map = StoreEnv(kRuntimeEnvVars);
+  UnsetRuntimeEnv();
+  NGraphRuntimeConfig::Reload();
+  const NGraphRuntimeConfig& defaults = NGraphRuntimeConfig::Get();
+  ASSERT_FALSE(defaults.use_prefetch);
+  ASSERT_FALSE(defaults.enable_serialize);
+  ASSERT_EQ(defaults.function_cache_item_depth, -1);
+  ASSERT_EQ(defaults.pipeline_wait_timeout_ms, 60000);
+  ASSERT_FALSE(defaults.log_tensor_copies);
+  ASSERT_EQ(NGraphLogMessage::MinNGraphVLogLevel(), 0);
+
+  SetEnvVariable("NGRAPH_TF_VLOG_LEVEL", "3");
+  SetEnvVariable("NGRAPH_TF_USE_PREFETCH", "1");
+  SetEnvVariable("NGRAPH_ENABLE_SERIALIZE", "1");
+  SetEnvVariable("NGRAPH_TF_FUNCTION_CACHE_ITEM_DEPTH", "4");
+  SetEnvVariable("NGRAPH_TF_PIPELINE_WAIT_TIMEOUT_MS", "-1");
+  SetEnvVariable("NGRAPH_TF_LOG_TENSOR_COPIES", "7");
+  // Not seen till reloaded
+  ASSERT_FALSE(NGraphRuntimeConfig::Get().use_prefetch);
+  ASSERT_EQ(NGraphLogMessage::MinNGraphVLogLevel(), 0);
+
+  NGraphRuntimeConfig::Reload();
+  const NGraphRuntimeConfig& config = NGraphRuntimeConfig::Get();
+  ASSERT_TRUE(config.use_prefetch);
+  ASSERT_TRUE(config.enable_serialize);
+  ASSERT_EQ(config.function_cache_item_depth, 4);
+  ASSERT_EQ(config.pipeline_wait_timeout_ms, -1);
+  ASSERT_TRUE(config.log_tensor_copies);
+  ASSERT_EQ(config.log_tensor_copies_graph_id, 7);
+  ASSERT_EQ(NGraphLogMessage::MinNGraphVLogLevel(), 3);
+  bool log_copies;
+  ASSERT_OK(IsNgraphTFLogTensorCopiesEnabled(7, log_copies));
+  ASSERT_TRUE(log_copies);
+  ASSERT_OK(IsNgraphTFLogTensorCopiesEnabled(8, log_copies));
+  ASSERT_FALSE(log_copies);
+  // The previous snapshot is still readable
+  ASSERT_FALSE(defaults.use_prefetch);
+  // A reload of the same settings keeps the snapshot
+  NGraphRuntimeConfig::Reload();
+  ASSERT_EQ(&NGraphRuntimeConfig::Get(), &config);
+
+  SetEnvVariable("NGRAPH_TF_LOG_TENSOR_COPIES", "all");
+  NGraphRuntimeConfig::Reload();
+  ASSERT_NOT_OK(IsNgraphTFLogTensorCopiesEnabled(7, log_copies));
+
+  UnsetRuntimeEnv();
+  RestoreEnv(env_map);
+  NGraphRuntimeConfig::Reload();
+}
+
+}  // namespace testing
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
@@ -0,0 +1,187 @@
+/*******************************************************************************
+ * Copyright 2019 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include "gtest/gtest.h"
+#include "test/test_utilities.h"
+
+#include "tensorflow/core/common_runtime/dma_helper.h"
+
+#include "ngraph_bridge/ngraph_shape_bucketing.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+TEST(ShapeBucketing, Initialize) {
+  NGraphShapeBucketing bucketing;
+  ASSERT_OK(bucketing.Initialize(""));
+  ASSERT_FALSE(bucketing.IsEnabled());
+
+  ASSERT_OK(bucketing.Initialize("0:8,1,4,2"));
+  ASSERT_TRUE(bucketing.IsEnabled());
+  ASSERT_EQ(bucketing.BucketSize(0, 1), 1);
+  ASSERT_EQ(bucketing.BucketSize(0, 3), 4);
+  ASSERT_EQ(bucketing.BucketSize(0, 5), 8);
+  // Larger than all the buckets, or a dimension that is not bucketed
+  ASSERT_EQ(bucketing.BucketSize(0, 9), 9);
+  ASSERT_EQ(bucketing.BucketSize(1, 3), 3);
+
+  ASSERT_OK(bucketing.Initialize("0:2,4;2:16"));
+  ASSERT_EQ(bucketing.BucketSize(2, 10), 16);
+
+  ASSERT_NOT_OK(bucketing.Initialize("0"));
+  ASSERT_NOT_OK(bucketing.Initialize("a:1,2"));
+  ASSERT_NOT_OK(bucketing.Initialize("0:1,x"));
+  ASSERT_NOT_OK(bucketing.Initialize("0:0"));
+}
+
+// Pads a [3,2] input to [4,2] and slices the output back
+TEST(ShapeBucketing, PadAndSlice) {
+  NGraphShapeBucketing bucketing;
+  ASSERT_OK(bucketing.Initialize("0:1,2,4,8"));
+
+  Tensor input(DT_FLOAT, TensorShape({3, 2}));
+  AssignInputValues<float>(input, {1, 2, 3, 4, 5, 6});
+  // A static input is never padded
+  Tensor static_input(DT_INT32, TensorShape({3}));
+  AssignInputValues<int>(static_input, {0, 1, 2});
+
+  vector<Tensor> padded_inputs;
+  BucketedDims bucketed_dims;
+  ASSERT_OK(bucketing.PadInputs({input, static_input}, {false, true},
+                                padded_inputs, bucketed_dims));
+  ASSERT_EQ(bucketed_dims.size(), 1);
+  ASSERT_EQ(bucketed_dims[0], make_pair<int64, int64>(3, 4));
+  ASSERT_EQ(padded_inputs[0].shape(), TensorShape({4, 2}));
+  ASSERT_EQ(padded_inputs[1].shape(), TensorShape({3}));
+  auto padded = padded_inputs[0].flat<float>();
+  vector<float> expected{1, 2, 3, 4, 5, 6, 0, 0};
+  for (int i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(padded(i), expected[i]);
+  }
+  ASSERT_EQ(bucketing.GetPaddedCallCount(), 1);
+  ASSERT_EQ(bucketing.GetInputBytes(), 6 * sizeof(float));
+  ASSERT_EQ(bucketing.GetPaddingBytes(), 2 * sizeof(float));
+
+  // Slice an output computed on the padded input
+  TensorShape unpadded_shape =
+      NGraphShapeBucketing::UnpaddedShape(TensorShape({4, 2}), bucketed_dims);
+  ASSERT_EQ(unpadded_shape, TensorShape({3, 2}));
+  Tensor output(DT_FLOAT, unpadded_shape);
+  NGraphShapeBucketing::CopyRegion(
+      static_cast<const char*>(DMAHelper::base(&padded_inputs[0])),
+      padded_inputs[0].shape(), static_cast<char*>(DMAHelper::base(&output)),
+      output.shape(), sizeof(float));
+  Compare<float>(output, input);
+
+  // Outputs that do not carry the bucketed dimension are left alone
+  ASSERT_EQ(
+      NGraphShapeBucketing::UnpaddedShape(TensorShape({4, 4}), BucketedDims()),
+      TensorShape({4, 4}));
+}
+
+// Builds x . w for x of shape [batch, 4] and w of shape [4, 4]
+static shared_ptr<ngraph::Function> MakeMatMul(size_t batch) {
+  auto x = make_shared<ngraph::op::Parameter>(ngraph::element::f32,
+                                              ngraph::Shape{batch, 4});
+  auto w = make_shared<ngraph::op::Parameter>(ngraph::element::f32,
+                                              ngraph::Shape{4, 4});
+  auto dot = make_shared<ngraph::op::Dot>(x, w);
+  return make_shared<ngraph::Function>(ngraph::NodeVector{dot},
+                                       ngraph::ParameterVector{x, w});
+}
+
+// Only the output dimension that follows the padded one is sliced, even if
+// another one has the size of the bucket
+TEST(ShapeBucketing, OutputDims) {
+  vector<vector<int>> output_dims;
+  ASSERT_OK(NGraphShapeBucketing::FindOutputDims(MakeMatMul(4), MakeMatMul(5),
+                                                 4, output_dims));
+  ASSERT_EQ(output_dims, vector<vector<int>>{{0}});
+
+  BucketedDims output_bucketed_dims{{0, make_pair<int64, int64>(3, 4)}};
+  ASSERT_EQ(NGraphShapeBucketing::UnpaddedShape(TensorShape({4, 4}),
+                                                output_bucketed_dims),
+            TensorShape({3, 4}));
+}
+
+// Builds the sum over the batch of x of shape [batch, 2]
+static shared_ptr<ngraph::Function> MakeBatchSum(size_t batch) {
+  auto x = make_shared<ngraph::op::Parameter>(ngraph::element::f32,
+                                              ngraph::Shape{batch, 2});
+  auto sum = make_shared<ngraph::op::Sum>(x, ngraph::AxisSet{0});
+  return make_shared<ngraph::Function>(ngraph::NodeVector{sum},
+                                       ngraph::ParameterVector{x});
+}
+
+// A reduction across the padded dimension would include the padding
+TEST(ShapeBucketing, ReductionRefused) {
+  vector<vector<int>> output_dims;
+  Status status = NGraphShapeBucketing::FindOutputDims(
+      MakeBatchSum(4), MakeBatchSum(5), 4, output_dims);
+  ASSERT_TRUE(errors::IsUnimplemented(status)) << status;
+}
+
+// Bucketing an inner dimension
+TEST(ShapeBucketing, InnerDimension) {
+  NGraphShapeBucketing bucketing;
+  ASSERT_OK(bucketing.Initialize("1:4"));
+
+  Tensor input(DT_INT32, TensorShape({2, 3}));
+  AssignInputValues<int>(input, {1, 2, 3, 4, 5, 6});
+  vector<Tensor> padded_inputs;
+  BucketedDims bucketed_dims;
+  ASSERT_OK(
+      bucketing.PadInputs({input}, {false}, padded_inputs, bucketed_dims));
+  ASSERT_EQ(padded_inputs[0].shape(), TensorShape({2, 4}));
+  auto padded = padded_inputs[0].flat<int>();
+  vector<int> expected{1, 2, 3, 0, 4, 5, 6, 0};
+  for (int i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(padded(i), expected[i]);
+  }
+}
+
+// Inputs that disagree on the size of the dimension are not padded
+TEST(ShapeBucketing, MismatchedSizes) {
+  NGraphShapeBucketing bucketing;
+  ASSERT_OK(bucketing.Initialize("0:4"));
+
+  Tensor input0(DT_FLOAT, TensorShape({3, 2}));
+  Tensor input1(DT_FLOAT, TensorShape({2, 2}));
+  vector<Tensor> padded_inputs;
+  BucketedDims bucketed_dims;
+  ASSERT_OK(bucketing.PadInputs({input0, input1}, {false, false},
+                                padded_inputs, bucketed_dims));
+  ASSERT_TRUE(bucketed_dims.empty());
+  ASSERT_EQ(padded_inputs[0].shape(), TensorShape({3, 2}));
+  ASSERT_EQ(padded_inputs[1].shape(), TensorShape({2, 2}));
+  ASSERT_EQ(bucketing.GetPaddedCallCount(), 0);
+}
+
+TEST(ShapeBucketing, Counters) {
+  NGraphShapeBucketing bucketing;
+  ASSERT_OK(bucketing.Initialize("0:4"));
+  bucketing.RecordLookup(false, "cluster");
+  bucketing.RecordLookup(true, "cluster");
+  bucketing.RecordLookup(true, "cluster");
+  ASSERT_EQ(bucketing.GetLookupCount(), 3);
+  ASSERT_EQ(bucketing.GetCacheHitCount(), 2);
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow